@@ -0,0 +1,39 @@
+# - Find libdeflate
+# Find the native LIBDEFLATE includes and library
+#
+#  LIBDEFLATE_INCLUDE_DIR - where to find libdeflate.h, etc.
+#  LIBDEFLATE_LIBRARIES   - List of libraries when using libdeflate.
+#  LIBDEFLATE_FOUND       - True if libdeflate found.
+
+
+IF (LIBDEFLATE_INCLUDE_DIR)
+  # Already in cache, be silent
+  SET(LIBDEFLATE_FIND_QUIETLY TRUE)
+ENDIF (LIBDEFLATE_INCLUDE_DIR)
+
+FIND_PATH(LIBDEFLATE_INCLUDE_DIR libdeflate.h)
+
+SET(LIBDEFLATE_LIBRARY_NAMES_RELEASE ${LIBDEFLATE_LIBRARY_NAMES_RELEASE} ${LIBDEFLATE_LIBRARY_NAMES} deflate)
+FIND_LIBRARY(LIBDEFLATE_LIBRARY_RELEASE NAMES ${LIBDEFLATE_LIBRARY_NAMES_RELEASE} )
+
+# Find a debug library if one exists and use that for debug builds.
+# This really only does anything for win32, but does no harm on other
+# platforms.
+SET(LIBDEFLATE_LIBRARY_NAMES_DEBUG ${LIBDEFLATE_LIBRARY_NAMES_DEBUG} deflated)
+FIND_LIBRARY(LIBDEFLATE_LIBRARY_DEBUG NAMES ${LIBDEFLATE_LIBRARY_NAMES_DEBUG})
+
+INCLUDE(LibraryDebugAndRelease)
+SET_LIBRARY_FROM_DEBUG_AND_RELEASE(LIBDEFLATE)
+
+# handle the QUIETLY and REQUIRED arguments and set LIBDEFLATE_FOUND to TRUE if 
+# all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LIBDEFLATE DEFAULT_MSG LIBDEFLATE_LIBRARY LIBDEFLATE_INCLUDE_DIR)
+
+IF(LIBDEFLATE_FOUND)
+  SET( LIBDEFLATE_LIBRARIES ${LIBDEFLATE_LIBRARY} )
+ELSE(LIBDEFLATE_FOUND)
+  SET( LIBDEFLATE_LIBRARIES )
+ENDIF(LIBDEFLATE_FOUND)
+
+MARK_AS_ADVANCED( LIBDEFLATE_LIBRARY LIBDEFLATE_INCLUDE_DIR )
@@ -3,72 +3,351 @@
 #include <ostream>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <stdexcept>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <gmpxx.h>
 
 // www.cs.uvic.ca/~ruskey/Publications/RankPerm/RankPerm.html
 
-template<class Alpha>
-static void unrank1(std::vector<Alpha> &v, mpz_class r)
+// permutations small enough for their rank to fit a machine word are
+// ranked using plain integer arithmetic, larger ones fall back to gmp.
+// almost all real world dictionaries take the word path.
+template<class Word>
+struct perm_word;
+
+template<>
+struct perm_word<uint64_t>
 {
-    std::unordered_map<size_t, Alpha> trans_map;
-    std::vector<size_t> int_vect;
-    for (size_t i = 0; i < v.size(); i++)
+    // 20! < 2^64 < 21!
+    static constexpr size_t max_size = 20;
+};
+
+#ifdef __SIZEOF_INT128__
+template<>
+struct perm_word<unsigned __int128>
+{
+    // 34! < 2^128 < 35!
+    static constexpr size_t max_size = 34;
+};
+
+using perm_wide_word_t = unsigned __int128;
+#else
+using perm_wide_word_t = uint64_t;
+#endif
+
+static constexpr size_t perm_word_max_size = perm_word<perm_wide_word_t>::max_size;
+
+struct perm_fac_table
+{
+    constexpr perm_fac_table()
+        : fac()
     {
-        trans_map[i] = v[i];
-        int_vect.push_back(i);
+        fac[0] = 1;
+        for (size_t i = 1; i <= perm_word_max_size; i++)
+            fac[i] = fac[i - 1] * i;
     }
 
-    unrank1(int_vect, r);
-    for (size_t i = 0; i < v.size(); i++)
-        v[i] = trans_map[int_vect[i]];
+    perm_wide_word_t fac[perm_word_max_size + 1];
+};
+
+static constexpr perm_fac_table perm_fac;
+
+template<class Word>
+static inline size_t word_bit_length(Word word)
+{
+    size_t length = 0;
+    for (; word >> 32 >> 32; word = word >> 32 >> 32)
+        length += 64;
+
+    uint64_t low = static_cast<uint64_t>(word);
+    return low ? length + 64 - __builtin_clzll(low) : length;
 }
 
-template<>
-void unrank1(std::vector<size_t> &v, mpz_class r)
+// shifts are split in two so that they are still defined when
+// Word is a 64 bit integer
+template<class Word>
+static inline bool mpz_get_word(const mpz_class &num, Word &word)
+{
+    if (mpz_sizeinbase(num.get_mpz_t(), 2) > sizeof(Word) * 8)
+        return false;
+
+    uint64_t limbs[sizeof(Word) / sizeof(uint64_t)] = {};
+    mpz_export(limbs, nullptr, -1, sizeof(uint64_t), 0, 0, num.get_mpz_t());
+
+    word = 0;
+    for (size_t i = sizeof(Word) / sizeof(uint64_t); i--;)
+        word = (word << 32 << 32) | limbs[i];
+    return true;
+}
+
+template<class Word>
+static inline mpz_class mpz_from_word(Word word)
 {
+    uint64_t limbs[sizeof(Word) / sizeof(uint64_t)];
+    for (size_t i = 0; i < sizeof(Word) / sizeof(uint64_t); i++, word = word >> 32 >> 32)
+        limbs[i] = static_cast<uint64_t>(word);
+
+    mpz_class res;
+    mpz_import(res.get_mpz_t(), sizeof(Word) / sizeof(uint64_t), -1, sizeof(uint64_t), 0, 0, limbs);
+    return res;
+}
+
+// swapping the elements directly yields the same result as
+// unranking indices and translating them back
+template<class Word, class Alpha>
+static void unrank1_word(std::vector<Alpha> &v, Word r)
+{
+    assert(v.size() <= perm_word<Word>::max_size);
     for (size_t n = v.size(); n; n--)
     {
-        std::swap(v[n-1], v[mpz_class(r % n).get_ui()]);
+        std::swap(v[n-1], v[static_cast<size_t>(r % n)]);
         r /= n;
     }
 }
 
-static mpz_class rank1(size_t n, std::vector<size_t> &v, std::vector<size_t> &v_i)
+// a permutation rank is a mixed radix number: digits[n - 1] < n is
+// the digit of radix n, and the largest radix is the least significant:
+//   r = digits[N-1] + N * (digits[N-2] + (N-1) * (... + 2 * digits[1]))
+//
+// large numbers are converted with a product tree: runs of digits whose
+// radix product fits a machine word form the leaves, and pairs of
+// adjacent nodes are merged level by level, so the cost is dominated by
+// a few balanced multiplications instead of one bignum operation per
+// digit. both directions are iterative, as dictionaries can have tens
+// of thousands of keys.
+
+// splits radices size..1 into leaves, least significant first.
+// each leaf covers radices leaf_high[i] down to leaf_high[i + 1] + 1.
+static inline void mixed_radix_leaves(size_t size, std::vector<size_t> &leaf_high, std::vector<uint64_t> &leaf_product)
 {
-    if (n == 1)
-        return 0;
+    for (size_t n = size; n > 0;)
+    {
+        uint64_t product = 1;
+        leaf_high.push_back(n);
+        for (; n > 0 && product <= UINT64_MAX / n; n--)
+            product *= n;
+        leaf_product.push_back(product);
+    }
+    leaf_high.push_back(0);
+}
+
+static inline mpz_class mixed_radix_compose(const size_t *digits, size_t size)
+{
+    std::vector<size_t> leaf_high;
+    std::vector<uint64_t> leaf_product;
+    mixed_radix_leaves(size, leaf_high, leaf_product);
+
+    std::vector<mpz_class> value(leaf_product.size());
+    std::vector<mpz_class> product(leaf_product.size());
+    for (size_t i = 0; i < leaf_product.size(); i++)
+    {
+        uint64_t leaf_value = 0;
+        for (size_t n = leaf_high[i + 1] + 1; n <= leaf_high[i]; n++)
+            leaf_value = leaf_value * n + digits[n - 1];
+        value[i] = mpz_from_word(leaf_value);
+        product[i] = mpz_from_word(leaf_product[i]);
+    }
+
+    // merge pairs in place until a single node remains.
+    // the last node of a level is never a low half, so its
+    // product is not needed and isn't computed
+    for (size_t count = value.size(); count > 1; count = (count + 1) / 2)
+    {
+        for (size_t i = 0; i + 1 < count; i += 2)
+        {
+            mpz_addmul(value[i].get_mpz_t(), product[i].get_mpz_t(), value[i + 1].get_mpz_t());
+            if (i + 2 < count)
+                mpz_mul(product[i].get_mpz_t(), product[i].get_mpz_t(), product[i + 1].get_mpz_t());
+            std::swap(value[i / 2], value[i]);
+            std::swap(product[i / 2], product[i]);
+        }
 
-    size_t s = v[n - 1];
-    std::swap(v[n - 1], v[v_i[n - 1]]);
-    std::swap(v_i[s], v_i[n - 1]);
-    return s + n * rank1(n - 1, v, v_i);
+        if (count % 2)
+        {
+            std::swap(value[count / 2], value[count - 1]);
+            std::swap(product[count / 2], product[count - 1]);
+        }
+    }
+
+    return value.empty() ? mpz_class(0) : value[0];
 }
 
-static mpz_class rank1(std::vector<size_t> &v)
+static inline void mixed_radix_decompose(const mpz_class &r, size_t size, size_t *digits)
 {
-    std::vector<size_t> v_i(v.size());
-    for (size_t i = 0; i < v.size(); i++)
-        v_i[v[i]] = i;
-    return rank1(v.size(), v, v_i);
+    std::vector<size_t> leaf_high;
+    std::vector<uint64_t> leaf_product;
+    mixed_radix_leaves(size, leaf_high, leaf_product);
+    if (leaf_product.empty())
+        return;
+
+    // products[level][i] is the radix product of a node. as when
+    // composing, the product of the last node of a level is unused
+    std::vector<std::vector<mpz_class>> products(1);
+    for (uint64_t leaf: leaf_product)
+        products[0].push_back(mpz_from_word(leaf));
+
+    while (products.back().size() > 1)
+    {
+        const auto &below = products.back();
+        std::vector<mpz_class> level((below.size() + 1) / 2);
+        for (size_t i = 0; i + 1 < below.size(); i += 2)
+            if (i + 2 < below.size())
+                mpz_mul(level[i / 2].get_mpz_t(), below[i].get_mpz_t(), below[i + 1].get_mpz_t());
+        products.push_back(std::move(level));
+    }
+
+    // split values top down: a node holding x splits into
+    // x % low_product and x / low_product
+    std::vector<mpz_class> value(1, r);
+    for (size_t level = products.size() - 1; level--;)
+    {
+        const auto &below = products[level];
+        std::vector<mpz_class> split(below.size());
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (2 * i + 1 < below.size())
+                mpz_tdiv_qr(split[2 * i + 1].get_mpz_t(), split[2 * i].get_mpz_t(),
+                            value[i].get_mpz_t(), below[2 * i].get_mpz_t());
+            else
+                std::swap(split[2 * i], value[i]);
+        }
+        value.swap(split);
+    }
+
+    for (size_t i = 0; i < leaf_product.size(); i++)
+    {
+        // only the most significant leaf can overflow, when r >= size!
+        uint64_t leaf_value = 0;
+        if (!mpz_get_word(value[i], leaf_value))
+            mpz_get_word(mpz_class(value[i] % products[0][i]), leaf_value);
+
+        for (size_t n = leaf_high[i]; n > leaf_high[i + 1]; n--)
+        {
+            digits[n - 1] = leaf_value % n;
+            leaf_value /= n;
+        }
+    }
 }
 
+template<class Alpha>
+static void unrank1_mpz(std::vector<Alpha> &v, const mpz_class &r)
+{
+    std::vector<size_t> digits(v.size());
+    mixed_radix_decompose(r, v.size(), digits.data());
+
+    for (size_t n = v.size(); n; n--)
+        std::swap(v[n-1], v[digits[n - 1]]);
+}
 
 template<class Alpha>
-static mpz_class rank1(std::vector<Alpha> &id, std::vector<Alpha> &v)
+static void unrank1(std::vector<Alpha> &v, uint64_t r)
 {
-    std::unordered_map<Alpha, size_t> trans_map;
-    for (size_t i = 0; i < v.size(); i++)
-        trans_map[id[i]] = i;
+    if (v.size() <= perm_word<uint64_t>::max_size)
+        unrank1_word(v, r);
+    else
+        unrank1_mpz(v, mpz_from_word(r));
+}
+
+template<class Alpha>
+static void unrank1(std::vector<Alpha> &v, const mpz_class &r)
+{
+    uint64_t word;
+    if (v.size() <= perm_word<uint64_t>::max_size && mpz_get_word(r, word))
+        return unrank1_word(v, word);
+
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 wide_word;
+    if (v.size() <= perm_word<unsigned __int128>::max_size && mpz_get_word(r, wide_word))
+        return unrank1_word(v, wide_word);
+#endif
+
+    unrank1_mpz(v, r);
+}
 
-    std::vector<size_t> int_vect;
+// id must be sorted, which lets positions be found by binary
+// search instead of a translation table. when keys are repeated,
+// the last position wins.
+template<class Alpha>
+static inline void rank1_positions(const std::vector<Alpha> &id, const std::vector<Alpha> &v, size_t *perm)
+{
     for (size_t i = 0; i < v.size(); i++)
-        int_vect.push_back(trans_map[v[i]]);
-    return rank1(int_vect);
+    {
+        auto it = std::upper_bound(id.begin(), id.begin() + v.size(), v[i]);
+        perm[i] = it == id.begin() ? 0 : it - id.begin() - 1;
+    }
+}
+
+// computes the mixed radix digits of the rank of perm.
+// perm_inv must be zero initialized. both arrays are clobbered.
+static inline void rank1_digits(size_t size, size_t *perm, size_t *perm_inv, size_t *digits)
+{
+    for (size_t i = 0; i < size; i++)
+        perm_inv[perm[i]] = i;
+
+    for (size_t n = size; n > 1; n--)
+    {
+        size_t s = perm[n - 1];
+        digits[n - 1] = s;
+        std::swap(perm[n - 1], perm[perm_inv[n - 1]]);
+        std::swap(perm_inv[s], perm_inv[n - 1]);
+    }
+
+    if (size)
+        digits[0] = 0;
+}
+
+template<class Alpha>
+static mpz_class rank1_mpz(const std::vector<Alpha> &id, const std::vector<Alpha> &v)
+{
+    const size_t size = v.size();
+    std::vector<size_t> perm(size);
+    std::vector<size_t> perm_inv(size);
+    std::vector<size_t> digits(size);
+
+    rank1_positions(id, v, perm.data());
+    rank1_digits(size, perm.data(), perm_inv.data(), digits.data());
+    return mixed_radix_compose(digits.data(), size);
+}
+
+// same as rank1_mpz, using stack arrays and machine words
+template<class Word, class Alpha>
+static Word rank1_word(const std::vector<Alpha> &id, const std::vector<Alpha> &v)
+{
+    constexpr size_t max_size = perm_word<Word>::max_size;
+    assert(v.size() <= max_size);
+
+    size_t perm[max_size];
+    size_t perm_inv[max_size] = {};
+    size_t digits[max_size];
+    const size_t size = v.size();
+
+    rank1_positions(id, v, perm);
+    rank1_digits(size, perm, perm_inv, digits);
+
+    Word r = 0;
+    for (size_t n = 2; n <= size; n++)
+        r = digits[n - 1] + n * r;
+    return r;
+}
+
+template<class Alpha>
+static mpz_class rank1(const std::vector<Alpha> &id, const std::vector<Alpha> &v)
+{
+    if (v.size() <= perm_word<uint64_t>::max_size)
+        return mpz_from_word(rank1_word<uint64_t>(id, v));
+
+#ifdef __SIZEOF_INT128__
+    if (v.size() <= perm_word<unsigned __int128>::max_size)
+        return mpz_from_word(rank1_word<unsigned __int128>(id, v));
+#endif
+
+    return rank1_mpz(id, v);
 }
 
 using map_t = std::map<std::string, int>;
@@ -86,85 +365,396 @@ static mpz_class mpz_class_fac(size_t n)
     return res;
 }
 
+// a framed payload starts with a header holding a magic, the payload
+// length and its crc32, all little endian. it lets the reader stop as
+// soon as the payload is complete, and check it wasn't damaged.
+static const char payload_frame_magic[4] = {'p', 'd', 'I', 'D'};
+static const size_t payload_frame_header_size = 12;
+
+static inline uint32_t payload_crc32(uint32_t crc, uint8_t byte)
+{
+    crc = ~crc ^ byte;
+    for (int i = 0; i < 8; i++)
+        crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    return ~crc;
+}
+
+static inline std::string payload_frame(const std::string &payload)
+{
+    uint32_t crc = 0;
+    for (char c: payload)
+        crc = payload_crc32(crc, static_cast<uint8_t>(c));
+
+    // the header only has room for a 32 bit length
+    if (payload.size() > std::numeric_limits<uint32_t>::max())
+        throw std::length_error("payload_frame: the payload is longer than 4 GiB");
+
+    uint32_t length = static_cast<uint32_t>(payload.size());
+    std::string frame(payload_frame_magic, sizeof(payload_frame_magic));
+    for (int i = 0; i < 4; i++)
+        frame.push_back(static_cast<char>(length >> (i * 8)));
+    for (int i = 0; i < 4; i++)
+        frame.push_back(static_cast<char>(crc >> (i * 8)));
+    return frame + payload;
+}
+
+// payload bits are read least significant bit of each byte first. they
+// come from a caller owned buffer, or from a stream read in blocks, and
+// are moved up to a whole machine word at a time.
 struct bit_istream
 {
     bit_istream(std::istream *stream)
         : bit_size(0)
-        , cur_bit(8)
-        , data(stream ? 0 : EOF)
+        , bytes(nullptr)
+        , byte_count(0)
+        , bit_pos(0)
+        , exhausted(!stream)
         , stream(stream)
     {}
 
+    // the bytes are not copied, and must outlive the stream
+    bit_istream(const char *bytes, size_t size)
+        : bit_size(0)
+        , bytes(reinterpret_cast<const uint8_t *>(bytes))
+        , byte_count(size)
+        , bit_pos(0)
+        , exhausted(false)
+        , stream(nullptr)
+    {}
+
+    // whether a read went past the end of the payload
     bool eof()
     {
-        return data == EOF;
+        return exhausted;
     }
 
     int next()
     {
-        if (data == EOF)
+        if (!available() && !fill())
+        {
+            exhausted = true;
             return EOF;
+        }
+        return static_cast<int>(read_word(1));
+    }
 
-        if (cur_bit == 8)
+    // reads up to 64 bits, the first one being the least significant.
+    // bits past the end of the payload are cleared.
+    uint64_t read_word(size_t bits)
+    {
+        assert(bits <= 64);
+        if (available() < bits)
+            fill();
+
+        const size_t count = std::min(bits, available());
+        if (count < bits)
+            exhausted = true;
+        if (!count)
+            return 0;
+
+        // the bits span at most 9 bytes, the last one
+        // only being needed for unaligned reads
+        const size_t first = bit_pos / 8;
+        const size_t shift = bit_pos % 8;
+        const size_t load = std::min<size_t>(8, byte_count - first);
+        uint64_t word = 0;
+        for (size_t i = 0; i < load; i++)
+            word |= static_cast<uint64_t>(bytes[first + i]) << (i * 8);
+        word >>= shift;
+        if (count > 64 - shift)
+            word |= static_cast<uint64_t>(bytes[first + 8]) << (64 - shift);
+        if (count < 64)
+            word &= (static_cast<uint64_t>(1) << count) - 1;
+
+        bit_pos += count;
+        return word;
+    }
+
+    // reads bits into (bits + 7) / 8 bytes, in the order a bit_istream
+    // over these bytes reads them back
+    void read_bytes(char *out, size_t bits)
+    {
+        // while byte aligned, whole bytes are copied as they are
+        while (bit_pos % 8 == 0 && bits >= 8 && (available() || fill()))
         {
-            if ((data = stream->get()) == EOF)
-                return EOF;
-            cur_bit = 0;
+            const size_t count = std::min(bits / 8, available() / 8);
+            memcpy(out, bytes + bit_pos / 8, count);
+            out += count;
+            bits -= count * 8;
+            bit_pos += count * 8;
         }
 
-        return (data >> cur_bit++) & 1;
+        for (; bits; out += 8)
+        {
+            const size_t count = std::min<size_t>(bits, 64);
+            const uint64_t word = read_word(count);
+            for (size_t i = 0; i < (count + 7) / 8; i++)
+                out[i] = static_cast<char>(word >> (i * 8));
+            bits -= count;
+        }
     }
 
     size_t bit_size;
 
 private:
-    size_t cur_bit;
-    int data;
+    size_t available() const
+    {
+        return byte_count * 8 - bit_pos;
+    }
+
+    // reads the next block of the stream, keeping the bytes not
+    // consumed yet. returns whether there are more bits to read.
+    bool fill()
+    {
+        if (!stream)
+            return false;
+
+        // blocks start small, as some payloads are only a few bytes
+        if (buffer.size() < stream_block_size)
+            buffer.resize(std::max<size_t>(256, buffer.size() * 2));
+
+        const size_t first = bit_pos / 8;
+        const size_t keep = byte_count - first;
+        memmove(buffer.data(), buffer.data() + first, keep);
+        bit_pos -= first * 8;
+
+        stream->read(buffer.data() + keep, buffer.size() - keep);
+        const size_t count = static_cast<size_t>(stream->gcount());
+        if (keep + count < buffer.size())
+            stream = nullptr;
+
+        bytes = reinterpret_cast<const uint8_t *>(buffer.data());
+        byte_count = keep + count;
+        return count != 0;
+    }
+
+    static const size_t stream_block_size = 64 * 1024;
+
+    const uint8_t *bytes;
+    size_t byte_count;
+    size_t bit_pos;
+    bool exhausted;
     std::istream *stream;
+    std::vector<char> buffer;
 };
 
 struct bit_ostream
 {
-    bit_ostream(std::ostream &stream)
+    enum frame_state
+    {
+        frame_none,         // the payload isn't framed
+        frame_header,       // the header wasn't fully decoded yet
+        frame_payload,      // some of the payload is still missing
+        frame_complete,     // the payload was decoded and its crc matches
+        frame_bad_magic,    // the header isn't a frame header
+        frame_bad_checksum, // the payload was decoded, but its crc doesn't match
+    };
+
+    bit_ostream(std::ostream &stream, bool framed = false)
         : cur_bit(0)
         , data(0)
+        , watermark(std::numeric_limits<long>::min())
+        , discard_offset(std::numeric_limits<long>::min())
+        , late(false)
+        , state(framed ? frame_header : frame_none)
+        , frame_length(0)
+        , frame_crc(0)
+        , crc(0)
         , stream(stream)
     {}
 
+    void push(long offset, mpz_class &&number, size_t size)
+    {
+        if (offset < discard_offset)
+            return;
+
+        // the bits of this dictionary should have been emitted already
+        if (offset < watermark)
+        {
+            late = true;
+            return;
+        }
+        state_map.emplace(offset, std::make_pair(number, size));
+    }
+
+    // the caller promises no dictionary starting before offset will be
+    // pushed anymore: everything below can be emitted right away, so that
+    // only the out of order window stays in memory.
+    void advance(long offset)
+    {
+        if (offset <= watermark)
+            return;
+
+        watermark = offset;
+        auto end = state_map.lower_bound(offset);
+        for (auto it = state_map.begin(); it != end; ++it)
+            emit(it->second);
+        state_map.erase(state_map.begin(), end);
+    }
+
+    // dictionaries starting before offset carry no data, such as the
+    // ones of the revisions an incremental update leaves untouched
+    void discard_below(long offset)
+    {
+        discard_offset = offset;
+        state_map.erase(state_map.begin(), state_map.lower_bound(offset));
+    }
+
+    void flush()
+    {
+        for (auto &item: state_map)
+            emit(item.second);
+        state_map.clear();
+    }
+
+    // moves the ranks pushed to another stream, such as the
+    // one of a decoding thread, into this one
+    void merge(bit_ostream &other)
+    {
+        for (auto &item: other.state_map)
+            push(item.first, std::move(item.second.first), item.second.second);
+        other.state_map.clear();
+        late |= other.late;
+    }
+
+    // whether some dictionary was pushed after its offset was advanced past
+    bool out_of_order() const
+    {
+        return late;
+    }
+
+    frame_state frame() const
+    {
+        return state;
+    }
+
+    // whether a framed payload needs no more bits, either because it is
+    // complete or because it turned out to be broken
+    bool done() const
+    {
+        return state != frame_none && state != frame_header && state != frame_payload;
+    }
+
+private:
     void push_bit(bool bit)
     {
         data |= (uint8_t)bit << cur_bit++;
         if (cur_bit == 8)
         {
             cur_bit = 0;
-            stream.put(data);
+            put(data);
             data = 0;
         }
     }
 
-    void push(long offset, mpz_class &&number, size_t size)
+    // pushes the first size bits of bytes, least significant first
+    void push_bits(const uint8_t *bytes, size_t size)
     {
-        state_map.emplace(offset, std::make_pair(number, size));
+        const size_t full = size / 8;
+        if (!cur_bit)
+        {
+            for (size_t i = 0; i < full; i++)
+                put(bytes[i]);
+        }
+        else
+        {
+            for (size_t i = 0; i < full; i++)
+            {
+                put(static_cast<uint8_t>(data | bytes[i] << cur_bit));
+                data = static_cast<uint8_t>(bytes[i] >> (8 - cur_bit));
+            }
+        }
+
+        for (size_t i = full * 8; i < size; i++)
+            push_bit((bytes[i / 8] >> (i % 8)) & 1);
     }
 
-    void flush()
+    // bytes are gathered, and handed to the stream once per dictionary
+    void put(uint8_t byte)
     {
-        for (auto &item: state_map)
+        switch (state)
         {
-            auto &value = item.second;
-            auto &number = value.first;
-            auto size = value.second;
-            for (size_t i = 0; i < size; i++)
-                push_bit(mpz_tstbit(number.get_mpz_t(), i));
+        case frame_none:
+            pending.push_back(static_cast<char>(byte));
+            break;
+        case frame_header:
+            header.push_back(static_cast<char>(byte));
+            if (header.size() < payload_frame_header_size)
+                break;
+            if (header.compare(0, sizeof(payload_frame_magic), payload_frame_magic, sizeof(payload_frame_magic)))
+            {
+                state = frame_bad_magic;
+                break;
+            }
+            for (int i = 0; i < 4; i++)
+            {
+                frame_length |= static_cast<uint32_t>(static_cast<uint8_t>(header[4 + i])) << (i * 8);
+                frame_crc |= static_cast<uint32_t>(static_cast<uint8_t>(header[8 + i])) << (i * 8);
+            }
+            state = frame_payload;
+            if (!frame_length)
+                finish_frame();
+            break;
+        case frame_payload:
+            pending.push_back(static_cast<char>(byte));
+            crc = payload_crc32(crc, byte);
+            if (!--frame_length)
+                finish_frame();
+            break;
+        case frame_complete:
+        case frame_bad_magic:
+        case frame_bad_checksum:
+            // trailing bits past the end of the frame are garbage
+            break;
         }
     }
 
-private:
-    // as the file isn't read linearly, data is inserted in a global map
-    // and gets reconstructed at the end.
+    void finish_frame()
+    {
+        state = crc == frame_crc ? frame_complete : frame_bad_checksum;
+    }
+
+    void emit(const std::pair<mpz_class, size_t> &value)
+    {
+        if (done())
+            return;
+
+        auto &number = value.first;
+        auto size = value.second;
+
+        // the number may need more bits than it carries, the
+        // extra ones are dropped. missing ones are cleared.
+        size_t count = 0;
+        scratch.assign((size + 7) / 8, 0);
+        if ((mpz_sizeinbase(number.get_mpz_t(), 2) + 7) / 8 <= scratch.size())
+            mpz_export(scratch.data(), &count, -1, 1, 0, 0, number.get_mpz_t());
+        else
+        {
+            mpz_class low;
+            mpz_tdiv_r_2exp(low.get_mpz_t(), number.get_mpz_t(), size);
+            mpz_export(scratch.data(), &count, -1, 1, 0, 0, low.get_mpz_t());
+        }
+        push_bits(scratch.data(), size);
+
+        stream.write(pending.data(), pending.size());
+        pending.clear();
+    }
+
+    // as the file isn't read linearly, data is inserted in a map and
+    // gets reconstructed once all the lower offsets were read.
     std::map<long, std::pair<mpz_class, size_t>> state_map;
+    std::vector<uint8_t> scratch;
+    std::string pending;
     size_t cur_bit;
     uint8_t data;
+    long watermark;
+    long discard_offset;
+    bool late;
+    frame_state state;
+    std::string header;
+    uint32_t frame_length;
+    uint32_t frame_crc;
+    uint32_t crc;
     std::ostream &stream;
 };
 
@@ -186,6 +776,9 @@ static inline size_t perm_available_bits(const mpz_class &permutation_count)
 
 static inline size_t size_available_bits(size_t size)
 {
+    if (size <= perm_word_max_size)
+        return word_bit_length(perm_fac.fac[size]) - 1;
+
     // count permutations
     auto permutation_count = mpz_class_fac(size);
 
@@ -203,17 +796,26 @@ static inline std::vector<const map_t::value_type*> map_reference(map_t map)
     return sorted_map_vect;
 }
 
+static inline uint64_t bit_istream_pull_word(bit_istream &bit_istream, size_t available_bits)
+{
+    return bit_istream.read_word(available_bits);
+}
+
+// pulls bits the way bit_istream reads them, so that a bit_istream over
+// the returned bytes reads them back. Bits past the end of the stream,
+// which the pull functions leave cleared, are cleared as well.
+static inline std::string bit_istream_pull_bytes(bit_istream &bit_istream, size_t available_bits)
+{
+    std::string bytes((available_bits + 7) / 8, '\0');
+    bit_istream.read_bytes(&bytes[0], available_bits);
+    return bytes;
+}
+
 static inline mpz_class bit_istream_pull_mpz(bit_istream &bit_istream, size_t available_bits)
 {
-    mpz_class permutation_id = 0;
-    for (size_t i = 0; i < available_bits; i++)
-    {
-        int cur_bit = bit_istream.next();
-        if (cur_bit == -1)
-            break;
+    const std::string bytes = bit_istream_pull_bytes(bit_istream, available_bits);
 
-        if (cur_bit)
-            mpz_setbit(permutation_id.get_mpz_t(), i);
-    }
+    mpz_class permutation_id;
+    mpz_import(permutation_id.get_mpz_t(), bytes.size(), -1, 1, 0, 0, bytes.data());
     return permutation_id;
 }
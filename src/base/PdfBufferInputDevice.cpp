@@ -0,0 +1,102 @@
+#include "PdfBufferInputDevice.h"
+
+#include "PdfDefinesPrivate.h"
+#include "PdfOutputDevice.h"
+
+#include <cstring>
+
+namespace PoDoFo {
+
+PdfBufferInputDevice::PdfBufferInputDevice( const char* pBuffer, size_t lLen )
+    : m_pBuffer( pBuffer ), m_lLen( lLen ), m_lPos( 0 ), m_bEof( false )
+{
+    if( !pBuffer )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    this->Seek( 0 );
+}
+
+PdfBufferInputDevice::~PdfBufferInputDevice()
+{
+}
+
+std::streamoff PdfBufferInputDevice::Tell() const
+{
+    return static_cast<std::streamoff>(m_lPos - this->GetReadBufferLength());
+}
+
+bool PdfBufferInputDevice::Underflow() const
+{
+    // everything left was in the read buffer
+    m_bEof = true;
+    return false;
+}
+
+void PdfBufferInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
+{
+    std::streamoff lBase;
+    if( dir == std::ios_base::beg )
+        lBase = 0;
+    else if( dir == std::ios_base::cur )
+        lBase = this->Tell();
+    else // if( dir == std::ios_base::end )
+        lBase = static_cast<std::streamoff>(m_lLen);
+
+    if( lBase + off < 0 )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek to given position in the buffer" );
+    }
+
+    // as with files, seeking past the end is allowed, reading there is not
+    const size_t lPos = static_cast<size_t>(lBase + off);
+    m_lPos = PDF_MAX( lPos, m_lLen );
+    this->SetStableBuffer( m_pBuffer, m_pBuffer + m_lLen );
+    this->SetReadBuffer( m_pBuffer + PDF_MIN( lPos, m_lLen ), m_pBuffer + m_lLen );
+    m_bEof = false;
+}
+
+std::streamoff PdfBufferInputDevice::Read( char* pBuffer, std::streamsize lLen )
+{
+    const std::streamsize lRead = this->ReadFromBuffer( pBuffer, lLen );
+    if( lRead < lLen )
+        m_bEof = true;
+
+    return static_cast<std::streamoff>(lRead);
+}
+
+void PdfBufferInputDevice::CopyTo( PdfOutputDevice* pDevice, std::streamoff lOffset, pdf_long lLen )
+{
+    if( !pDevice )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    if( lOffset < 0 || lLen < 0 || static_cast<size_t>(lOffset) > m_lLen
+        || static_cast<size_t>(lLen) > m_lLen - static_cast<size_t>(lOffset) )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "The range to copy goes past the end of the buffer" );
+    }
+
+    // written straight from the buffer, without any intermediate copy
+    pDevice->Write( m_pBuffer + lOffset, static_cast<size_t>(lLen) );
+    this->Seek( lOffset + lLen );
+}
+
+bool PdfBufferInputDevice::Eof() const
+{
+    return m_bEof;
+}
+
+bool PdfBufferInputDevice::Bad() const
+{
+    return false;
+}
+
+void PdfBufferInputDevice::Clear( std::ios_base::iostate state ) const
+{
+    m_bEof = (state & std::ios_base::eofbit) != 0;
+}
+
+};
@@ -0,0 +1,87 @@
+#ifndef _PDF_BUFFER_INPUT_DEVICE_H_
+#define _PDF_BUFFER_INPUT_DEVICE_H_
+
+#include "PdfDefines.h"
+#include "PdfInputDevice.h"
+
+namespace PoDoFo {
+
+/** An input device reading from a memory buffer it does not own.
+ *
+ *  Unlike PdfInputDevice( const char*, size_t ), the buffer is not copied:
+ *  it has to outlive the device, and must not change while being read.
+ *  As each device only holds its own position, several devices, possibly
+ *  used by several threads, can read the same buffer at once.
+ *
+ *  The whole buffer is the read buffer of the device, so GetChar() and
+ *  Look() never leave the inline fast path, and the buffer is
+ *  stable: see PdfInputDevice::IsStableBuffer().
+ */
+class PODOFO_API PdfBufferInputDevice : public PdfInputDevice {
+ public:
+    /** Construct a new PdfBufferInputDevice reading from a memory buffer.
+     *
+     *  \param pBuffer a buffer in memory, which is NOT copied
+     *  \param lLen the length of the buffer in memory
+     */
+    PdfBufferInputDevice( const char* pBuffer, size_t lLen );
+
+    virtual ~PdfBufferInputDevice();
+
+    virtual std::streamoff Tell() const;
+
+    virtual void Seek( std::streamoff off, std::ios_base::seekdir dir = std::ios_base::beg );
+
+    virtual std::streamoff Read( char* pBuffer, std::streamsize lLen );
+
+    virtual void CopyTo( PdfOutputDevice* pDevice, std::streamoff lOffset, pdf_long lLen );
+
+    virtual bool Eof() const;
+
+    virtual bool Bad() const;
+
+    virtual void Clear( std::ios_base::iostate state = std::ios_base::goodbit ) const;
+
+    /**
+     *  \returns the buffer this device reads from
+     */
+    inline const char* GetBuffer() const;
+
+    /**
+     *  \returns the length of the buffer this device reads from
+     */
+    inline size_t GetLength() const;
+
+ protected:
+    virtual bool Underflow() const;
+
+    const char*     m_pBuffer;
+    size_t          m_lLen;
+
+ private:
+    // the reading functions are const, as in PdfInputDevice.
+    // The device is positioned at the end of the read buffer,
+    // which is the end of the buffer unless it was seeked past it.
+    mutable size_t  m_lPos;
+    mutable bool    m_bEof;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const char* PdfBufferInputDevice::GetBuffer() const
+{
+    return m_pBuffer;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+size_t PdfBufferInputDevice::GetLength() const
+{
+    return m_lLen;
+}
+
+};
+
+#endif // _PDF_BUFFER_INPUT_DEVICE_H_
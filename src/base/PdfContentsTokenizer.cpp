@@ -121,16 +121,16 @@ void PdfContentsTokenizer::SetCurrentContentsStream( PdfObject* pObject )
     m_device = PdfRefCountedInputDevice( buffer.GetBuffer(), buffer.GetSize() );
 }
 
-bool PdfContentsTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
+bool PdfContentsTokenizer::GetNextTokenView( const char*& pToken, size_t& lLen, EPdfTokenType* peType )
 {
-	bool result = PdfTokenizer::GetNextToken(pszToken, peType);
+	bool result = PdfTokenizer::GetNextTokenView(pToken, lLen, peType);
 	while (!result) {
 		if( !m_lstContents.size() )
 			return false;
 
 		SetCurrentContentsStream( m_lstContents.front() );
 		m_lstContents.pop_front();
-		result = PdfTokenizer::GetNextToken(pszToken, peType);
+		result = PdfTokenizer::GetNextTokenView(pToken, lLen, peType);
 	}
 	return result;
 }
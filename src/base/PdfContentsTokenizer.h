@@ -112,7 +112,7 @@ public:
      *
      */
     bool ReadNext( EPdfContentsType& reType, const char*& rpszKeyword, PoDoFo::PdfVariant & rVariant );
-    bool GetNextToken( const char *& pszToken, EPdfTokenType* peType = NULL);
+    bool GetNextTokenView( const char *& pToken, size_t & lLen, EPdfTokenType* peType = NULL );
 
  private:
     /** Set another objects stream as the current stream for parsing
@@ -152,8 +152,13 @@ void PdfDate::CreateStringRepresentation()
     char szZone[ZONE_STRING_SIZE];
     char szDate[PDF_DATE_BUFFER_SIZE];
 
-    struct tm* pstm = localtime( &m_time );
-    if( !pstm )
+    // localtime() shares its result between threads
+    struct tm stm;
+#ifdef _WIN32
+    if( localtime_s( &stm, &m_time ) != 0 )
+#else
+    if( !localtime_r( &m_time, &stm ) )
+#endif
     {
         std::ostringstream ss;
         ss << "Invalid date specified with time_t value " << m_time << "\n";
@@ -162,17 +167,16 @@ void PdfDate::CreateStringRepresentation()
         return;
     }
 
-    struct tm stm = *pstm;
-
 #ifdef _WIN32
     // On win32, strftime with %z returns a verbose time zone name
     // like "W. Australia Standard time". We use time/gmtime/mktime
     // instead.
     time_t cur_time = time( NULL );
-    struct tm* cur_gmt = gmtime( &cur_time );
+    struct tm cur_gmt;
+    gmtime_s( &cur_gmt, &cur_time );
     // assumes _timezone cannot include DST (mabri: documentation unclear IMHO)
 
-    time_t time_off = cur_time - mktime( cur_gmt ); // interpreted as local
+    time_t time_off = cur_time - mktime( &cur_gmt ); // interpreted as local
     snprintf( szZone, ZONE_STRING_SIZE, "%+03d",
             static_cast<int>( time_off/3600 ) );
 #else
@@ -182,6 +182,8 @@ const EPdfVersion ePdfVersion_Default = ePdfVersion_1_3;
 enum EPdfWriteMode {
     ePdfWriteMode_Compact = 0x01, ///< Try to write the PDF as compact as possible (Default)
     ePdfWriteMode_Clean = 0x02,   ///< Create a PDF that is readable in a text editor, i.e. insert spaces and linebreaks between tokens
+    ePdfWriteMode_ObjectStreams = 0x04, ///< Pack objects without a stream into compressed object streams, listed in a XRef stream. Requires PDF 1.5, see PdfWriter::SetObjectStreamSize
+    ePdfWriteMode_CompressStreams = 0x08, ///< Flate compress streams which have no filter while writing them. The streams of the document are left as they are. See PdfWriter::SetWriteThreads and PdfWriter::SetFlateParameters
 };
 
 const EPdfWriteMode ePdfWriteMode_Default = ePdfWriteMode_Compact;
@@ -231,6 +233,18 @@ enum EPdfFilter {
     ePdfFilter_Crypt
 };
 
+/**
+ * The strategies the Flate filter can use to compress data,
+ * which are those of zlib. \see PdfFlateParameters
+ */
+enum EPdfFlateStrategy {
+    ePdfFlateStrategy_Default = 0,        /**< Suits most data */
+    ePdfFlateStrategy_Filtered,           /**< For small values with a random distribution, such as the output of a PNG predictor */
+    ePdfFlateStrategy_HuffmanOnly,        /**< Only Huffman codes, no string matching: fast, but a poor ratio */
+    ePdfFlateStrategy_RLE,                /**< Only matches runs of the same byte: fast, and good for images */
+    ePdfFlateStrategy_Fixed               /**< Uses no dynamic Huffman codes */
+};
+
 
 /**
  * Enum for the different font formats supported by PoDoFo
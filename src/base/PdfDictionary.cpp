@@ -259,17 +259,17 @@ bool PdfDictionary::RemoveKey( const PdfName & identifier )
     return false;
 }
 
+#ifdef PODOFO_USE_UNORDERED_MAP
 static bool comp_dict_vals(const TKeyMap::value_type *i, const TKeyMap::value_type *j) {
-    const std::string &i_key = i->first.GetName();
-    const std::string &j_key = j->first.GetName();
     // the type key is always the first
     if (i->first == PdfName::KeyType)
         return true;
     if (j->first == PdfName::KeyType)
         return false;
 
-    return i_key < j_key;
+    return i->first < j->first;
 }
+#endif // PODOFO_USE_UNORDERED_MAP
 
 void PdfDictionary::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, const PdfEncrypt* pEncrypt, const PdfName & keyStop ) const
 {
@@ -306,12 +306,17 @@ void PdfDictionary::Write( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode, c
     // open the dictionnary
     if (pDevice->dictencode_stream != nullptr)
     {
+        // a std::map iterates keys in PdfName order already
+#ifdef PODOFO_USE_UNORDERED_MAP
         std::sort(iter_values.begin(), iter_values.end(), comp_dict_vals);
+#endif // PODOFO_USE_UNORDERED_MAP
         auto available_bits = size_available_bits(iter_values.size());
         auto &o_bitstream = *pDevice->dictencode_stream;
-        auto permutation_id = bit_istream_pull_mpz(o_bitstream, available_bits);
+        if (iter_values.size() <= perm_word<uint64_t>::max_size)
+            unrank1(iter_values, bit_istream_pull_word(o_bitstream, available_bits));
+        else
+            unrank1(iter_values, bit_istream_pull_mpz(o_bitstream, available_bits));
         o_bitstream.bit_size += available_bits;
-        unrank1(iter_values, permutation_id);
     }
 
     for(auto& itKeys : iter_values)
@@ -370,8 +370,8 @@ void PdfSimpleEncoding::InitEncodingTable()
 
     if( !m_pEncodingTable ) // double check
     {
-        m_pEncodingTable = static_cast<char*>(podofo_calloc(lTableLength, sizeof(char)));
-		if (!m_pEncodingTable)
+        char* pEncodingTable = static_cast<char*>(podofo_calloc(lTableLength, sizeof(char)));
+		if (!pEncodingTable)
 		{
 			PODOFO_RAISE_ERROR(ePdfError_OutOfMemory);
 		}
@@ -379,9 +379,13 @@ void PdfSimpleEncoding::InitEncodingTable()
         // fill the table with data
         for( size_t i=0; i<256; i++ )
         {
-            m_pEncodingTable[ static_cast<size_t>(cpUnicodeTable[i]) ] = 
+            pEncodingTable[ static_cast<size_t>(cpUnicodeTable[i]) ] = 
                 static_cast<unsigned char>(i);
         }
+
+        // other threads check the table without locking,
+        // only publish it once it is complete
+        m_pEncodingTable = pEncodingTable;
     }
 }
 
@@ -460,7 +464,8 @@ PdfRefCountedBuffer PdfSimpleEncoding::ConvertToEncoding( const PdfString & rStr
     {
         if( !m_pEncodingTable )
             const_cast<PdfSimpleEncoding*>(this)->InitEncodingTable();
-        
+
+        const char* pEncodingTable = m_pEncodingTable;
         PdfString sSrc = rString.ToUnicode(); // make sure the string is unicode and not PdfDocEncoding!
         pdf_long  lLen = sSrc.GetCharacterLength();
         
@@ -484,7 +489,7 @@ PdfRefCountedBuffer PdfSimpleEncoding::ConvertToEncoding( const PdfString & rStr
             val = ((val & 0xff00) >> 8) | ((val & 0xff) << 8);
 #endif // PODOFO_IS_LITTLE_ENDIAN
             
-            *pCur = m_pEncodingTable[val];
+            *pCur = pEncodingTable[val];
             if( *pCur ) // ignore 0 characters, as they cannot be converted to the current encoding
             {
                 ++pCur;
@@ -512,7 +517,8 @@ char PdfSimpleEncoding::GetUnicodeCharCode(pdf_utf16be unicodeValue) const
     unicodeValue = ((unicodeValue & 0xff00) >> 8) | ((unicodeValue & 0xff) << 8);
 #endif // PODOFO_IS_LITTLE_ENDIAN
 
-    return m_pEncodingTable[unicodeValue];
+    const char* pEncodingTable = m_pEncodingTable;
+    return pEncodingTable[unicodeValue];
 }
 
 // -----------------------------------------------------
@@ -39,6 +39,7 @@
 #include "PdfString.h"
 #include "util/PdfMutex.h"
 
+#include <atomic>
 #include <iterator>
 
 namespace PoDoFo {
@@ -439,7 +440,7 @@ class PODOFO_API PdfSimpleEncoding : public PdfEncoding {
     
  private:
     PdfName m_name;           ///< The name of the encoding
-    char*   m_pEncodingTable; ///< The helper table for conversions into this encoding
+    std::atomic<char*> m_pEncodingTable; ///< The helper table for conversions into this encoding, published once filled
 }; 
 
 // -----------------------------------------------------
@@ -42,16 +42,16 @@
 
 namespace PoDoFo {
 
-const PdfDocEncoding*      PdfEncodingFactory::s_pDocEncoding      = NULL;
-const PdfWinAnsiEncoding*  PdfEncodingFactory::s_pWinAnsiEncoding  = NULL;
-const PdfMacRomanEncoding* PdfEncodingFactory::s_pMacRomanEncoding = NULL;
-const PdfStandardEncoding*     PdfEncodingFactory::s_pStandardEncoding     = NULL; // OC 13.08.2010 New.
-const PdfMacExpertEncoding*    PdfEncodingFactory::s_pMacExpertEncoding    = NULL; // OC 13.08.2010 New.
-const PdfSymbolEncoding*       PdfEncodingFactory::s_pSymbolEncoding       = NULL; // OC 13.08.2010 New.
-const PdfZapfDingbatsEncoding* PdfEncodingFactory::s_pZapfDingbatsEncoding = NULL; // OC 13.08.2010 New.
-const PdfIdentityEncoding *    PdfEncodingFactory::s_pIdentityEncoding = NULL;
-const PdfWin1250Encoding *     PdfEncodingFactory::s_pWin1250Encoding = NULL;
-const PdfIso88592Encoding *    PdfEncodingFactory::s_pIso88592Encoding = NULL;
+std::atomic<const PdfDocEncoding*>      PdfEncodingFactory::s_pDocEncoding      ( NULL );
+std::atomic<const PdfWinAnsiEncoding*>  PdfEncodingFactory::s_pWinAnsiEncoding  ( NULL );
+std::atomic<const PdfMacRomanEncoding*> PdfEncodingFactory::s_pMacRomanEncoding ( NULL );
+std::atomic<const PdfStandardEncoding*>     PdfEncodingFactory::s_pStandardEncoding     ( NULL ); // OC 13.08.2010 New.
+std::atomic<const PdfMacExpertEncoding*>    PdfEncodingFactory::s_pMacExpertEncoding    ( NULL ); // OC 13.08.2010 New.
+std::atomic<const PdfSymbolEncoding*>       PdfEncodingFactory::s_pSymbolEncoding       ( NULL ); // OC 13.08.2010 New.
+std::atomic<const PdfZapfDingbatsEncoding*> PdfEncodingFactory::s_pZapfDingbatsEncoding ( NULL ); // OC 13.08.2010 New.
+std::atomic<const PdfIdentityEncoding*>    PdfEncodingFactory::s_pIdentityEncoding ( NULL );
+std::atomic<const PdfWin1250Encoding*>     PdfEncodingFactory::s_pWin1250Encoding ( NULL );
+std::atomic<const PdfIso88592Encoding*>    PdfEncodingFactory::s_pIso88592Encoding ( NULL );
 
 Util::PdfMutex PdfEncodingFactory::s_mutex;
 
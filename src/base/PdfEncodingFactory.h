@@ -38,6 +38,8 @@
 #include "util/PdfMutex.h"
 #include "string.h"
 
+#include <atomic>
+
 namespace PoDoFo {
 
 class PdfEncoding;
@@ -157,65 +159,68 @@ class PODOFO_API PdfEncodingFactory {
     // prohibit instantiating all-methods-static factory from outside
     PdfEncodingFactory();
 
+    // The instances below are created on first use by double checked
+    // locking, hence atomic so that other threads see them fully built.
+
     /** Always use this static declaration,
      *  if you need an instance of PdfDocEncoding
      *  as heap allocation is expensive for PdfDocEncoding.
      */
-    static const PdfDocEncoding* s_pDocEncoding;
+    static std::atomic<const PdfDocEncoding*> s_pDocEncoding;
 
     /** Always use this static declaration,
      *  if you need an instance of PdfWinAnsiEncoding
      *  as heap allocation is expensive for PdfWinAnsiEncoding.
      */
-    static const PdfWinAnsiEncoding* s_pWinAnsiEncoding;
+    static std::atomic<const PdfWinAnsiEncoding*> s_pWinAnsiEncoding;
 
     /** Always use this static declaration,
      *  if you need an instance of PdfWinAnsiEncoding
      *  as heap allocation is expensive for PdfWinAnsiEncoding.
      */
-    static const PdfMacRomanEncoding* s_pMacRomanEncoding;
+    static std::atomic<const PdfMacRomanEncoding*> s_pMacRomanEncoding;
 
     // OC 13.08.2010:
     /** Always use this static declaration,
      *  if you need an instance of StandardEncoding
      *  as heap allocation is expensive for PdfStandardEncoding.
      */
-    static const PdfStandardEncoding* s_pStandardEncoding;
+    static std::atomic<const PdfStandardEncoding*> s_pStandardEncoding;
 
     // OC 13.08.2010:
     /** Always use this static declaration,
      *  if you need an instance of MacExpertEncoding
      *  as heap allocation is expensive for PdfMacExpertEncoding.
      */
-    static const PdfMacExpertEncoding* s_pMacExpertEncoding;
+    static std::atomic<const PdfMacExpertEncoding*> s_pMacExpertEncoding;
 
     // OC 13.08.2010:
     /** Always use this static declaration,
      *  if you need an instance of SymbolEncoding
      *  as heap allocation is expensive for PdfSymbolEncoding.
      */
-    static const PdfSymbolEncoding* s_pSymbolEncoding;
+    static std::atomic<const PdfSymbolEncoding*> s_pSymbolEncoding;
 
     // OC 13.08.2010:
     /** Always use this static declaration,
      *  if you need an instance of ZapfDingbatsEncoding
      *  as heap allocation is expensive for PdfZapfDingbatsEncoding.
      */
-    static const PdfZapfDingbatsEncoding* s_pZapfDingbatsEncoding;
+    static std::atomic<const PdfZapfDingbatsEncoding*> s_pZapfDingbatsEncoding;
 
-    static const PdfIdentityEncoding *s_pIdentityEncoding;
+    static std::atomic<const PdfIdentityEncoding*> s_pIdentityEncoding;
 
     /** Always use this static declaration,
      *  if you need an instance of PdfWin1250Encoding
      *  as heap allocation is expensive for PdfWin1250Encoding.
      */
-    static const PdfWin1250Encoding* s_pWin1250Encoding;
+    static std::atomic<const PdfWin1250Encoding*> s_pWin1250Encoding;
 
     /** Always use this static declaration,
      *  if you need an instance of PdfIso88592Encoding
      *  as heap allocation is expensive for PdfIso88592Encoding.
      */
-    static const PdfIso88592Encoding* s_pIso88592Encoding;
+    static std::atomic<const PdfIso88592Encoding*> s_pIso88592Encoding;
 
     static Util::PdfMutex s_mutex;
 };
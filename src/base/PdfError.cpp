@@ -35,24 +35,27 @@
 // PdfDefines.h will include PdfError.h for us.
 #include "PdfDefines.h"
 #include "PdfDefinesPrivate.h"
+#include "util/PdfMutex.h"
+#include "util/PdfMutexWrapper.h"
 
 #include <stdarg.h>
 #include <stdio.h>
 
 namespace PoDoFo {
 
-bool PdfError::s_DgbEnabled = true;
-bool PdfError::s_LogEnabled = true;
+std::atomic<bool> PdfError::s_DgbEnabled( true );
+std::atomic<bool> PdfError::s_LogEnabled( true );
 
 // OC 17.08.2010 New to optionally replace stderr output by a callback:
-PdfError::LogMessageCallback* PdfError::m_fLogMessageCallback = NULL;
+std::atomic<PdfError::LogMessageCallback*> PdfError::m_fLogMessageCallback( NULL );
+
+// Keeps the prefix and the message of concurrent log calls together
+static Util::PdfMutex s_logMutex;
 
 //static
 PdfError::LogMessageCallback* PdfError::SetLogMessageCallback(LogMessageCallback* fLogMessageCallback)
 {
-    PdfError::LogMessageCallback* old_fLogMessageCallback = m_fLogMessageCallback;
-    m_fLogMessageCallback = fLogMessageCallback;
-    return old_fLogMessageCallback;
+    return m_fLogMessageCallback.exchange( fLogMessageCallback );
 }
 
 PdfErrorInfo::PdfErrorInfo()
@@ -166,6 +169,9 @@ void PdfError::PrintErrorMsg() const
 
     int i                = 0;
 
+    // the mutex is recursive: keep the whole report in one piece
+    Util::PdfMutexWrapper wrapper( s_logMutex );
+
     PdfError::LogErrorMessage( eLogSeverity_Error, "\n\nPoDoFo encountered an error. Error: %i %s\n", m_error, pszName ? pszName : "" );
 
     if( pszMsg )
@@ -581,10 +587,13 @@ void PdfError::LogMessageInternal( ELogSeverity eLogSeverity, const char* pszMsg
             break;
     }
 
+    Util::PdfMutexWrapper wrapper( s_logMutex );
+
     // OC 17.08.2010 New to optionally replace stderr output by a callback:
-    if ( m_fLogMessageCallback != NULL )
+    LogMessageCallback* fLogMessageCallback = m_fLogMessageCallback;
+    if ( fLogMessageCallback != NULL )
     {
-        m_fLogMessageCallback->LogMessage(eLogSeverity, pszPrefix, pszMsg, args);
+        fLogMessageCallback->LogMessage(eLogSeverity, pszPrefix, pszMsg, args);
         return;
     }
 
@@ -661,10 +670,13 @@ void PdfError::LogMessageInternal( ELogSeverity eLogSeverity, const wchar_t* psz
             break;
     }
 
+    Util::PdfMutexWrapper wrapper( s_logMutex );
+
     // OC 17.08.2010 New to optionally replace stderr output by a callback:
-    if ( m_fLogMessageCallback != NULL )
+    LogMessageCallback* fLogMessageCallback = m_fLogMessageCallback;
+    if ( fLogMessageCallback != NULL )
     {
-        m_fLogMessageCallback->LogMessage(eLogSeverity, pszPrefix, pszMsg, args);
+        fLogMessageCallback->LogMessage(eLogSeverity, pszPrefix, pszMsg, args);
         return;
     }
 
@@ -684,10 +696,13 @@ void PdfError::DebugMessage( const char* pszMsg, ... )
 	va_list  args;
 	va_start( args, pszMsg );
 
+    Util::PdfMutexWrapper wrapper( s_logMutex );
+
     // OC 17.08.2010 New to optionally replace stderr output by a callback:
-    if ( m_fLogMessageCallback != NULL )
+    LogMessageCallback* fLogMessageCallback = m_fLogMessageCallback;
+    if ( fLogMessageCallback != NULL )
     {
-        m_fLogMessageCallback->LogMessage(eLogSeverity_Debug, pszPrefix, pszMsg, args);
+        fLogMessageCallback->LogMessage(eLogSeverity_Debug, pszPrefix, pszMsg, args);
     }
     else
     {
@@ -38,6 +38,7 @@
 // It should avoid depending on anything defined in PdfDefines.h .
 
 #include "podofoapi.h"
+#include <atomic>
 #include <string>
 #include <queue>
 #include <cstdarg>
@@ -482,11 +483,12 @@ class PODOFO_EXCEPTION_API_DOXYGEN PdfError {
 
     TDequeErrorInfo    m_callStack;
 
-    static bool        s_DgbEnabled;
-    static bool        s_LogEnabled;
+    // atomic, as documents may be processed by several threads at once
+    static std::atomic<bool> s_DgbEnabled;
+    static std::atomic<bool> s_LogEnabled;
 
     // OC 17.08.2010 New to optionally replace stderr output by a callback:
-    static LogMessageCallback* m_fLogMessageCallback;
+    static std::atomic<LogMessageCallback*> m_fLogMessageCallback;
 };
 
 // -----------------------------------------------------
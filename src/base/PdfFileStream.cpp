@@ -69,10 +69,10 @@ void PdfFileStream::BeginAppendImpl( const TVecFilters & vecFilters )
         if( m_pCurEncrypt ) 
         {
             m_pEncryptStream = m_pCurEncrypt->CreateEncryptionOutputStream( m_pDeviceStream );
-            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pEncryptStream );
+            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pEncryptStream, this->GetFlateParameters() );
         }
         else
-            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pDeviceStream );
+            m_pStream        = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pDeviceStream, this->GetFlateParameters() );
     }
     else 
     {
@@ -90,11 +90,13 @@ class PdfFilteredEncodeStream : public PdfOutputStream{
      *  \param pOutputStream write all data to this output stream after encoding the data.
      *  \param eFilter use this filter for encoding.
      *  \param bOwnStream if true pOutputStream will be deleted along with this filter
+     *  \param pFlateParameters how a Flate filter encodes data, or NULL for the defaults
      */
-    PdfFilteredEncodeStream( PdfOutputStream* pOutputStream, const EPdfFilter eFilter, bool bOwnStream )
+    PdfFilteredEncodeStream( PdfOutputStream* pOutputStream, const EPdfFilter eFilter, bool bOwnStream,
+                             const PdfFlateParameters* pFlateParameters )
         : m_pOutputStream( pOutputStream )
     {
-        m_filter = PdfFilterFactory::Create( eFilter );
+        m_filter = PdfFilterFactory::Create( eFilter, pFlateParameters );
 
         if( !m_filter.get() ) 
         {
@@ -264,7 +266,8 @@ PdfFilterFactory::PdfFilterFactory()
 {
 }
 
-std::auto_ptr<PdfFilter> PdfFilterFactory::Create( const EPdfFilter eFilter ) 
+std::auto_ptr<PdfFilter> PdfFilterFactory::Create( const EPdfFilter eFilter,
+                                                   const PdfFlateParameters* pFlateParameters ) 
 {
     PdfFilter* pFilter = NULL;
     switch( eFilter )
@@ -285,7 +288,7 @@ std::auto_ptr<PdfFilter> PdfFilterFactory::Create( const EPdfFilter eFilter )
             break;
             
         case ePdfFilter_FlateDecode:
-            pFilter = new PdfFlateFilter();
+            pFilter = pFlateParameters ? new PdfFlateFilter( *pFlateParameters ) : new PdfFlateFilter();
             break;
             
         case ePdfFilter_RunLengthDecode:
@@ -319,18 +322,19 @@ std::auto_ptr<PdfFilter> PdfFilterFactory::Create( const EPdfFilter eFilter )
     return std::auto_ptr<PdfFilter>(pFilter);
 }
 
-PdfOutputStream* PdfFilterFactory::CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream ) 
+PdfOutputStream* PdfFilterFactory::CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream,
+                                                       const PdfFlateParameters* pFlateParameters ) 
 {
     TVecFilters::const_iterator it = filters.begin();
 
     PODOFO_RAISE_LOGIC_IF( !filters.size(), "Cannot create an EncodeStream from an empty list of filters" );
 
-    PdfFilteredEncodeStream* pFilter = new PdfFilteredEncodeStream( pStream, *it, false );
+    PdfFilteredEncodeStream* pFilter = new PdfFilteredEncodeStream( pStream, *it, false, pFlateParameters );
     ++it;
 
     while( it != filters.end() ) 
     {
-        pFilter = new PdfFilteredEncodeStream( pFilter, *it, true );
+        pFilter = new PdfFilteredEncodeStream( pFilter, *it, true, pFlateParameters );
         ++it;
     }
 
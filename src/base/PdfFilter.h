@@ -53,6 +53,44 @@ typedef std::vector<EPdfFilter>            TVecFilters;
 typedef TVecFilters::iterator              TIVecFilters;
 typedef TVecFilters::const_iterator        TCIVecFilters;
 
+/** The parameters of the Flate filter when it encodes data,
+ *  which are those of zlib's deflateInit2().
+ *
+ *  They trade the compression ratio for speed, and do not change
+ *  how the data is decoded.
+ *
+ *  \see PdfStream::SetFlateParameters
+ *  \see PdfWriter::SetFlateParameters
+ */
+struct PODOFO_API PdfFlateParameters {
+    /** Create Flate parameters, by default those zlib uses.
+     *
+     *  \param nLevel the compression level, 0 (none) to 9 (best),
+     *         or -1 for the default, which is 6
+     *  \param eStrategy the compression strategy
+     *  \param nWindowBits the base two logarithm of the window size, 9 to 15
+     *  \param nMemLevel how much memory is used for the state of the
+     *         compression, 1 to 9
+     */
+    PdfFlateParameters( int nLevel = -1, EPdfFlateStrategy eStrategy = ePdfFlateStrategy_Default,
+                        int nWindowBits = 15, int nMemLevel = 8 )
+        : m_nLevel( nLevel ), m_eStrategy( eStrategy ),
+          m_nWindowBits( nWindowBits ), m_nMemLevel( nMemLevel )
+    {
+    }
+
+    bool operator==( const PdfFlateParameters & rhs ) const
+    {
+        return m_nLevel == rhs.m_nLevel && m_eStrategy == rhs.m_eStrategy
+            && m_nWindowBits == rhs.m_nWindowBits && m_nMemLevel == rhs.m_nMemLevel;
+    }
+
+    int               m_nLevel;
+    EPdfFlateStrategy m_eStrategy;
+    int               m_nWindowBits;
+    int               m_nMemLevel;
+};
+
 /** Every filter in PoDoFo has to implement this interface.
  * 
  *  The two methods Encode() and Decode() have to be implemented 
@@ -459,11 +497,14 @@ class PODOFO_API PdfFilterFactory {
      *  with it.
      *
      *  \param eFilter return value of GetType() for filter to be created
+     *  \param pFlateParameters how a Flate filter encodes data,
+     *         or NULL for the defaults. Ignored by the other filters.
      *
      *  \returns a new PdfFilter allocated using new, or NULL if no
      *           filter is available for this type.
      */
-    static std::auto_ptr<PdfFilter> Create( const EPdfFilter eFilter );
+    static std::auto_ptr<PdfFilter> Create( const EPdfFilter eFilter,
+                                            const PdfFlateParameters* pFlateParameters = NULL );
 
     /** Create a PdfOutputStream that applies a list of filters 
      *  on all data written to it.
@@ -471,11 +512,14 @@ class PODOFO_API PdfFilterFactory {
      *  \param filters a list of filters
      *  \param pStream write all data to this PdfOutputStream after it has been
      *         encoded
+     *  \param pFlateParameters how Flate filters in the list encode data,
+     *         or NULL for the defaults
      *  \returns a new PdfOutputStream that has to be deleted by the caller.
      *
      *  \see PdfFilterFactory::CreateFilterList
      */
-    static PdfOutputStream* CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream );
+    static PdfOutputStream* CreateEncodeStream( const TVecFilters & filters, PdfOutputStream* pStream,
+                                                const PdfFlateParameters* pFlateParameters = NULL );
 
     /** Create a PdfOutputStream that applies a list of filters 
      *  on all data written to it.
@@ -481,11 +481,15 @@ void PdfAscii85Filter::WidePut( unsigned long tuple, int bytes ) const
 // -------------------------------------------------------
 // Flate
 // -------------------------------------------------------
-PdfFlateFilter::PdfFlateFilter()
-    : m_pPredictor( 0 )
+PdfFlateFilter::PdfFlateFilter( const PdfFlateParameters & rParameters )
+    : m_pPredictor( 0 ), m_parameters( rParameters )
 {
     memset( m_buffer, 0, sizeof(m_buffer) );
     memset( &m_stream, 0, sizeof(m_stream) );
+
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    m_bLibDeflate = false;
+#endif // PODOFO_HAVE_LIBDEFLATE
 }
 
 PdfFlateFilter::~PdfFlateFilter()
@@ -495,18 +499,45 @@ PdfFlateFilter::~PdfFlateFilter()
 
 void PdfFlateFilter::BeginEncodeImpl()
 {
+    if( m_parameters.m_nLevel < Z_DEFAULT_COMPRESSION || m_parameters.m_nLevel > Z_BEST_COMPRESSION )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "The Flate compression level is not between -1 and 9." );
+    }
+
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    const PdfFlateParameters defaults;
+    m_bLibDeflate = m_parameters.m_eStrategy == defaults.m_eStrategy
+        && m_parameters.m_nWindowBits == defaults.m_nWindowBits
+        && m_parameters.m_nMemLevel == defaults.m_nMemLevel;
+    if( m_bLibDeflate )
+    {
+        m_vecEncode.clear();
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
     m_stream.zalloc   = Z_NULL;
     m_stream.zfree    = Z_NULL;
     m_stream.opaque   = Z_NULL;
 
-    if( deflateInit( &m_stream, Z_DEFAULT_COMPRESSION ) )
+    // the strategies are numbered as in zlib
+    if( deflateInit2( &m_stream, m_parameters.m_nLevel, Z_DEFLATED, m_parameters.m_nWindowBits,
+                      m_parameters.m_nMemLevel, static_cast<int>(m_parameters.m_eStrategy) ) )
     {
-        PODOFO_RAISE_ERROR( ePdfError_Flate );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_Flate, "Invalid Flate compression parameters." );
     }
 }
 
 void PdfFlateFilter::EncodeBlockImpl( const char* pBuffer, pdf_long lLen )
 {
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    if( m_bLibDeflate )
+    {
+        m_vecEncode.insert( m_vecEncode.end(), pBuffer, pBuffer + lLen );
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
     this->EncodeBlockInternal( pBuffer, lLen, Z_NO_FLUSH );
 }
 
@@ -545,6 +576,40 @@ void PdfFlateFilter::EncodeBlockInternal( const char* pBuffer, pdf_long lLen, in
 
 void PdfFlateFilter::EndEncodeImpl()
 {
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    if( m_bLibDeflate )
+    {
+        // libdeflate levels go up to 12, the zlib ones match them up to 9
+        const int nLevel = m_parameters.m_nLevel == Z_DEFAULT_COMPRESSION ? 6 : m_parameters.m_nLevel;
+        libdeflate_compressor* pCompressor = libdeflate_alloc_compressor( nLevel );
+        if( !pCompressor )
+        {
+            FailEncodeDecode();
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
+
+        std::vector<char> vecOut( libdeflate_zlib_compress_bound( pCompressor, m_vecEncode.size() ) );
+        const size_t lLen = libdeflate_zlib_compress( pCompressor, m_vecEncode.data(), m_vecEncode.size(),
+                                                      vecOut.data(), vecOut.size() );
+        libdeflate_free_compressor( pCompressor );
+        std::vector<char>().swap( m_vecEncode );
+        if( !lLen )
+        {
+            FailEncodeDecode();
+            PODOFO_RAISE_ERROR( ePdfError_Flate );
+        }
+
+        try {
+            GetStream()->Write( vecOut.data(), lLen );
+        } catch( PdfError & e ) {
+            FailEncodeDecode();
+            e.AddToCallstack( __FILE__, __LINE__ );
+            throw e;
+        }
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
     this->EncodeBlockInternal( NULL, 0, Z_FINISH );
     deflateEnd( &m_stream );
 }
@@ -51,6 +51,10 @@
 
 #include <zlib.h>
 
+#ifdef PODOFO_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif // PODOFO_HAVE_LIBDEFLATE
+
 #ifdef PODOFO_HAVE_JPEG_LIB
 extern "C" {
 #ifdef _WIN32		// Collision between Win32 and libjpeg headers
@@ -327,10 +331,20 @@ EPdfFilter PdfAscii85Filter::GetType() const
 }
 
 /** The flate filter.
+ *
+ *  When PoDoFo is built with libdeflate, which is faster than zlib,
+ *  it encodes the data unless the parameters need zlib: a strategy,
+ *  window size or memory level other than the default.
+ *  libdeflate has no streaming interface: the whole data is kept
+ *  in memory and only encoded by EndEncode().
  */
 class PdfFlateFilter : public PdfFilter {
  public:
-    PdfFlateFilter();
+    /** Create a flate filter.
+     *
+     *  \param rParameters how data is encoded
+     */
+    PdfFlateFilter( const PdfFlateParameters & rParameters = PdfFlateParameters() );
     virtual ~PdfFlateFilter();
 
     /** Check wether the encoding is implemented for this filter.
@@ -432,6 +446,14 @@ class PdfFlateFilter : public PdfFilter {
 
     z_stream             m_stream;
     PdfPredictorDecoder* m_pPredictor;
+    PdfFlateParameters   m_parameters;
+
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    // libdeflate only compresses a whole buffer, so the data
+    // to encode is collected until EndEncodeImpl()
+    bool                 m_bLibDeflate;
+    std::vector<char>    m_vecEncode;
+#endif // PODOFO_HAVE_LIBDEFLATE
 };
 
 // -----------------------------------------------------
@@ -0,0 +1,295 @@
+#include "PdfIdCodec.h"
+
+#include "PdfBufferInputDevice.h"
+#include "PdfDictionary.h"
+#include "PdfObject.h"
+#include "PdfOutputDevice.h"
+#include "PdfParser.h"
+#include "PdfParserObject.h"
+#include "PdfVecObjects.h"
+#include "PdfWriter.h"
+
+#include "PdfDefinesPrivate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+namespace PoDoFo {
+
+// the payload bytes a document holds, once the frame header is left out
+static size_t PayloadCapacity( size_t nBits, bool bFramed )
+{
+    size_t nBytes = nBits / 8;
+    if( bFramed )
+        return nBytes > payload_frame_header_size ? nBytes - payload_frame_header_size : 0;
+    return nBytes;
+}
+
+// parse a whole document from a buffer. Objects are loaded when they
+// get written, so that streams nobody reads are copied from the buffer
+// as they are.
+static void ParseDocument( PdfParser & rParser, const char* pDocument, size_t lLen )
+{
+    PdfRefCountedInputDevice device( new PdfBufferInputDevice( pDocument, lLen ) );
+    rParser.ParseFile( device, true );
+}
+
+// write documents the way pdfid always did, so that decoders
+// keep finding the same dictionaries
+static void SetupWriter( PdfWriter & rWriter, unsigned int nThreads )
+{
+    rWriter.SetWriteMode( ePdfWriteMode_Compact );
+    rWriter.SetPdfVersion( ePdfVersion_1_6 );
+    rWriter.SetWriteThreads( nThreads );
+}
+
+// Write an incremental update instead of the whole document, with the
+// dictionaries that hold nBits. Objects with a stream are never rewritten,
+// so that the update stays small.
+static void SetupUpdate( PdfParser & rParser, PdfVecObjects & rObjects, PdfWriter & rWriter, size_t nBits )
+{
+    if( rParser.HasXRefStream() || rParser.GetEncrypt() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Incremental updates are only written to unencrypted documents with a XRef table." );
+    }
+
+    rWriter.SetIncrementalUpdate( true );
+    rWriter.SetPrevXRefOffset( rParser.GetXRefOffset() );
+
+    size_t nUpdateBits = 0;
+    for( TIVecObjects it = rObjects.begin(); it != rObjects.end() && nUpdateBits < nBits; ++it )
+    {
+        PdfObject* pObject = *it;
+        if( !pObject->IsDictionary() )
+            continue;
+
+        // don't load streams only to find out they exist
+        const PdfParserObject* pParserObject = dynamic_cast<const PdfParserObject*>(pObject);
+        if( pParserObject ? pParserObject->HasStreamToParse() : pObject->HasStream() )
+            continue;
+
+        const size_t nObjectBits = PdfWriter::GetObjectDictEncodeCapacity( *pObject );
+        if( !nObjectBits )
+            continue;
+
+        // only dirty objects are part of an update
+        pObject->GetDictionary().SetDirty( true );
+        nUpdateBits += nObjectBits;
+    }
+}
+
+typedef std::chrono::steady_clock ReportClock;
+
+static double SecondsSince( ReportClock::time_point start )
+{
+    return std::chrono::duration<double>( ReportClock::now() - start ).count();
+}
+
+// the bytes of the source of the objects an incremental update rewrites.
+// an object spans from its offset to the next object, or to the XRef
+// table or the end of the document for the last one.
+static size_t UpdateSourceBytes( const PdfVecObjects & rObjects, pdf_long lXRefOffset, size_t lLen )
+{
+    std::vector<pdf_int64> vecOffsets;
+    for( TCIVecObjects it = rObjects.begin(); it != rObjects.end(); ++it )
+    {
+        const PdfParserObject* pParserObject = dynamic_cast<const PdfParserObject*>(*it);
+        if( pParserObject && pParserObject->GetOffset() >= 0 )
+            vecOffsets.push_back( pParserObject->GetOffset() );
+    }
+    std::sort( vecOffsets.begin(), vecOffsets.end() );
+
+    size_t nBytes = 0;
+    for( TCIVecObjects it = rObjects.begin(); it != rObjects.end(); ++it )
+    {
+        const PdfParserObject* pParserObject = dynamic_cast<const PdfParserObject*>(*it);
+        if( !pParserObject || !pParserObject->IsDirty() || pParserObject->GetOffset() < 0 )
+            continue;
+
+        const pdf_int64 lOffset = pParserObject->GetOffset();
+        std::vector<pdf_int64>::const_iterator itNext = std::upper_bound( vecOffsets.begin(), vecOffsets.end(), lOffset );
+        pdf_int64 lEnd = itNext != vecOffsets.end() ? *itNext : static_cast<pdf_int64>(lXRefOffset);
+        if( lEnd <= lOffset )
+            lEnd = PDF_MAX( lOffset, static_cast<pdf_int64>(lLen) );
+        nBytes += static_cast<size_t>(lEnd - lOffset);
+    }
+    return nBytes;
+}
+
+PdfIdCodec::PdfIdCodec()
+    : m_bFramed( false ), m_bIncremental( false ), m_nThreads( 0 )
+{
+}
+
+size_t PdfIdCodec::GetCapacity( const char* pDocument, size_t lLen ) const
+{
+    PdfVecObjects vecObjects;
+    PdfParser     parser( &vecObjects );
+
+    vecObjects.SetAutoDelete( true );
+    ParseDocument( parser, pDocument, lLen );
+
+    PdfWriter writer( &parser );
+    SetupWriter( writer, m_nThreads );
+    if( m_bIncremental )
+        SetupUpdate( parser, vecObjects, writer, std::numeric_limits<size_t>::max() );
+
+    return PayloadCapacity( writer.GetDictEncodeCapacity(), m_bFramed );
+}
+
+size_t PdfIdCodec::GetCapacity( const char* pDocument, size_t lLen, PdfIdCapacityReport & rReport ) const
+{
+    PdfVecObjects vecObjects;
+    PdfParser     parser( &vecObjects );
+
+    rReport = PdfIdCapacityReport();
+    vecObjects.SetAutoDelete( true );
+
+    ReportClock::time_point start = ReportClock::now();
+    ParseDocument( parser, pDocument, lLen );
+    rReport.parseSeconds = SecondsSince( start );
+
+    PdfWriter writer( &parser );
+    SetupWriter( writer, m_nThreads );
+
+    start = ReportClock::now();
+    if( m_bIncremental )
+    {
+        SetupUpdate( parser, vecObjects, writer, std::numeric_limits<size_t>::max() );
+        rReport.rewrittenBytes = UpdateSourceBytes( vecObjects, parser.GetXRefOffset(), lLen );
+    }
+    else
+        rReport.rewrittenBytes = lLen;
+    rReport.selectSeconds = SecondsSince( start );
+
+    start = ReportClock::now();
+    rReport.capacityBits = writer.GetDictEncodeCapacity( &rReport.dictionaries );
+    rReport.capacity     = PayloadCapacity( rReport.capacityBits, m_bFramed );
+    rReport.countSeconds = SecondsSince( start );
+
+    return rReport.capacity;
+}
+
+size_t PdfIdCodec::Encode( const char* pDocument, size_t lLen,
+                           const char* pPayload, size_t lPayloadLen,
+                           PdfOutputDevice* pOutput ) const
+{
+    if( !pOutput || (!pPayload && lPayloadLen) )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    // the frame header holds a 32 bit length
+    if( m_bFramed && lPayloadLen > std::numeric_limits<pdf_uint32>::max() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "A framed payload cannot be longer than 4 GiB" );
+    }
+
+    PdfVecObjects vecObjects;
+    PdfParser     parser( &vecObjects );
+
+    vecObjects.SetAutoDelete( true );
+    ParseDocument( parser, pDocument, lLen );
+
+    PdfWriter writer( &parser );
+    SetupWriter( writer, m_nThreads );
+
+    std::string payload( pPayload ? pPayload : "", lPayloadLen );
+    if( m_bFramed )
+        payload = payload_frame( payload );
+
+    if( m_bIncremental )
+        SetupUpdate( parser, vecObjects, writer, payload.size() * 8 );
+
+    bit_istream i_bitstream( payload.data(), payload.size() );
+
+    bit_istream* pPrevious = pOutput->dictencode_stream;
+    pOutput->dictencode_stream = &i_bitstream;
+    try {
+        if( m_bIncremental )
+        {
+            // the original document is kept byte for byte,
+            // the update is appended after its last line
+            pOutput->Write( pDocument, lLen );
+            if( lLen && pDocument[lLen - 1] != '\n' && pDocument[lLen - 1] != '\r' )
+                pOutput->Print( "\n" );
+
+            writer.WriteUpdate( pOutput, NULL, false );
+        }
+        else
+            writer.Write( pOutput );
+    } catch( PdfError & e ) {
+        pOutput->dictencode_stream = pPrevious;
+        throw e;
+    }
+    pOutput->dictencode_stream = pPrevious;
+
+    // a cut frame claims more bytes than it holds, so decoding it only
+    // reports it truncated, and a frame cut in its header is no frame at
+    // all, even for an empty payload
+    if( m_bFramed && i_bitstream.bit_size < payload.size() * 8 )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_ValueOutOfRange, "The document cannot hold the framed payload" );
+    }
+
+    return PayloadCapacity( i_bitstream.bit_size, m_bFramed );
+}
+
+size_t PdfIdCodec::Encode( const char* pDocument, size_t lLen,
+                           const char* pPayload, size_t lPayloadLen,
+                           std::ostream & rOutput ) const
+{
+    PdfOutputDevice device( &rOutput );
+    return Encode( pDocument, lLen, pPayload, lPayloadLen, &device );
+}
+
+void PdfIdCodec::Decode( const char* pDocument, size_t lLen, std::ostream & rOutput ) const
+{
+    bit_ostream   o_bitstream( rOutput, m_bFramed );
+    PdfVecObjects vecObjects;
+    PdfParser     parser( &vecObjects );
+
+    vecObjects.SetAutoDelete( true );
+    parser.SetDecodeLastUpdate( m_bIncremental );
+
+    // on a single thread, objects are decoded as they are read, payload
+    // bits get written as soon as all the previous ones are known
+    parser.DecodeDictOrder( pDocument, static_cast<pdf_long>(lLen), o_bitstream, m_nThreads );
+    o_bitstream.flush();
+
+    // the parser advances the stream as objects get read, so pushing a
+    // dictionary it already went past means the payload got corrupted
+    if( o_bitstream.out_of_order() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_BrokenFile, "Dictionaries were decoded out of order" );
+    }
+
+    switch( o_bitstream.frame() )
+    {
+        case bit_ostream::frame_none:
+        case bit_ostream::frame_complete:
+            break;
+        case bit_ostream::frame_bad_magic:
+            PODOFO_RAISE_ERROR_INFO( ePdfError_BrokenFile, "The document does not hold a framed payload" );
+            break;
+        case bit_ostream::frame_bad_checksum:
+            PODOFO_RAISE_ERROR_INFO( ePdfError_BrokenFile, "The payload checksum does not match" );
+            break;
+        case bit_ostream::frame_header:
+        case bit_ostream::frame_payload:
+            PODOFO_RAISE_ERROR_INFO( ePdfError_BrokenFile, "The payload is truncated" );
+            break;
+    }
+}
+
+std::string PdfIdCodec::Decode( const char* pDocument, size_t lLen ) const
+{
+    std::ostringstream output;
+    Decode( pDocument, lLen, output );
+    return output.str();
+}
+
+};
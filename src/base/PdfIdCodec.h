@@ -0,0 +1,242 @@
+#ifndef _PDF_ID_CODEC_H_
+#define _PDF_ID_CODEC_H_
+
+#include "PdfDefines.h"
+#include "PdfWriter.h"
+
+#include <ostream>
+#include <string>
+
+namespace PoDoFo {
+
+class PdfOutputDevice;
+
+/** What PdfIdCodec::GetCapacity finds out about a document, to choose
+ *  carriers and predict what encoding them costs.
+ */
+struct PODOFO_API PdfIdCapacityReport {
+    PdfIdCapacityReport()
+        : capacity( 0 ), capacityBits( 0 ), rewrittenBytes( 0 ),
+          parseSeconds( 0.0 ), selectSeconds( 0.0 ), countSeconds( 0.0 )
+        {
+        }
+
+    /** The capacity in bytes, as GetCapacity returns it */
+    size_t              capacity;
+
+    /** The capacity in bits, frame header included */
+    size_t              capacityBits;
+
+    /** The bytes of the document an encoder rewrites: the whole document,
+     *  or the source of the objects an incremental update rewrites
+     */
+    size_t              rewrittenBytes;
+
+    /** Seconds spent parsing the document, choosing the objects an
+     *  incremental update rewrites, and counting their capacity
+     */
+    double              parseSeconds;
+    double              selectSeconds;
+    double              countSeconds;
+
+    /** The capacity of each object, and of the dictionaries holding it */
+    PdfDictEncodeReport dictionaries;
+};
+
+/** Hides data in the order of the keys of the dictionaries of a PDF
+ *  document, and recovers it.
+ *
+ *  Documents are read from buffers owned by the caller, without being
+ *  copied. Documents and payloads are written to a PdfOutputDevice or
+ *  an std::ostream the caller provides, so the caller decides where the
+ *  memory comes from.
+ *
+ *  A codec only holds its settings. It can be reused for any number of
+ *  documents, and used by several threads at once as long as its
+ *  settings don't change.
+ */
+class PODOFO_API PdfIdCodec {
+ public:
+    /** Create a codec for unframed payloads, running on the calling thread.
+     */
+    PdfIdCodec();
+
+    /** Frame payloads with their length and checksum.
+     *
+     *  Decoding a framed payload stops as soon as the payload is
+     *  complete, and checks it. A frame takes 12 bytes of capacity.
+     *
+     *  \param bFramed if true, payloads get framed
+     */
+    inline void SetFramed( bool bFramed );
+
+    /**
+     *  \returns true if payloads get framed
+     */
+    inline bool IsFramed() const;
+
+    /** Append the payload to documents as an incremental update.
+     *
+     *  The original document is left untouched: an update rewriting
+     *  just enough of its dictionaries to hold the payload is appended
+     *  to it, and only the dictionaries of the newest update are decoded.
+     *  Objects with a stream are never rewritten, so documents hold less
+     *  data this way. Encrypted documents and documents using XRef
+     *  streams are not supported.
+     *
+     *  \param bIncremental if true, payloads are written and read
+     *                      as incremental updates
+     */
+    inline void SetIncremental( bool bIncremental );
+
+    /**
+     *  \returns true if payloads are written and read as incremental updates
+     */
+    inline bool IsIncremental() const;
+
+    /** Set how many threads encode and decode documents.
+     *
+     *  \param nThreads 0 or 1 to only use the calling thread
+     *  \see PdfWriter::SetWriteThreads
+     *  \see PdfParser::DecodeDictOrder
+     */
+    inline void SetThreads( unsigned int nThreads );
+
+    /**
+     *  \returns how many threads encode and decode documents
+     */
+    inline unsigned int GetThreads() const;
+
+    /** Count the payload bytes a document can hold.
+     *
+     *  \param pDocument a PDF document in memory
+     *  \param lLen the length of the document
+     *
+     *  \returns the capacity in bytes, not counting the frame header
+     */
+    size_t GetCapacity( const char* pDocument, size_t lLen ) const;
+
+    /** Count the payload bytes a document can hold, and report the
+     *  details of its capacity.
+     *
+     *  \param pDocument a PDF document in memory
+     *  \param lLen the length of the document
+     *  \param rReport the details get written to this report
+     *
+     *  \returns the capacity in bytes, not counting the frame header
+     */
+    size_t GetCapacity( const char* pDocument, size_t lLen, PdfIdCapacityReport & rReport ) const;
+
+    /** Write a document with a payload hidden in it.
+     *
+     *  The document is written even if the payload does not fit: only
+     *  the beginning of the payload is hidden then. A framed payload
+     *  has to fit whole though, frame header included, even if it is
+     *  empty: otherwise an error is raised once the document was
+     *  written, as its frame could not be read back from it. A framed
+     *  payload cannot be longer than 4 GiB, the frame header holding
+     *  a 32 bit length.
+     *
+     *  \param pDocument a PDF document in memory
+     *  \param lLen the length of the document
+     *  \param pPayload the data to hide
+     *  \param lPayloadLen the length of the data to hide
+     *  \param pOutput the document gets written to this device
+     *
+     *  \returns the capacity of the document in bytes, not counting the
+     *           frame header. The whole payload was hidden if it is not
+     *           longer than that, which is always the case when framed. Incremental updates only rewrite the
+     *           dictionaries the payload needs, so their capacity can be
+     *           less than GetCapacity.
+     */
+    size_t Encode( const char* pDocument, size_t lLen,
+                   const char* pPayload, size_t lPayloadLen,
+                   PdfOutputDevice* pOutput ) const;
+
+    /** Write a document with a payload hidden in it to a stream.
+     *
+     *  \see Encode
+     */
+    size_t Encode( const char* pDocument, size_t lLen,
+                   const char* pPayload, size_t lPayloadLen,
+                   std::ostream & rOutput ) const;
+
+    /** Recover the payload hidden in a document.
+     *
+     *  Unframed payloads carry no length: every bit the document holds
+     *  is written, including the ones past the end of the hidden data.
+     *
+     *  Raises ePdfError_BrokenFile if the dictionaries could not be
+     *  decoded in order, or if a framed payload is missing, truncated
+     *  or damaged.
+     *
+     *  \param pDocument a PDF document in memory
+     *  \param lLen the length of the document
+     *  \param rOutput the payload gets written to this stream
+     */
+    void Decode( const char* pDocument, size_t lLen, std::ostream & rOutput ) const;
+
+    /** Recover the payload hidden in a document.
+     *
+     *  \see Decode
+     *  \returns the payload
+     */
+    std::string Decode( const char* pDocument, size_t lLen ) const;
+
+ private:
+    bool         m_bFramed;
+    bool         m_bIncremental;
+    unsigned int m_nThreads;
+};
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfIdCodec::SetFramed( bool bFramed )
+{
+    m_bFramed = bFramed;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfIdCodec::IsFramed() const
+{
+    return m_bFramed;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfIdCodec::SetIncremental( bool bIncremental )
+{
+    m_bIncremental = bIncremental;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfIdCodec::IsIncremental() const
+{
+    return m_bIncremental;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfIdCodec::SetThreads( unsigned int nThreads )
+{
+    m_nThreads = nThreads;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfIdCodec::GetThreads() const
+{
+    return m_nThreads;
+}
+
+};
+
+#endif // _PDF_ID_CODEC_H_
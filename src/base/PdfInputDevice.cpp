@@ -34,12 +34,21 @@
 #include "PdfInputDevice.h"
 
 #include <cstdarg>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include "PdfDefinesPrivate.h"
+#include "PdfOutputDevice.h"
 
 namespace PoDoFo {
 
+// Files and streams are first read in small blocks, as the parser often
+// seeks to read a single object. The blocks grow while they are read
+// sequentially, up to the size of the read buffer.
+static const size_t s_lMinFillSize = 4096;
+static const size_t s_lMaxFillSize = 65536;
+
 PdfInputDevice::PdfInputDevice()
 {
     this->Init();
@@ -62,6 +71,9 @@ PdfInputDevice::PdfInputDevice( const char* pszFilename )
             PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
         }
         m_StreamOwned = true;
+
+        // the file is read through our own read buffer
+        setvbuf( m_pFile, NULL, _IONBF, 0 );
     }
     catch(...) {
         // should probably check the exact error, but for now it's a good error
@@ -135,6 +147,9 @@ PdfInputDevice::PdfInputDevice( const std::istream* pInStream )
         PODOFO_RAISE_ERROR( ePdfError_FileNotFound );
     }
 
+    // the stream may not be at its beginning, or not know where it is
+    m_lFillOffset = PDF_MAX( static_cast<std::streamoff>(m_pStream->tellg()), static_cast<std::streamoff>(0) );
+
     PdfLocaleImbue(*m_pStream);
 }
 
@@ -154,6 +169,8 @@ PdfInputDevice::~PdfInputDevice()
             fclose(m_pFile);
         }
     }
+
+    podofo_free( m_pFillBuffer );
 }
 
 void PdfInputDevice::Init()
@@ -163,6 +180,15 @@ void PdfInputDevice::Init()
     m_StreamOwned = false;
     m_bIsSeekable = true;
     dictdecode_stream = nullptr;
+
+    m_pReadPos    = NULL;
+    m_pReadEnd    = NULL;
+    m_pStableBegin = NULL;
+    m_pStableEnd   = NULL;
+    m_pFillBuffer = NULL;
+    m_lFillSize   = s_lMinFillSize;
+    m_lFillOffset = 0;
+    m_bEof        = false;
 }
 
 void PdfInputDevice::Close()
@@ -170,63 +196,73 @@ void PdfInputDevice::Close()
     // nothing to do here, but maybe necessary for inheriting classes
 }
 
-int PdfInputDevice::GetChar() const
+bool PdfInputDevice::Underflow() const
 {
-	if (m_pStream)
-    {
-        return m_pStream->get();
-    }
+    if( !m_pStream && !m_pFile )
+        return false;
 
-	if (m_pFile)
+    if( !m_pFillBuffer )
     {
-		return fgetc(m_pFile);
+        m_pFillBuffer = static_cast<char*>(podofo_malloc( s_lMaxFillSize ));
+        if( !m_pFillBuffer )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+        }
+        m_pReadPos = m_pReadEnd = m_pFillBuffer;
     }
-
-	return 0;
-}
-
-int PdfInputDevice::Look() const
-{
-    if (m_pStream)
+    else if( m_pReadEnd != m_pFillBuffer )
     {
-        return m_pStream->peek();
+        // the previous block was read up to its end
+        m_lFillSize = PDF_MIN( m_lFillSize * 2, s_lMaxFillSize );
     }
 
-    if (m_pFile)
+    const std::streamoff lOffset = m_lFillOffset + (m_pReadEnd - m_pFillBuffer);
+    size_t               lRead;
+    if( m_pStream )
     {
-        pdf_long lOffset = ftello( m_pFile );
-
-        if( lOffset == -1 )
+        // a stream that failed to seek stays failed, as it is somewhere else
+        lRead = 0;
+        if( m_pStream->good() )
         {
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to read the current file position" );
-        }
+            m_pStream->read( m_pFillBuffer, m_lFillSize );
+            lRead = static_cast<size_t>(m_pStream->gcount());
 
-        int ch = GetChar();
-
-        if( fseeko( m_pFile, lOffset, SEEK_SET ) == -1 )
-        {
-            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek back to the previous position" );
+            // keep the stream usable after reading up to its end
+            if( !m_pStream->bad() )
+                m_pStream->clear();
         }
+    }
+    else
+        lRead = fread( m_pFillBuffer, 1, m_lFillSize, m_pFile );
 
-        return ch;
+    m_lFillOffset = lOffset;
+    this->SetReadBuffer( m_pFillBuffer, m_pFillBuffer + lRead );
+    if( !lRead )
+    {
+        m_bEof = true;
+        return false;
     }
 
-    return 0;
+    return true;
 }
 
-std::streamoff PdfInputDevice::Tell() const
+std::streamsize PdfInputDevice::ReadFromBuffer( char* pBuffer, std::streamsize lLen ) const
 {
-	if (m_pStream)
-    {
-        return m_pStream->tellg();
-    }
+    const std::streamsize lRead = PDF_MIN( static_cast<std::streamsize>(this->GetReadBufferLength()), lLen );
+    if( lRead <= 0 )
+        return 0;
 
-	if (m_pFile)
-    {
-		return ftello(m_pFile);
-    }
+    memcpy( pBuffer, m_pReadPos, static_cast<size_t>(lRead) );
+    m_pReadPos += lRead;
+    return lRead;
+}
 
-	return 0;
+std::streamoff PdfInputDevice::Tell() const
+{
+    if( !m_pStream && !m_pFile )
+        return 0;
+
+    return m_lFillOffset + (m_pReadPos - m_pFillBuffer);
 }
 /*
 void PdfInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
@@ -242,27 +278,48 @@ void PdfInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
 {
     if (m_bIsSeekable)
     {
-        if (m_pStream)
+        if( !m_pStream && !m_pFile )
+            return;
+
+        // seeking inside the read buffer only moves in it
+        const std::streamoff lPos = dir == std::ios_base::cur ? this->Tell() + off : off;
+        if( dir != std::ios_base::end && lPos >= m_lFillOffset
+            && lPos <= m_lFillOffset + (m_pReadEnd - m_pFillBuffer) )
         {
-            m_pStream->seekg( off, dir );
+            m_pReadPos = m_pFillBuffer + (lPos - m_lFillOffset);
+            m_bEof     = false;
+            return;
         }
 
-        if (m_pFile)
+        std::streamoff lNewOffset = lPos;
+        if (m_pStream)
         {
-            int whence;
+            if( dir == std::ios_base::end )
+                m_pStream->seekg( off, dir );
+            else
+                m_pStream->seekg( lPos );
 
-            if( dir == std::ios_base::beg )
-                whence = SEEK_SET;
-            else if( dir == std::ios_base::cur )
-                whence = SEEK_CUR;
-            else // if( dir == std::ios_base::end )
-                whence = SEEK_END;
+            if( dir == std::ios_base::end )
+                lNewOffset = m_pStream->tellg();
+        }
 
-            if( fseeko( m_pFile, off, whence ) == -1)
+        if (m_pFile)
+        {
+            if( fseeko( m_pFile, dir == std::ios_base::end ? off : lPos,
+                        dir == std::ios_base::end ? SEEK_END : SEEK_SET ) == -1)
             {
                 PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to seek to given position in the file" );
             }
+
+            if( dir == std::ios_base::end )
+                lNewOffset = ftello( m_pFile );
         }
+
+        // the read buffer is empty, and starts at the new position
+        m_lFillOffset = lNewOffset;
+        m_lFillSize   = s_lMinFillSize;
+        m_bEof        = false;
+        this->SetReadBuffer( m_pFillBuffer, m_pFillBuffer );
     }
     else
     {
@@ -273,14 +330,69 @@ void PdfInputDevice::Seek( std::streamoff off, std::ios_base::seekdir dir )
 
 std::streamoff PdfInputDevice::Read( char* pBuffer, std::streamsize lLen )
 {
+    const std::streamsize lBuffered = this->ReadFromBuffer( pBuffer, lLen );
+    if( lBuffered == lLen || (!m_pStream && !m_pFile) )
+        return lBuffered;
+
+    // the rest goes straight to the caller's buffer
+    const std::streamoff lOffset = m_lFillOffset + (m_pReadEnd - m_pFillBuffer);
+    std::streamsize      lRead;
 	if (m_pStream) {
-        m_pStream->read( pBuffer, lLen );
-        return m_pStream->gcount();
+        lRead = 0;
+        if( m_pStream->good() )
+        {
+            m_pStream->read( pBuffer + lBuffered, lLen - lBuffered );
+            lRead = m_pStream->gcount();
+            if( !m_pStream->bad() )
+                m_pStream->clear();
+        }
 	}
 	else
 	{
-		return fread(pBuffer, 1, lLen, m_pFile);
+		lRead = fread( pBuffer + lBuffered, 1, lLen - lBuffered, m_pFile );
 	}
+
+    if( lRead < lLen - lBuffered )
+        m_bEof = true;
+
+    m_lFillOffset = lOffset + lRead;
+    this->SetReadBuffer( m_pFillBuffer, m_pFillBuffer );
+    return lBuffered + lRead;
+}
+
+void PdfInputDevice::CopyTo( PdfOutputDevice* pDevice, std::streamoff lOffset, pdf_long lLen )
+{
+    if( !pDevice )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    pdf_long lCopied = 0;
+
+    // between two files, the output device lets the kernel copy what it can
+    if( m_pFile && lLen > 0 )
+        lCopied = pDevice->CopyFrom( fileno( m_pFile ), lOffset, lLen );
+
+    // whatever is left goes through a buffer of bounded size
+    const pdf_long    lChunkSize = 65536;
+    std::vector<char> buffer;
+
+    this->Seek( lOffset + lCopied );
+    while( lCopied < lLen )
+    {
+        if( buffer.empty() )
+            buffer.resize( static_cast<size_t>(PDF_MIN( lChunkSize, lLen - lCopied )) );
+
+        std::streamoff lRead = this->Read( &buffer[0], PDF_MIN( static_cast<pdf_long>(buffer.size()), lLen - lCopied ) );
+        if( lRead <= 0 )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "The range to copy goes past the end of the device" );
+        }
+
+        pDevice->Write( &buffer[0], static_cast<size_t>(lRead) );
+        lCopied += lRead;
+    }
+    this->Seek( lOffset + lLen );
 }
 
 }; // namespace PoDoFo
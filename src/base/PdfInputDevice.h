@@ -45,12 +45,18 @@
 
 namespace PoDoFo {
 
+class PdfOutputDevice;
+
 /** This class provides an Input device which operates
  *  either on a file, a buffer in memory or any arbitrary std::istream
  *
  *  This class is suitable for inheritance to provide input
  *  devices of your own for PoDoFo.
  *  Just overide the required virtual methods.
+ *
+ *  GetChar() and Look() read from a buffer held by this class and
+ *  are final: subclasses which overrode them have to provide their
+ *  bytes by overriding Underflow() instead.
  */
 class PODOFO_API PdfInputDevice {
  public:
@@ -105,14 +111,57 @@ class PODOFO_API PdfInputDevice {
     virtual std::streamoff Tell() const;
 
     /** Get next char from stream.
+     *
+     *  Reads from the read buffer, and only calls Underflow() when
+     *  all of it was read.
+     *
      *  \returns the next character from the stream
+     *
+     *  \see Underflow
      */
-    virtual int GetChar() const;
+    inline virtual int GetChar() const final;
 
     /** Peek at next char in stream.
+     *
+     *  Reads from the read buffer, and only calls Underflow() when
+     *  all of it was read.
+     *
      *  /returns the next char in the stream
+     *
+     *  \see Underflow
+     */
+    inline virtual int Look() const final;
+
+    /** The bytes GetChar() returns next, which were already read from
+     *  the device. Scanners can search them in place, then skip what
+     *  they consumed with SkipReadBuffer(). Look() refills them once
+     *  they were all read.
+     *
+     *  \returns the first of GetReadBufferLength() bytes
+     */
+    PODOFO_NOTHROW inline const char* GetReadBuffer() const;
+
+    /**
+     * \returns the number of bytes in the read buffer that have not been read yet
      */
-    virtual int Look() const;
+    PODOFO_NOTHROW inline size_t GetReadBufferLength() const;
+
+    /** Consume bytes of the read buffer, as GetChar() would.
+     *
+     *  \param lLen number of bytes to skip, at most GetReadBufferLength()
+     */
+    PODOFO_NOTHROW inline void SkipReadBuffer( size_t lLen ) const;
+
+    /** Whether memory read by the device stays valid and unchanged
+     *  as long as the device lives, like the buffer of a
+     *  PdfBufferInputDevice. Pointers into such a read buffer can be
+     *  kept after reading on, instead of copying the bytes.
+     *
+     *  \param pBuffer first byte of the memory
+     *  \param lLen    number of bytes of the memory
+     *  \returns true if all of the memory is held by the device for its whole life
+     */
+    PODOFO_NOTHROW inline bool IsStableBuffer( const char* pBuffer, size_t lLen ) const;
 
     /** Seek the device to the position offset from the begining
      *  \param off from the beginning of the file
@@ -133,6 +182,21 @@ class PODOFO_API PdfInputDevice {
      */
     virtual std::streamoff Read( char* pBuffer, std::streamsize lLen );
 
+    /** Copy a range of bytes of the input device to an output device,
+     *  in large chunks, without going through a PdfStream.
+     *
+     *  If both devices are files, the kernel copies the bytes itself
+     *  when it can. The device is positioned after the range afterwards.
+     *
+     *  Throws ePdfError_UnexpectedEOF if the range goes past the end
+     *  of the device.
+     *
+     *  \param pDevice the bytes are written to this device
+     *  \param lOffset position of the first byte to copy
+     *  \param lLen    number of bytes to copy
+     */
+    virtual void CopyTo( PdfOutputDevice* pDevice, std::streamoff lOffset, pdf_long lLen );
+
     /**
      * \return True if the stream is at EOF
      */
@@ -166,7 +230,48 @@ class PODOFO_API PdfInputDevice {
      */
     PdfInputDevice();
 
+    /** Called by GetChar() and Look() once the read buffer was read:
+     *  makes the next bytes of the device available with SetReadBuffer().
+     *
+     *  Subclasses providing their own input override this, along with Tell(),
+     *  Seek() and Read(), which have to account for the bytes still in the
+     *  read buffer: the device is positioned at the end of the read buffer.
+     *
+     *  \returns false at the end of the device
+     */
+    virtual bool Underflow() const;
+
+    /** Set the bytes GetChar() and Look() read next, which are NOT copied.
+     *  They have to stay valid until the next call to SetReadBuffer().
+     *
+     *  \param pBegin first byte to read
+     *  \param pEnd end of the bytes to read
+     */
+    PODOFO_NOTHROW inline void SetReadBuffer( const char* pBegin, const char* pEnd ) const;
+
+    /** Take bytes from the read buffer, as the first step of Read().
+     *
+     *  \param pBuffer store bytes in this buffer
+     *  \param lLen    number of bytes to read at most
+     *  \returns the number of bytes taken from the read buffer
+     */
+    std::streamsize ReadFromBuffer( char* pBuffer, std::streamsize lLen ) const;
+
+    /** Declare memory which stays valid and unchanged as long as the device,
+     *  and which all read buffers of the device are part of.
+     *
+     *  \param pBegin first byte of the memory
+     *  \param pEnd end of the memory
+     *
+     *  \see IsStableBuffer
+     */
+    PODOFO_NOTHROW inline void SetStableBuffer( const char* pBegin, const char* pEnd );
+
  public:
+    /** Receives the ranks of the dictionaries the parser reads.
+     *  When it holds a framed payload, PdfParser::DecodeDictOrder stops reading
+     *  objects as soon as the payload is complete.
+     */
     bit_ostream *dictdecode_stream;
 
  private:
@@ -179,8 +284,72 @@ class PODOFO_API PdfInputDevice {
 	  FILE *				m_pFile;
     bool          m_StreamOwned;
     bool          m_bIsSeekable;
+
+    // The bytes GetChar() and Look() read next
+    mutable const char*    m_pReadPos;
+    mutable const char*    m_pReadEnd;
+
+    // The memory held by the device for its whole life, if any
+    const char*            m_pStableBegin;
+    const char*            m_pStableEnd;
+
+    // The buffer files and streams are read through, which grows while
+    // they are read sequentially, and where it starts in the device
+    mutable char*          m_pFillBuffer;
+    mutable size_t         m_lFillSize;
+    mutable std::streamoff m_lFillOffset;
+    mutable bool           m_bEof;
 };
 
+int PdfInputDevice::GetChar() const
+{
+    if( m_pReadPos == m_pReadEnd && !this->Underflow() )
+        return EOF;
+
+    return static_cast<unsigned char>(*m_pReadPos++);
+}
+
+int PdfInputDevice::Look() const
+{
+    if( m_pReadPos == m_pReadEnd && !this->Underflow() )
+        return EOF;
+
+    return static_cast<unsigned char>(*m_pReadPos);
+}
+
+void PdfInputDevice::SetReadBuffer( const char* pBegin, const char* pEnd ) const
+{
+    m_pReadPos = pBegin;
+    m_pReadEnd = pEnd;
+}
+
+const char* PdfInputDevice::GetReadBuffer() const
+{
+    return m_pReadPos;
+}
+
+size_t PdfInputDevice::GetReadBufferLength() const
+{
+    return static_cast<size_t>(m_pReadEnd - m_pReadPos);
+}
+
+void PdfInputDevice::SkipReadBuffer( size_t lLen ) const
+{
+    m_pReadPos += lLen;
+}
+
+bool PdfInputDevice::IsStableBuffer( const char* pBuffer, size_t lLen ) const
+{
+    return m_pStableBegin && pBuffer >= m_pStableBegin
+        && lLen <= static_cast<size_t>(m_pStableEnd - pBuffer);
+}
+
+void PdfInputDevice::SetStableBuffer( const char* pBegin, const char* pEnd )
+{
+    m_pStableBegin = pBegin;
+    m_pStableEnd   = pEnd;
+}
+
 bool PdfInputDevice::IsSeekable() const
 {
     return m_bIsSeekable;
@@ -200,15 +369,14 @@ bool PdfInputDevice::Bad() const
 
 bool PdfInputDevice::Eof() const
 {
-    if (m_pStream)
-        return m_pStream->eof();
-    if (m_pFile)
-        return feof(m_pFile) != 0;
+    if (m_pStream || m_pFile)
+        return m_bEof;
     return true;
 }
 
 void PdfInputDevice::Clear(std::ios_base::iostate state) const
 {
+    m_bEof = (state & std::ios_base::eofbit) != 0;
     if (m_pStream)
         m_pStream->clear(state);
 }
@@ -0,0 +1,125 @@
+#include "PdfMappedInputDevice.h"
+
+#include "PdfDefinesPrivate.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace PoDoFo {
+
+#ifdef _WIN32
+
+PdfMappedInputDevice::PdfMappedInputDevice( const char* pszFilename )
+    : PdfBufferInputDevice( "", 0 ), m_pMapping( NULL ), m_hMapping( NULL )
+{
+    if( !pszFilename )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    HANDLE hFile = CreateFileA( pszFilename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+    if( hFile == INVALID_HANDLE_VALUE )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
+    }
+
+    LARGE_INTEGER lSize;
+    if( GetFileType( hFile ) != FILE_TYPE_DISK || !GetFileSizeEx( hFile, &lSize ) )
+    {
+        CloseHandle( hFile );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Only regular files can be mapped" );
+    }
+
+    // an empty file cannot be mapped, and reads as an empty buffer
+    if( lSize.QuadPart )
+    {
+        m_hMapping = CreateFileMappingA( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+        if( m_hMapping )
+            m_pMapping = MapViewOfFile( m_hMapping, FILE_MAP_READ, 0, 0, 0 );
+    }
+    CloseHandle( hFile );
+
+    if( lSize.QuadPart && !m_pMapping )
+    {
+        if( m_hMapping )
+            CloseHandle( m_hMapping );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Failed to map the file in memory" );
+    }
+
+    if( m_pMapping )
+    {
+        m_pBuffer = static_cast<const char*>(m_pMapping);
+        m_lLen    = static_cast<size_t>(lSize.QuadPart);
+        this->Seek( 0 );
+    }
+}
+
+PdfMappedInputDevice::~PdfMappedInputDevice()
+{
+    if( m_pMapping )
+        UnmapViewOfFile( m_pMapping );
+    if( m_hMapping )
+        CloseHandle( m_hMapping );
+}
+
+#else
+
+PdfMappedInputDevice::PdfMappedInputDevice( const char* pszFilename )
+    : PdfBufferInputDevice( "", 0 ), m_pMapping( NULL )
+{
+    if( !pszFilename )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    int fd = open( pszFilename, O_RDONLY );
+    if( fd == -1 )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_FileNotFound, pszFilename );
+    }
+
+    struct stat st;
+    if( fstat( fd, &st ) == -1 || !S_ISREG( st.st_mode ) )
+    {
+        close( fd );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, "Only regular files can be mapped" );
+    }
+
+    // an empty file cannot be mapped, and reads as an empty buffer
+    if( st.st_size )
+    {
+        void* pMapping = mmap( NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( pMapping == MAP_FAILED )
+        {
+            int nErrno = errno;
+            close( fd );
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDeviceOperation, strerror( nErrno ) );
+        }
+
+        m_pMapping = pMapping;
+        m_pBuffer  = static_cast<const char*>(pMapping);
+        m_lLen     = static_cast<size_t>(st.st_size);
+        this->Seek( 0 );
+    }
+
+    // the mapping stays valid once the file is closed
+    close( fd );
+}
+
+PdfMappedInputDevice::~PdfMappedInputDevice()
+{
+    if( m_pMapping )
+        munmap( m_pMapping, m_lLen );
+}
+
+#endif // _WIN32
+
+};
@@ -0,0 +1,44 @@
+#ifndef _PDF_MAPPED_INPUT_DEVICE_H_
+#define _PDF_MAPPED_INPUT_DEVICE_H_
+
+#include "PdfDefines.h"
+#include "PdfBufferInputDevice.h"
+
+namespace PoDoFo {
+
+/** An input device reading a file mapped in memory.
+ *
+ *  Reading is a walk over the mapping, without any copy or stream
+ *  buffer in between. Only regular files can be mapped: pipes and
+ *  other special files have to be read using PdfInputDevice.
+ *
+ *  The file must not be truncated while it is mapped.
+ */
+class PODOFO_API PdfMappedInputDevice : public PdfBufferInputDevice {
+ public:
+    /** Construct a new PdfMappedInputDevice mapping a file.
+     *
+     *  \param pszFilename the path of a regular file
+     */
+    PdfMappedInputDevice( const char* pszFilename );
+
+    /** Unmap the file.
+     */
+    virtual ~PdfMappedInputDevice();
+
+ private:
+    /** Disallow copying, as the mapping is owned by the device
+     */
+    PdfMappedInputDevice( const PdfMappedInputDevice & rhs );
+    const PdfMappedInputDevice & operator=( const PdfMappedInputDevice & rhs );
+
+ private:
+    void*           m_pMapping;
+#ifdef _WIN32
+    void*           m_hMapping;
+#endif // _WIN32
+};
+
+};
+
+#endif // _PDF_MAPPED_INPUT_DEVICE_H_
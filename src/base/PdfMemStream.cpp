@@ -69,7 +69,7 @@ void PdfMemStream::BeginAppendImpl( const TVecFilters & vecFilters )
     if( vecFilters.size() )
     {
         m_pBufferStream = new PdfBufferOutputStream( &m_buffer );
-        m_pStream       = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream );
+        m_pStream       = PdfFilterFactory::CreateEncodeStream( vecFilters, m_pBufferStream, this->GetFlateParameters() );
     }
     else 
         m_pStream = new PdfBufferOutputStream( &m_buffer );
@@ -138,7 +138,7 @@ void PdfMemStream::GetCopy(PdfOutputStream * pStream) const
 	pStream->Write(m_buffer.GetBuffer(), m_lLength);
 }
 
-void PdfMemStream::FlateCompress()
+void PdfMemStream::FlateCompress( const PdfFlateParameters* pDefaults )
 {
     PdfObject*        pObj;
     PdfVariant        vFilter( PdfName("FlateDecode" ) );
@@ -147,6 +147,8 @@ void PdfMemStream::FlateCompress()
 
     PdfArray::const_iterator tciFilters;
     
+    const PdfFlateParameters* pParameters = this->GetFlateParameters() ? this->GetFlateParameters() : pDefaults;
+
     if( !m_lLength )
         return; // ePdfError_ErrOk
 
@@ -198,12 +200,12 @@ void PdfMemStream::FlateCompress()
         vFilterList = PdfVariant( tFilters );
         m_pParent->GetDictionary().AddKey( "Filter", vFilterList );
 
-        FlateCompressStreamData(); // throws an exception on error
+        FlateCompressStreamData( pParameters ); // throws an exception on error
     }
     else
     {
         m_pParent->GetDictionary().AddKey( "Filter", PdfName( "FlateDecode" ) );
-        FlateCompressStreamData();
+        FlateCompressStreamData( pParameters );
     }
 }
 
@@ -237,7 +239,7 @@ void PdfMemStream::Uncompress()
     }
 }
 
-void PdfMemStream::FlateCompressStreamData()
+void PdfMemStream::FlateCompressStreamData( const PdfFlateParameters* pParameters )
 {
     char*            pBuffer;
     pdf_long             lLen;
@@ -245,11 +247,22 @@ void PdfMemStream::FlateCompressStreamData()
     if( !m_lLength )
         return;
 
-    std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_FlateDecode );
+    std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_FlateDecode, pParameters );
     if( pFilter.get() )
     {
-        pFilter->Encode( m_buffer.GetBuffer(), m_buffer.GetSize(), &pBuffer, &lLen );
-        this->Set( pBuffer, lLen );
+        // the buffer may be larger than the stream
+        pFilter->Encode( m_buffer.GetBuffer(), m_lLength, &pBuffer, &lLen );
+
+        // the data is encoded already, and FlateCompress() set the /Filter key
+        try {
+            this->BeginAppend( TVecFilters(), true, false );
+            this->Append( pBuffer, lLen );
+            this->EndAppend();
+        } catch( PdfError & e ) {
+            podofo_free( pBuffer );
+            throw e;
+        }
+        podofo_free( pBuffer );
     }
     else
     {
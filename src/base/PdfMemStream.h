@@ -125,8 +125,13 @@ class PODOFO_API PdfMemStream : public PdfStream {
      *  using the FlateDecode(ZIP) algorithm. JPEG compressed streams
      *  will not be compressed again using this function.
      *  Entries to the filter dictionary will be added if necessary.
+     *
+     *  \param pDefaults the Flate parameters to use if the stream
+     *         has none, or NULL for the defaults of zlib
+     *
+     *  \see SetFlateParameters
      */
-    void FlateCompress();
+    void FlateCompress( const PdfFlateParameters* pDefaults = NULL );
 
     /** This method removes all filters from the stream
      */
@@ -179,8 +184,10 @@ class PODOFO_API PdfMemStream : public PdfStream {
  private:
     /** Compress the current data using the FlateDecode (zlib) algorithm
      *  Expects that all filters are setup correctly.
+     *
+     *  \param pParameters the Flate parameters, or NULL for the defaults
      */
-    void FlateCompressStreamData();
+    void FlateCompressStreamData( const PdfFlateParameters* pParameters );
 
 
  private:
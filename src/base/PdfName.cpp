@@ -37,7 +37,10 @@
 #include "PdfTokenizer.h"
 #include "PdfDefinesPrivate.h"
 
+#include "util/PdfMutexWrapper.h"
+
 #include <string.h>
+#include <vector>
 
 using PoDoFo::ePdfError_InvalidName;
 
@@ -155,6 +158,248 @@ static std::string UnescapeName(T it, size_t length)
 
 namespace PoDoFo {
 
+namespace {
+
+/** The table of all the name atoms. It is split in shards with their
+ *  own lock, so that threads parsing documents rarely wait for each
+ *  other. Each shard is an open addressing hash table.
+ *
+ *  Atoms are counted references: interning a name takes a reference
+ *  under the shard lock, and the last reference is only dropped under
+ *  that lock too, so an atom is never found while it is being freed.
+ */
+/** The keys found in almost every document, whose atoms are immortal
+ */
+const char* const s_pszImmortalNames[] = {
+    "", "Annots", "BaseFont", "BBox", "Contents", "Count", "DecodeParms",
+    "Encoding", "Filter", "First", "Flags", "Font", "FontDescriptor",
+    "Height", "Kids", "Length", "MediaBox", "N", "Page", "Pages", "Parent",
+    "ProcSet", "Rect", "Resources", "Root", "Size", "Subtype", "Type",
+    "W", "Width", "Widths", "XObject", "XRef"
+};
+
+template<typename TAtom>
+class PdfNameTable {
+ public:
+    PdfNameTable()
+        : m_shards( 16 )
+    {
+        for( size_t i = 0; i < sizeof(s_pszImmortalNames) / sizeof(s_pszImmortalNames[0]); i++ )
+        {
+            const size_t lLen  = strlen( s_pszImmortalNames[i] );
+            TAtom*       pAtom = const_cast<TAtom*>(this->Intern( s_pszImmortalNames[i], lLen,
+                                                                  Hash( s_pszImmortalNames[i], lLen ) ));
+            pAtom->bImmortal = true;
+        }
+    }
+
+    const TAtom* Intern( const char* pszName, size_t lLen, size_t nHash )
+    {
+        TShard &     rShard = m_shards[nHash % m_shards.size()];
+
+        Util::PdfMutexWrapper wrapper( rShard.mutex );
+        if( (rShard.nCount + 1) * 2 > rShard.vecSlots.size() )
+            Grow( rShard );
+
+        const size_t nMask = rShard.vecSlots.size() - 1;
+        for( size_t i = (nHash / m_shards.size()) & nMask;; i = (i + 1) & nMask )
+        {
+            TSlot & rSlot = rShard.vecSlots[i];
+            if( !rSlot.pAtom )
+            {
+                rSlot.pAtom = NewAtom( pszName, lLen, nHash );
+                rSlot.nHash = nHash;
+                ++rShard.nCount;
+                return rSlot.pAtom;
+            }
+
+            if( rSlot.nHash == nHash && rSlot.pAtom->name.length() == lLen
+                && memcmp( rSlot.pAtom->name.data(), pszName, lLen ) == 0 )
+            {
+                if( !rSlot.pAtom->bImmortal )
+                    rSlot.pAtom->nRefs.fetch_add( 1, std::memory_order_relaxed );
+                return rSlot.pAtom;
+            }
+        }
+    }
+
+    /** Drop a reference to an atom, and free the atom if no other
+     *  reference is left
+     */
+    void ReleaseLast( const TAtom* pAtom )
+    {
+        if( pAtom->bImmortal )
+            return;
+
+        TShard & rShard = m_shards[pAtom->nHash % m_shards.size()];
+
+        Util::PdfMutexWrapper wrapper( rShard.mutex );
+        if( pAtom->nRefs.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+            return;
+
+        // the atom is in the shard, as it was interned there
+        const size_t nMask = rShard.vecSlots.size() - 1;
+        size_t       i     = (pAtom->nHash / m_shards.size()) & nMask;
+        while( rShard.vecSlots[i].pAtom != pAtom )
+            i = (i + 1) & nMask;
+
+        // move back the slots probed past the hole, so that
+        // lookups never stop early at an empty slot
+        for( size_t j = (i + 1) & nMask; rShard.vecSlots[j].pAtom; j = (j + 1) & nMask )
+        {
+            const size_t nHome = (rShard.vecSlots[j].nHash / m_shards.size()) & nMask;
+            const bool   bStay = i <= j ? (i < nHome && nHome <= j) : (i < nHome || nHome <= j);
+            if( !bStay )
+            {
+                rShard.vecSlots[i] = rShard.vecSlots[j];
+                i = j;
+            }
+        }
+        rShard.vecSlots[i] = TSlot();
+        --rShard.nCount;
+
+        delete pAtom;
+    }
+
+    size_t GetCount()
+    {
+        size_t nCount = 0;
+        for( size_t i = 0; i < m_shards.size(); i++ )
+        {
+            Util::PdfMutexWrapper wrapper( m_shards[i].mutex );
+            nCount += m_shards[i].nCount;
+        }
+        return nCount;
+    }
+
+    // FNV-1a
+    static size_t Hash( const char* pszName, size_t lLen )
+    {
+        pdf_uint64 nHash = 0xcbf29ce484222325ULL;
+        for( size_t i = 0; i < lLen; i++ )
+            nHash = (nHash ^ static_cast<unsigned char>(pszName[i])) * 0x100000001b3ULL;
+        return static_cast<size_t>(nHash);
+    }
+
+ private:
+    struct TSlot {
+        TSlot()
+            : pAtom( NULL ), nHash( 0 )
+        {
+        }
+
+        const TAtom* pAtom;
+        size_t       nHash;
+    };
+
+    struct TShard {
+        TShard()
+            : nCount( 0 )
+        {
+        }
+
+        Util::PdfMutex     mutex;
+        std::vector<TSlot> vecSlots;
+        size_t             nCount;
+    };
+
+    static const TAtom* NewAtom( const char* pszName, size_t lLen, size_t nHash )
+    {
+        TAtom* pAtom = new TAtom();
+        pAtom->name.assign( pszName, lLen );
+        pAtom->sortKey = 0;
+        for( size_t i = 0; i < 8; i++ )
+            pAtom->sortKey = (pAtom->sortKey << 8) | (i < lLen ? static_cast<unsigned char>(pszName[i]) : 0);
+        pAtom->nHash = nHash;
+        pAtom->nRefs.store( 1, std::memory_order_relaxed );
+        pAtom->bImmortal = false;
+        return pAtom;
+    }
+
+    void Grow( TShard & rShard )
+    {
+        std::vector<TSlot> vecSlots( PDF_MAX( static_cast<size_t>(64), rShard.vecSlots.size() * 2 ) );
+        const size_t       nMask = vecSlots.size() - 1;
+        for( size_t i = 0; i < rShard.vecSlots.size(); i++ )
+        {
+            const TSlot & rSlot = rShard.vecSlots[i];
+            if( !rSlot.pAtom )
+                continue;
+
+            size_t j = (rSlot.nHash / m_shards.size()) & nMask;
+            while( vecSlots[j].pAtom )
+                j = (j + 1) & nMask;
+            vecSlots[j] = rSlot;
+        }
+        rShard.vecSlots.swap( vecSlots );
+    }
+
+    std::vector<TShard> m_shards;
+};
+
+template<typename TAtom>
+PdfNameTable<TAtom> & GetNameTable()
+{
+    // never destroyed, as names may be used by other static objects
+    // until the very end of the process
+    static PdfNameTable<TAtom>* s_pTable = new PdfNameTable<TAtom>();
+    return *s_pTable;
+}
+
+/** The atoms a thread saw last, indexed by the low byte of their hash.
+ *  The cache holds a reference to each of them, which it drops when the
+ *  thread exits.
+ */
+template<typename TAtom>
+struct PdfNameCache {
+    ~PdfNameCache()
+    {
+        for( size_t i = 0; i < 256; i++ )
+        {
+            if( apAtoms[i] )
+                GetNameTable<TAtom>().ReleaseLast( apAtoms[i] );
+        }
+    }
+
+    const TAtom* apAtoms[256];
+};
+
+};
+
+const PdfName::TAtom* PdfName::Intern( const char* pszName, size_t lLen )
+{
+    // the same few names come back all the time, so each thread keeps
+    // the last ones it saw and only takes a shard lock on a miss
+    static thread_local PdfNameCache<TAtom> s_cache;
+
+    const size_t  nHash  = PdfNameTable<TAtom>::Hash( pszName, lLen );
+    const TAtom*& rpAtom = s_cache.apAtoms[nHash & 0xff];
+    if( rpAtom && rpAtom->name.length() == lLen
+        && memcmp( rpAtom->name.data(), pszName, lLen ) == 0 )
+    {
+        AddRef( rpAtom );
+        return rpAtom;
+    }
+
+    // one reference for the caller, and one for the cache
+    const TAtom* pAtom = GetNameTable<TAtom>().Intern( pszName, lLen, nHash );
+    AddRef( pAtom );
+    if( rpAtom )
+        Release( rpAtom );
+    rpAtom = pAtom;
+    return pAtom;
+}
+
+void PdfName::ReleaseLast( const TAtom* pAtom )
+{
+    GetNameTable<TAtom>().ReleaseLast( pAtom );
+}
+
+size_t PdfName::GetInternedCount()
+{
+    return GetNameTable<TAtom>().GetCount();
+}
+
 const PdfName PdfName::KeyContents  = PdfName( "Contents" );
 const PdfName PdfName::KeyFlags     = PdfName( "Flags" );
 const PdfName PdfName::KeyLength    = PdfName( "Length" );
@@ -167,6 +412,7 @@ const PdfName PdfName::KeyFilter    = PdfName( "Filter" );
 
 PdfName::~PdfName()
 {
+    Release( m_pAtom );
 }
 
 PdfName PdfName::FromEscaped( const std::string & sName )
@@ -182,6 +428,10 @@ PdfName PdfName::FromEscaped( const char * pszName, pdf_long ilen )
     if( !ilen )
         ilen = strlen( pszName );
 
+    // most names have nothing to unescape, and are interned as they are
+    if( !memchr( pszName, '#', ilen ) )
+        return PdfName( pszName, static_cast<long>(ilen) );
+
     return PdfName(UnescapeName(pszName, ilen));
 }
 
@@ -189,16 +439,16 @@ void PdfName::Write( PdfOutputDevice* pDevice, EPdfWriteMode, const PdfEncrypt*
 {
     // Allow empty names, which are legal according to the PDF specification
     pDevice->Print( "/" );
-    if( m_Data.length() )
+    if( m_pAtom->name.length() )
     {
-        std::string escaped( EscapeName(m_Data.begin(), m_Data.length()) );
+        std::string escaped( EscapeName(m_pAtom->name.begin(), m_pAtom->name.length()) );
         pDevice->Write( escaped.c_str(), escaped.length() );
     }
 }
 
 std::string PdfName::GetEscapedName() const
 {
-    return EscapeName(m_Data.begin(), m_Data.length());
+    return EscapeName(m_pAtom->name.begin(), m_pAtom->name.length());
 }
 
 bool PdfName::operator==( const char* rhs ) const
@@ -208,12 +458,12 @@ bool PdfName::operator==( const char* rhs ) const
       If the string is NOT empty and you pass NULL - that's not equal
       Otherwise, compare them
     */
-    if( m_Data.empty() && !rhs )
+    if( m_pAtom->name.empty() && !rhs )
         return true;
-    else if( !m_Data.empty() && !rhs )
+    else if( !m_pAtom->name.empty() && !rhs )
         return false;
     else
-        return ( m_Data == std::string( rhs ) );
+        return ( m_pAtom->name == rhs );
 }
 
 };
@@ -37,6 +37,9 @@
 #include "PdfDefines.h"
 #include "PdfDataType.h"
 
+#include <atomic>
+#include <string.h>
+
 namespace PoDoFo {
 
 class PdfOutputDevice;
@@ -52,6 +55,12 @@ class PdfName;
  *
  *  PdfName may have a maximum length of 127 characters.
  *
+ *  Names are interned in a process wide table: all PdfName objects with
+ *  the same value share a single atom, so copying and comparing names
+ *  never touches their characters. Atoms are reference counted: an
+ *  atom is freed with the last name using it, so the table only grows
+ *  with the number of distinct names alive at the same time.
+ *
  *  \see PdfObject \see PdfVariant
  */
 class PODOFO_API PdfName : public PdfDataType {
@@ -61,7 +70,7 @@ class PODOFO_API PdfName : public PdfDataType {
      *  use PdfName::KeyNull instead of this constructor
      */
     PdfName()
-        : PdfDataType(), m_Data("")
+        : PdfDataType(), m_pAtom( Intern( "", 0 ) ), m_nSortKey( m_pAtom->sortKey )
     {
     }
 
@@ -70,7 +79,7 @@ class PODOFO_API PdfName : public PdfDataType {
      *                 the name without the leading '/'.
      */
     PdfName( const std::string& sName )
-        : PdfDataType(), m_Data(sName)
+        : PdfDataType(), m_pAtom( Intern( sName.data(), sName.length() ) ), m_nSortKey( m_pAtom->sortKey )
     {
     }
 
@@ -80,9 +89,8 @@ class PODOFO_API PdfName : public PdfDataType {
      *                 Has to be a zero terminated string.
      */
     PdfName( const char* pszName )
-        : PdfDataType()
+        : PdfDataType(), m_pAtom( Intern( pszName ? pszName : "", pszName ? strlen( pszName ) : 0 ) ), m_nSortKey( m_pAtom->sortKey )
     {
-        if (pszName) m_Data.assign( pszName );
     }
 
     /** Create a new PdfName object.
@@ -91,9 +99,8 @@ class PODOFO_API PdfName : public PdfDataType {
      *  \param lLen    length of the name
      */
     PdfName( const char* pszName, long lLen )
-        : PdfDataType()
+        : PdfDataType(), m_pAtom( Intern( pszName ? pszName : "", pszName ? lLen : 0 ) ), m_nSortKey( m_pAtom->sortKey )
     {
-        if( pszName ) m_Data.assign( pszName, lLen );
     }
 
     /** Create a new PdfName object from a string containing an escaped
@@ -126,8 +133,9 @@ class PODOFO_API PdfName : public PdfDataType {
      *  \param rhs another PdfName object
      */
     PdfName( const PdfName & rhs )
-        : PdfDataType(), m_Data(rhs.m_Data)
+        : PdfDataType(), m_pAtom( rhs.m_pAtom ), m_nSortKey( rhs.m_nSortKey )
     {
+        AddRef( m_pAtom );
     }
 
     virtual ~PdfName();
@@ -195,7 +203,8 @@ class PODOFO_API PdfName : public PdfDataType {
     inline bool operator!=( const char* rhs ) const;
 
     /** compare two PdfName objects.
-     *  Used for sorting in lists
+     *  Used for sorting in lists. Names are ordered as their
+     *  unescaped values are, byte by byte.
      *  \returns true if this object is smaller than rhs
      */
     PODOFO_NOTHROW inline bool operator<( const PdfName & rhs ) const;
@@ -210,9 +219,56 @@ class PODOFO_API PdfName : public PdfDataType {
     static const PdfName KeyType;
     static const PdfName KeyFilter;
 
+    /** \returns how many distinct name values are interned at the moment,
+     *           including the few each thread keeps alive to speed up
+     *           lookups of the names it saw last
+     */
+    static size_t GetInternedCount();
+
  private:
-    // The _unescaped_ name, without leading /
-    std::string	m_Data;
+    /** The single copy of a name value, shared by all names with this value
+     */
+    struct TAtom {
+        // The _unescaped_ name, without leading /
+        std::string name;
+
+        // The first 8 bytes of the name, big endian and zero padded,
+        // which orders most names with a single integer comparison
+        pdf_uint64  sortKey;
+
+        // The hash of the name, which picks its shard in the table
+        size_t      nHash;
+
+        // The names and caches using this atom
+        mutable std::atomic<long> nRefs;
+
+        // Atoms of the most common keys are never freed, and copies of
+        // their names skip the reference count, which many threads
+        // would otherwise keep writing to
+        bool        bImmortal;
+    };
+
+    /** \returns the atom of a name value, created on first use,
+     *            with a reference taken for the caller
+     */
+    static const TAtom* Intern( const char* pszName, size_t lLen );
+
+    static inline void AddRef( const TAtom* pAtom );
+
+    /** Drop a reference to an atom, and free it if it was the last one
+     */
+    static inline void Release( const TAtom* pAtom );
+
+    /** Drop what may be the last reference to an atom. This takes the
+     *  lock of its shard, so that no other thread interns it meanwhile.
+     */
+    static void ReleaseLast( const TAtom* pAtom );
+
+    const TAtom* m_pAtom;
+
+    // A copy of the atom's sort key, so sorting names in a dictionary
+    // rarely has to look at their atoms
+    pdf_uint64   m_nSortKey;
 };
 
 // -----------------------------------------------------
@@ -220,7 +276,7 @@ class PODOFO_API PdfName : public PdfDataType {
 // -----------------------------------------------------
 const std::string & PdfName::GetName() const
 {
-    return m_Data;
+    return m_pAtom->name;
 }
 
 // -----------------------------------------------------
@@ -228,7 +284,7 @@ const std::string & PdfName::GetName() const
 // -----------------------------------------------------
 size_t PdfName::GetLength() const
 {
-    return m_Data.length();
+    return m_pAtom->name.length();
 }
 
 // -----------------------------------------------------
@@ -249,25 +305,55 @@ bool PdfName::operator!=( const char* rhs ) const
 
 bool PdfName::operator<( const PdfName & rhs ) const
 {
-    return m_Data < rhs.m_Data;
+    if( m_nSortKey != rhs.m_nSortKey )
+        return m_nSortKey < rhs.m_nSortKey;
+
+    // the first 8 bytes are the same
+    return m_pAtom != rhs.m_pAtom && m_pAtom->name < rhs.m_pAtom->name;
 }
 
 bool PdfName::operator==( const PdfName & rhs ) const
 {
-    return ( m_Data == rhs.m_Data );
+    return ( m_pAtom == rhs.m_pAtom );
 }
 
 bool PdfName::operator==( const std::string & rhs ) const
 {
-    return ( m_Data == rhs );
+    return ( m_pAtom->name == rhs );
 }
 
 const PdfName& PdfName::operator=( const PdfName & rhs )
 {
-    m_Data = rhs.m_Data;
+    AddRef( rhs.m_pAtom );
+    Release( m_pAtom );
+
+    m_pAtom    = rhs.m_pAtom;
+    m_nSortKey = rhs.m_nSortKey;
     return *this;
 }
 
+void PdfName::AddRef( const TAtom* pAtom )
+{
+    if( !pAtom->bImmortal )
+        pAtom->nRefs.fetch_add( 1, std::memory_order_relaxed );
+}
+
+void PdfName::Release( const TAtom* pAtom )
+{
+    if( pAtom->bImmortal )
+        return;
+
+    // only the last reference needs the lock
+    long nRefs = pAtom->nRefs.load( std::memory_order_relaxed );
+    while( nRefs > 1 )
+    {
+        if( pAtom->nRefs.compare_exchange_weak( nRefs, nRefs - 1, std::memory_order_release, std::memory_order_relaxed ) )
+            return;
+    }
+
+    ReleaseLast( pAtom );
+}
+
 
 };
 
@@ -168,7 +168,18 @@ void PdfObject::InitPdfObject()
 void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
                              PdfEncrypt* pEncrypt, const PdfName & keyStop ) const
 {
-    DelayedStreamLoad();
+    // a stream nobody loaded is unchanged, and can be copied as it is
+    // unless it has to be encrypted. This is decided before the
+    // dictionary is written, as loading the stream resets its /Length.
+    bool bRawStream = !pEncrypt && !DelayedStreamLoadDone();
+    if( bRawStream )
+    {
+        DelayedLoad();
+        bRawStream = this->CanWriteRawStream();
+    }
+
+    if( !bRawStream )
+        DelayedStreamLoad();
 
     if( !pDevice )
     {
@@ -208,7 +219,11 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
     this->Write( pDevice, eWriteMode, pEncrypt, keyStop );
     pDevice->Print( "\n" );
 
-    if( m_pStream )
+    if( bRawStream )
+    {
+        this->WriteRawStream( pDevice );
+    }
+    else if( m_pStream )
     {
         m_pStream->Write( pDevice, pEncrypt );
     }
@@ -219,6 +234,16 @@ void PdfObject::WriteObject( PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
     }
 }
 
+bool PdfObject::CanWriteRawStream() const
+{
+    return false;
+}
+
+void PdfObject::WriteRawStream( PdfOutputDevice* ) const
+{
+    PODOFO_RAISE_ERROR( ePdfError_InternalLogic );
+}
+
 PdfObject* PdfObject::GetIndirectKey( const PdfName & key ) const
 {
     const PdfObject* pObj = NULL;
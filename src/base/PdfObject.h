@@ -223,6 +223,15 @@ class PODOFO_API PdfObject : public PdfVariant {
      */
     inline bool HasStream() const;
 
+    /** Check if the stream of this object, if it has one, was
+     *  not loaded yet. WriteObject() copies such a stream straight
+     *  from where it was read, unless the object gets encrypted.
+     *  Unlike HasStream(), this does not load anything.
+     *
+     *  \returns true if loading the stream is still pending
+     */
+    inline bool IsStreamLoadPending() const;
+
     /** This operator is required for sorting a list of 
      *  PdfObjects. It compares the objectnumber. If objectnumbers
      *  are equal, the generation number is compared.
@@ -310,6 +319,25 @@ class PODOFO_API PdfObject : public PdfVariant {
      */
     inline virtual void DelayedStreamLoadImpl();
 
+    /** Tell whether WriteRawStream() can write the stream of this object.
+     *
+     *  Only called by WriteObject() while the stream is not loaded yet,
+     *  so it is unchanged, and before the dictionary is written: loading
+     *  the stream instead may change its /Length.
+     *
+     *  \returns false if the stream has to be loaded to be written
+     */
+    virtual bool CanWriteRawStream() const;
+
+    /** Write the stream of this object, with its stream and endstream
+     *  keywords, straight from where it was read, without loading it.
+     *
+     *  Only called by WriteObject() if CanWriteRawStream() returned true.
+     *
+     *  \param pDevice write the stream to this device
+     */
+    virtual void WriteRawStream( PdfOutputDevice* pDevice ) const;
+
     /** Same as GetStream() but won't trigger a delayed load, so it's safe
      *  for use while a delayed load is in progress.
      *
@@ -420,6 +448,14 @@ inline bool PdfObject::HasStream() const
     return ( m_pStream != NULL );
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+inline bool PdfObject::IsStreamLoadPending() const
+{
+    return !DelayedStreamLoadDone();
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
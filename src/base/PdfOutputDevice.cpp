@@ -38,9 +38,65 @@
 #include <fstream>
 #include <sstream>
 
+#if defined(PODOFO_HAVE_COPY_FILE_RANGE) || defined(PODOFO_HAVE_SYS_SENDFILE_H)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#define PODOFO_HAVE_KERNEL_COPY 1
+#endif
+
+#ifdef PODOFO_HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+
 
 namespace PoDoFo {
 
+#ifdef PODOFO_HAVE_KERNEL_COPY
+/** Let the kernel copy a range of a file to another one, without
+ *  the data going through user space.
+ *
+ *  \returns how many bytes were copied. It is less than lLen if the
+ *           kernel can't copy between these files, or past the end
+ *           of the input file.
+ */
+static pdf_long KernelCopy( int nIn, off_t lInOffset, int nOut, off_t lOutOffset, pdf_long lLen )
+{
+    pdf_long lCopied = 0;
+
+#ifdef PODOFO_HAVE_COPY_FILE_RANGE
+    while( lCopied < lLen )
+    {
+        ssize_t lDone = copy_file_range( nIn, &lInOffset, nOut, &lOutOffset, lLen - lCopied, 0 );
+        if( lDone < 0 && errno == EINTR )
+            continue;
+        if( lDone <= 0 )
+            break;
+        lCopied += lDone;
+    }
+#endif // PODOFO_HAVE_COPY_FILE_RANGE
+
+#ifdef PODOFO_HAVE_SYS_SENDFILE_H
+    // older kernels only copy from files to any file descriptor,
+    // at its current position
+    if( lCopied < lLen && lseek( nOut, lOutOffset, SEEK_SET ) == lOutOffset )
+    {
+        while( lCopied < lLen )
+        {
+            ssize_t lDone = sendfile( nOut, nIn, &lInOffset, lLen - lCopied );
+            if( lDone < 0 && errno == EINTR )
+                continue;
+            if( lDone <= 0 )
+                break;
+            lCopied += lDone;
+        }
+    }
+#endif // PODOFO_HAVE_SYS_SENDFILE_H
+
+    return lCopied;
+}
+#endif // PODOFO_HAVE_KERNEL_COPY
+
 
 PdfOutputDevice::PdfOutputDevice()
 {
@@ -78,6 +134,8 @@ PdfOutputDevice::PdfOutputDevice( const char* pszFilename, bool bTruncate )
         m_ulPosition = m_pStream->tellp();
         m_ulLength = m_ulPosition;
     }
+
+    m_sFilename = pszFilename;
 }
 
 #ifdef _WIN32
@@ -157,6 +215,11 @@ PdfOutputDevice::~PdfOutputDevice()
 
     if( m_hFile )
         fclose( m_hFile );
+
+#ifdef PODOFO_HAVE_KERNEL_COPY
+    if( m_nCopyFd != -1 )
+        close( m_nCopyFd );
+#endif // PODOFO_HAVE_KERNEL_COPY
 }
 
 void PdfOutputDevice::Init()
@@ -171,6 +234,7 @@ void PdfOutputDevice::Init()
     m_lBufferLen        = 0;
     m_ulPosition        = 0;
     m_pStreamOwned      = true;
+    m_nCopyFd           = -1;
     dictencode_stream   = NULL;
 }
 
@@ -364,6 +428,46 @@ void PdfOutputDevice::Write( const char* pBuffer, size_t lLen )
 	if(m_ulPosition>m_ulLength) m_ulLength = m_ulPosition;
 }
 
+pdf_long PdfOutputDevice::CopyFrom( int nFd, std::streamoff lOffset, pdf_long lLen )
+{
+#ifdef PODOFO_HAVE_KERNEL_COPY
+    int nOut = -1;
+
+    // the data written so far has to reach the file before the kernel writes after it
+    if( m_hFile )
+    {
+        if( !fflush( m_hFile ) )
+            nOut = fileno( m_hFile );
+    }
+    else if( m_pStream && !m_sFilename.empty() )
+    {
+        // std::fstream has no descriptor, the file is opened a second time
+        if( m_nCopyFd == -1 )
+            m_nCopyFd = open( m_sFilename.c_str(), O_WRONLY );
+
+        if( m_nCopyFd != -1 && m_pStream->flush().good() )
+            nOut = m_nCopyFd;
+    }
+
+    if( nOut == -1 )
+        return 0;
+
+    pdf_long lCopied = KernelCopy( nFd, lOffset, nOut, m_ulPosition, lLen );
+    if( lCopied )
+    {
+        m_ulPosition += static_cast<size_t>(lCopied);
+        if( m_ulPosition > m_ulLength )
+            m_ulLength = m_ulPosition;
+
+        this->Seek( m_ulPosition );
+    }
+
+    return lCopied;
+#else
+    return 0;
+#endif // PODOFO_HAVE_KERNEL_COPY
+}
+
 void PdfOutputDevice::Seek( size_t offset )
 {
     if( m_hFile )
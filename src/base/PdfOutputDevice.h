@@ -178,6 +178,18 @@ class PODOFO_API PdfOutputDevice {
      */
     virtual void Write( const char* pBuffer, size_t lLen );
 
+    /** Copy a range of a file to the current position of the device,
+     *  letting the kernel do it when the device writes to a file.
+     *
+     *  \param nFd     descriptor of the file to copy from
+     *  \param lOffset position of the first byte to copy in that file
+     *  \param lLen    number of bytes to copy
+     *  \returns how many bytes were copied, which is 0 if the device
+     *           isn't a file or the kernel can't copy. The caller has
+     *           to write the remaining ones.
+     */
+    pdf_long CopyFrom( int nFd, std::streamoff lOffset, pdf_long lLen );
+
     /** Read data from the device
      *  \param pBuffer a pointer to the data buffer
      *  \param lLen length of the output buffer
@@ -231,6 +243,10 @@ class PODOFO_API PdfOutputDevice {
     size_t               m_ulPosition;
 
     PdfRefCountedBuffer  m_printBuffer;
+
+    // file written through m_pStream, and its descriptor for CopyFrom()
+    std::string          m_sFilename;
+    int                  m_nCopyFd;
 };
 
 // -----------------------------------------------------
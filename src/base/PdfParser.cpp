@@ -34,6 +34,7 @@
 #include "PdfParser.h"
 
 #include "PdfArray.h"
+#include "PdfBufferInputDevice.h"
 #include "PdfDefinesPrivate.h"
 #include "PdfDictionary.h"
 #include "PdfEncrypt.h"
@@ -50,9 +51,16 @@
 #include <cstdlib>
 #include <sstream>
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <limits>
 
+#ifdef PODOFO_MULTI_THREAD
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif // PODOFO_MULTI_THREAD
+
 using std::cerr;
 using std::endl;
 using std::flush;
@@ -115,14 +123,14 @@ class PdfRecursionGuard
 };
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ), m_bDecodeLastUpdate( false ), m_nLoadThreads( 0 )
 
 {
     this->Init();
 }
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ), m_bDecodeLastUpdate( false ), m_nLoadThreads( 0 )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -132,7 +140,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pszFilename, bool
 #if defined(_MSC_VER)  &&  _MSC_VER <= 1200    // not for MS Visual Studio 6
 #else
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ), m_bDecodeLastUpdate( false ), m_nLoadThreads( 0 )
 {
     this->Init();
     this->ParseFile( pszFilename, bLoadOnDemand );
@@ -141,7 +149,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const wchar_t* pszFilename, bo
 #endif // _WIN32
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen, bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ), m_bDecodeLastUpdate( false ), m_nLoadThreads( 0 )
 {
     this->Init();
     this->ParseFile( pBuffer, lLen, bLoadOnDemand );
@@ -149,7 +157,7 @@ PdfParser::PdfParser( PdfVecObjects* pVecObjects, const char* pBuffer, long lLen
 
 PdfParser::PdfParser( PdfVecObjects* pVecObjects, const PdfRefCountedInputDevice & rDevice, 
                       bool bLoadOnDemand )
-    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false )
+    : PdfTokenizer(), m_vecObjects( pVecObjects ), m_bStrictParsing( false ), m_bDecodeLastUpdate( false ), m_nLoadThreads( 0 )
 {
     this->Init();
 
@@ -780,6 +788,11 @@ void PdfParser::ReadXRefContents( pdf_long lOffset, bool bPositionAtEnd )
         }
     }
 
+    // Only the entries of the newest XRef table were read so far,
+    // the older ones are read while following the trailers.
+    if( m_bDecodeLastUpdate && !bPositionAtEnd && lOffset == m_nXRefOffset )
+        DiscardOlderRevisions();
+
     try {
         ReadNextTrailer();
     } catch( PdfError & e ) {
@@ -791,6 +804,24 @@ void PdfParser::ReadXRefContents( pdf_long lOffset, bool bPositionAtEnd )
     }
 }
 
+void PdfParser::DiscardOlderRevisions()
+{
+    bit_ostream* pDecodeStream = m_device.Device() ? m_device.Device()->dictdecode_stream : NULL;
+    if( !pDecodeStream )
+        return;
+
+    // an update appends its objects after the document it
+    // updates, so the lowest offset is where the update begins
+    pdf_long lUpdateOffset = m_nXRefOffset;
+    for( TCIVecOffsets it = m_offsets.begin(); it != m_offsets.end(); ++it )
+    {
+        if( (*it).bParsed && (*it).cUsed == 'n' && (*it).lOffset > 0 )
+            lUpdateOffset = PDF_MIN( lUpdateOffset, (*it).lOffset );
+    }
+
+    pDecodeStream->discard_below( lUpdateOffset );
+}
+
 void PdfParser::ReadXRefSubsection( pdf_int64 & nFirstObject, pdf_int64 & nNumObjects )
 {
     pdf_int64 count = 0;
@@ -1100,12 +1131,46 @@ void PdfParser::ReadObjects()
     ReadObjectsInternal();
 }
 
-void PdfParser::ReadObjectsInternal() 
+// delete the objects loaded ahead that were not added yet
+static void DeleteObjects( std::vector<PdfParserObject*> & rvecObjects )
+{
+    for( size_t i = 0; i < rvecObjects.size(); i++ )
+        delete rvecObjects[i];
+    rvecObjects.clear();
+}
+
+void PdfParser::ReadObjectsInternal( bool bDecodeOnly ) 
 {
     int              i            = 0;
     int              nLast        = 0;
     PdfParserObject* pObject      = NULL;
 
+    // Objects are read in object number order. Tell the payload decoder
+    // the lowest offset that is still to be read after each object, so
+    // it can emit everything below without waiting for the whole file.
+    bit_ostream*          pDecodeStream = m_device.Device() && !m_bLoadOnDemand ? m_device.Device()->dictdecode_stream : NULL;
+    std::vector<pdf_long> vecNextOffset;
+    if( pDecodeStream )
+    {
+        vecNextOffset.resize( m_nNumObjects + 1, std::numeric_limits<pdf_long>::max() );
+        for( i = m_nNumObjects - 1; i >= 0; i-- )
+        {
+            vecNextOffset[i] = vecNextOffset[i + 1];
+            if( m_offsets[i].bParsed && m_offsets[i].cUsed == 'n' && m_offsets[i].lOffset > 0 )
+                vecNextOffset[i] = PDF_MIN( vecNextOffset[i], m_offsets[i].lOffset );
+        }
+    }
+
+    // Objects are either parsed in this loop or, on several
+    // threads, before it. They are added in the same order.
+    std::vector<PdfParserObject*> vecLoaded;
+    std::map<int,PdfError>        mapErrors;
+    if( m_nLoadThreads > 1 && !m_bLoadOnDemand && !pDecodeStream
+        && dynamic_cast<PdfBufferInputDevice*>(m_device.Device()) )
+    {
+        LoadObjectsParallel( vecLoaded, mapErrors );
+    }
+
     // Read objects
     for( i=0; i < m_nNumObjects; i++ )
     {
@@ -1120,23 +1185,35 @@ void PdfParser::ReadObjectsInternal()
         {
             //printf("Reading object %i 0 R from %li\n", i, m_offsets[i].lOffset );
             
-            pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
-            if( !pObject )
-                PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+            if( !vecLoaded.empty() )
+            {
+                pObject = vecLoaded[i];
+                vecLoaded[i] = NULL;
+            }
+            else
+            {
+                pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
+                if( !pObject )
+                    PODOFO_RAISE_ERROR( ePdfError_OutOfMemory );
+
+                pObject->SetLoadOnDemand( m_bLoadOnDemand );
+            }
 
-            pObject->SetLoadOnDemand( m_bLoadOnDemand );
             try {
-				pObject->ParseFile( m_pEncrypt );
-				if (m_pEncrypt && pObject->IsDictionary()) {
-					PdfObject* pObjType = pObject->GetDictionary().GetKey( PdfName::KeyType );
-					if( pObjType && pObjType->IsName() && pObjType->GetName() == "XRef" ) {
-						// XRef is never encrypted
-						delete pObject;
-						pObject = new PdfParserObject( m_vecObjects, m_device, m_buffer, m_offsets[i].lOffset );
-						pObject->SetLoadOnDemand( m_bLoadOnDemand );
-						pObject->ParseFile( NULL );
-					}
-				}
+                if( vecLoaded.empty() )
+                    ParseObject( pObject, m_device, m_buffer, m_offsets[i].lOffset, m_pEncrypt );
+                else
+                {
+                    // the error the object raised when it was parsed
+                    std::map<int,PdfError>::const_iterator itError = mapErrors.find( i );
+                    if( itError != mapErrors.end() )
+                        throw itError->second;
+
+                    // it was decrypted with a copy of m_pEncrypt
+                    if( pObject->GetEncrypt() )
+                        pObject->SetEncrypt( m_pEncrypt );
+                }
+
                 nLast = pObject->Reference().ObjectNumber();
 
                 /*
@@ -1175,6 +1252,7 @@ void PdfParser::ReadObjectsInternal()
                 }
                 else
                 {
+                    DeleteObjects( vecLoaded );
                     e.AddToCallstack( __FILE__, __LINE__, oss.str().c_str() );
                     throw e;
                 }
@@ -1188,6 +1266,7 @@ void PdfParser::ReadObjectsInternal()
             // treating them as free objects
             if( m_bStrictParsing ) 
             {
+                DeleteObjects( vecLoaded );
                 PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidXRef,
                                          "Found object with 0 offset which should be 'f' instead of 'n'." );
             }
@@ -1212,8 +1291,23 @@ void PdfParser::ReadObjectsInternal()
         {
 			m_vecObjects->AddFreeObject( PdfReference( static_cast<int>(i), PODOFO_LL_LITERAL(1) ) ); // TODO: do not hard code generation number
         }
+
+        if( pDecodeStream )
+        {
+            pDecodeStream->advance( static_cast<long>(vecNextOffset[i + 1]) );
+
+            // a framed payload is complete: the remaining objects
+            // can't hold anything of interest
+            if( bDecodeOnly && pDecodeStream->done() )
+                break;
+        }
     }
 
+    // the objects only served to decode the payload, and are thrown
+    // away: objects from object streams hold no payload
+    if( bDecodeOnly )
+        return;
+
     // all normal objects including object streams are available now,
     // we can parse the object streams safely now.
     //
@@ -1257,6 +1351,105 @@ void PdfParser::ReadObjectsInternal()
     UpdateDocumentVersion();
 }
 
+void PdfParser::ParseObject( PdfParserObject* & rpObject, const PdfRefCountedInputDevice & rDevice,
+                             const PdfRefCountedBuffer & rBuffer, pdf_long lOffset, PdfEncrypt* pEncrypt )
+{
+    rpObject->ParseFile( pEncrypt );
+    if( pEncrypt && rpObject->IsDictionary() )
+    {
+        PdfObject* pObjType = rpObject->GetDictionary().GetKey( PdfName::KeyType );
+        if( pObjType && pObjType->IsName() && pObjType->GetName() == "XRef" )
+        {
+            // XRef is never encrypted
+            const bool bLoadOnDemand = rpObject->IsLoadOnDemand();
+
+            delete rpObject;
+            rpObject = new PdfParserObject( m_vecObjects, rDevice, rBuffer, lOffset );
+            rpObject->SetLoadOnDemand( bLoadOnDemand );
+            rpObject->ParseFile( NULL );
+        }
+    }
+}
+
+void PdfParser::LoadObjectsParallel( std::vector<PdfParserObject*> & rvecObjects, std::map<int,PdfError> & rmapErrors )
+{
+    const PdfBufferInputDevice* pSource = dynamic_cast<const PdfBufferInputDevice*>(m_device.Device());
+    unsigned int                nThreads = m_nLoadThreads;
+
+#ifndef PODOFO_MULTI_THREAD
+    // the library does not lock its global state
+    nThreads = 1;
+#endif // PODOFO_MULTI_THREAD
+
+    // Each thread decrypts with its own encryption object,
+    // as it keeps the reference of the object being read.
+    std::vector<PdfEncrypt*> vecEncrypt( nThreads, static_cast<PdfEncrypt*>(NULL) );
+    if( m_pEncrypt )
+    {
+        for( unsigned int i = 0; i < nThreads; i++ )
+            vecEncrypt[i] = PdfEncrypt::CreatePdfEncrypt( *m_pEncrypt );
+    }
+
+    // Threads take objects by batches, so that they all end at about
+    // the same time. Each one reads the buffer through its own device.
+    // Objects and errors are stored by index, and inserted in order by
+    // the caller, so that the result does not depend on the threads.
+    const size_t nBatchSize = 64;
+    const size_t nObjects   = static_cast<size_t>(m_nNumObjects);
+
+    rvecObjects.assign( nObjects, static_cast<PdfParserObject*>(NULL) );
+#ifdef PODOFO_MULTI_THREAD
+    std::atomic<size_t> nNextBatch( 0 );
+    std::mutex          mutex;
+#else
+    size_t              nNextBatch = 0;
+#endif // PODOFO_MULTI_THREAD
+
+    auto worker = [&]( PdfEncrypt* pEncrypt ) {
+        PdfRefCountedInputDevice device( new PdfBufferInputDevice( pSource->GetBuffer(), pSource->GetLength() ) );
+        PdfRefCountedBuffer      buffer( m_buffer.GetSize() );
+
+        size_t nFirst;
+        while( (nFirst = (nNextBatch += nBatchSize) - nBatchSize) < nObjects )
+        {
+            const size_t nEnd = PDF_MIN( nFirst + nBatchSize, nObjects );
+            for( size_t i = nFirst; i < nEnd; i++ )
+            {
+                if( !(m_offsets[i].bParsed && m_offsets[i].cUsed == 'n' && m_offsets[i].lOffset > 0) )
+                    continue;
+
+                PdfParserObject* pObject = new PdfParserObject( m_vecObjects, device, buffer, m_offsets[i].lOffset );
+                pObject->SetLoadOnDemand( false );
+                try {
+                    ParseObject( pObject, device, buffer, m_offsets[i].lOffset, pEncrypt );
+                } catch( PdfError & e ) {
+                    // kept with the object, which tells where it failed
+#ifdef PODOFO_MULTI_THREAD
+                    std::lock_guard<std::mutex> lock( mutex );
+#endif // PODOFO_MULTI_THREAD
+                    rmapErrors[static_cast<int>(i)] = e;
+                }
+                rvecObjects[i] = pObject;
+            }
+        }
+    };
+
+#ifdef PODOFO_MULTI_THREAD
+    std::vector<std::thread> threads;
+    for( unsigned int i = 1; i < nThreads; i++ )
+        threads.emplace_back( worker, vecEncrypt[i] );
+    worker( vecEncrypt[0] );
+    for( std::thread & thread : threads )
+        thread.join();
+#else
+    worker( vecEncrypt[0] );
+#endif // PODOFO_MULTI_THREAD
+
+    // objects get m_pEncrypt back before their streams are read
+    for( unsigned int i = 0; i < nThreads; i++ )
+        delete vecEncrypt[i];
+}
+
 void PdfParser::SetPassword( const std::string & sPassword )
 {
     if( !m_pEncrypt ) 
@@ -1276,6 +1469,162 @@ void PdfParser::SetPassword( const std::string & sPassword )
     ReadObjectsInternal();
 }
 
+void PdfParser::DecodeDictOrder( const char* pBuffer, pdf_long lLen, bit_ostream & rStream, unsigned int nThreads )
+{
+    if( !pBuffer || !lLen )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
+    }
+
+    Clear();
+
+    m_device = PdfRefCountedInputDevice( new PdfBufferInputDevice( pBuffer, lLen ) );
+    m_device.Device()->dictdecode_stream = &rStream;
+
+    m_bLoadOnDemand = false;
+
+    try {
+        if( !IsPdfFile() )
+        {
+            PODOFO_RAISE_ERROR( ePdfError_NoPdfFile );
+        }
+
+        // The trailers and xref streams get decoded here, as ParseFile does.
+        // Names are never encrypted, so no encryption object is required.
+        ReadDocumentStructure();
+        if( nThreads > 1 )
+            DecodeObjectsDictOrder( pBuffer, lLen, rStream, nThreads );
+        else
+        {
+            // the objects go to a vector of our own, as reading
+            // may stop before the end of the document
+            PdfVecObjects  vecObjects;
+            PdfVecObjects* pVecObjects = m_vecObjects;
+
+            vecObjects.SetAutoDelete( true );
+            m_vecObjects = &vecObjects;
+            try {
+                ReadObjectsInternal( true );
+            } catch( PdfError & e ) {
+                m_vecObjects = pVecObjects;
+                throw e;
+            }
+            m_vecObjects = pVecObjects;
+        }
+    } catch( PdfError & e ) {
+        Clear();
+        e.AddToCallstack( __FILE__, __LINE__, "Unable to decode objects from file." );
+        throw e;
+    }
+
+    // no object was loaded, and the buffer belongs to the caller
+    Clear();
+}
+
+void PdfParser::DecodeObjectsDictOrder( const char* pBuffer, pdf_long lLen, bit_ostream & rStream, unsigned int nThreads )
+{
+    // The objects ReadObjectsInternal would load. Objects from object
+    // streams do not hold any rank, as they are never written that way.
+    std::vector<pdf_long> vecOffsets;
+    for( int i = 0; i < m_nNumObjects; i++ )
+    {
+        if( m_offsets[i].bParsed && m_offsets[i].cUsed == 'n' && m_offsets[i].lOffset > 0 )
+            vecOffsets.push_back( m_offsets[i].lOffset );
+        else if( m_offsets[i].bParsed && m_offsets[i].cUsed == 'n' && m_bStrictParsing )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidXRef,
+                                     "Found object with 0 offset which should be 'f' instead of 'n'." );
+        }
+    }
+
+#ifdef PODOFO_MULTI_THREAD
+    if( !nThreads )
+        nThreads = 1;
+#else
+    // the library does not lock its global state
+    nThreads = 1;
+#endif // PODOFO_MULTI_THREAD
+
+    // Threads take objects by batches, so that they all end at
+    // about the same time. Each one decodes to its own stream
+    // through its own device, and the ranks are merged at the end.
+    const size_t    nBatchSize = 64;
+    std::ostream    discard( NULL );
+    bool            bFailed    = false;
+    PdfError        error;
+
+    std::deque<bit_ostream> ranks;
+#ifdef PODOFO_MULTI_THREAD
+    std::atomic<size_t>     nNextBatch( 0 );
+    std::mutex              mutex;
+#else
+    size_t                  nNextBatch = 0;
+#endif // PODOFO_MULTI_THREAD
+
+    for( unsigned int i = 0; i < nThreads; i++ )
+        ranks.emplace_back( discard );
+
+    auto worker = [&]( bit_ostream & rRanks ) {
+        PdfRefCountedInputDevice device( new PdfBufferInputDevice( pBuffer, lLen ) );
+        PdfRefCountedBuffer      buffer( m_buffer.GetSize() );
+        PdfVecObjects            vecObjects;
+
+        device.Device()->dictdecode_stream = &rRanks;
+
+        size_t nFirst;
+        while( (nFirst = (nNextBatch += nBatchSize) - nBatchSize) < vecOffsets.size() )
+        {
+            const size_t nEnd = PDF_MIN( nFirst + nBatchSize, vecOffsets.size() );
+            for( size_t i = nFirst; i < nEnd; i++ )
+            {
+                PdfParserObject object( &vecObjects, device, buffer, vecOffsets[i] );
+                object.SetLoadOnDemand( false );
+                try {
+                    object.ParseFile( NULL );
+                } catch( PdfError & e ) {
+                    std::ostringstream oss;
+                    oss << "Error while decoding object at offset " << vecOffsets[i] << std::endl;
+
+                    if( m_bIgnoreBrokenObjects )
+                    {
+                        PdfError::LogMessage( eLogSeverity_Error, oss.str().c_str() );
+                        continue;
+                    }
+
+                    e.AddToCallstack( __FILE__, __LINE__, oss.str().c_str() );
+#ifdef PODOFO_MULTI_THREAD
+                    std::lock_guard<std::mutex> lock( mutex );
+#endif // PODOFO_MULTI_THREAD
+                    if( !bFailed )
+                        error = e;
+                    bFailed = true;
+
+                    // stop the other threads as well
+                    nNextBatch = vecOffsets.size();
+                    return;
+                }
+            }
+        }
+    };
+
+#ifdef PODOFO_MULTI_THREAD
+    std::vector<std::thread> threads;
+    for( unsigned int i = 1; i < nThreads; i++ )
+        threads.emplace_back( worker, std::ref( ranks[i] ) );
+    worker( ranks[0] );
+    for( std::thread & thread : threads )
+        thread.join();
+#else
+    worker( ranks[0] );
+#endif // PODOFO_MULTI_THREAD
+
+    if( bFailed )
+        throw error;
+
+    for( bit_ostream & rRanks : ranks )
+        rStream.merge( rRanks );
+}
+
 void PdfParser::ReadObjectFromStream( int nObjNo, int )
 {
     // check if we already have read all objects
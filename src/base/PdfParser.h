@@ -48,6 +48,7 @@ typedef TMapObjects::iterator       TIMapObjects;
 typedef TMapObjects::const_iterator TCIMapObjects;
 
 class PdfEncrypt;
+class PdfParserObject;
 class PdfString;
 
 /**
@@ -251,6 +252,25 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     void ParseFile( const PdfRefCountedInputDevice & rDevice, bool bLoadOnDemand = true );
 
+    /** Decode the dictionary order payload of a PDF file held in memory,
+     *  without loading its objects.
+     *
+     *  The document structure is read as by ParseFile. The objects
+     *  listed in the xref table are then parsed by nThreads threads,
+     *  each one reading the shared buffer through its own device.
+     *  The ranks of their dictionaries are merged into rStream, and
+     *  the objects are thrown away.
+     *
+     *  On a single thread, objects are read in order instead, and
+     *  reading stops as soon as a framed payload is complete.
+     *
+     *  \param pBuffer the PDF file, which must not change during the call
+     *  \param lLen the length of the buffer
+     *  \param rStream receives the ranks, flush it to get the payload
+     *  \param nThreads the number of threads parsing objects
+     */
+    void DecodeDictOrder( const char* pBuffer, pdf_long lLen, bit_ostream & rStream, unsigned int nThreads );
+
     /** Quick method to detect secured PDF files, i.e.
      *  a PDF with an /Encrypt key in the trailer directory.
      *
@@ -380,6 +400,50 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     inline void SetIgnoreBrokenObjects( bool bBroken );
 
+    /**
+     * \return if only the newest revision of the document is decoded
+     */
+    inline bool GetDecodeLastUpdate() const;
+
+    /**
+     * Only decode the payload of the newest revision of the document.
+     *
+     * Dictionaries written before the objects of the newest
+     * XRef table, such as the ones of the original document an
+     * incremental update leaves untouched, are not decoded.
+     *
+     * Default is to decode every dictionary of the document.
+     *
+     * \param bLastUpdate if true, only the newest revision is decoded
+     */
+    inline void SetDecodeLastUpdate( bool bLastUpdate );
+
+    /**
+     * \return the number of threads loading objects
+     */
+    inline unsigned int GetLoadThreads() const;
+
+    /**
+     * Load the objects listed in the xref table on several threads.
+     *
+     * Threads take objects by batches, each one reading the input
+     * device through its own device and decrypting with its own copy
+     * of the encryption object. Objects are then added to the
+     * PdfVecObjects in xref order, exactly as when loading serially,
+     * and broken objects are reported the same way.
+     *
+     * Only used when the whole document is loaded at once
+     * (bLoadOnDemand is false) from a PdfBufferInputDevice, such
+     * as a PdfMappedInputDevice, and when no payload is decoded
+     * while parsing: use DecodeDictOrder for that. Streams and
+     * object streams are always loaded serially.
+     *
+     * Default is 0.
+     *
+     * \param nThreads the number of threads, 0 or 1 to load serially
+     */
+    inline void SetLoadThreads( unsigned int nThreads );
+
     /**
      * \return maximum object count to read
      */
@@ -477,6 +541,13 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      */
     void ReadXRefSubsection( pdf_int64 & nFirstObject, pdf_int64 & nNumObjects );
 
+    /** Stop decoding the dictionaries written before the objects of
+     *  the newest XRef table, which has to be the only one read yet.
+     *
+     *  \see SetDecodeLastUpdate
+     */
+    void DiscardOlderRevisions();
+
     /** Reads a xref stream contens object
      *  \param lOffset read the stream from this offset
      *  \param bReadOnlyTrailer only the trailer is skipped over, the contents
@@ -504,10 +575,48 @@ class PODOFO_API PdfParser : public PdfTokenizer {
      *  This method is called from ReadObjects
      *  or SetPassword.
      *
+     *  \param bDecodeOnly if true, objects are only read to decode the
+     *                     payload of the input device, and reading stops
+     *                     as soon as a framed payload is complete: streams
+     *                     and object streams are not loaded, and the objects
+     *                     are not sorted. The objects must be thrown away.
+     *
      *  \see ReadObjects
      *  \see SetPassword
+     *  \see DecodeDictOrder
+     */
+    void ReadObjectsInternal( bool bDecodeOnly = false );
+
+    /** Parses the objects listed in m_vecOffsets on several threads,
+     *  only keeping the ranks of their dictionaries.
+     *
+     *  \see DecodeDictOrder
      */
-    void ReadObjectsInternal();
+    void DecodeObjectsDictOrder( const char* pBuffer, pdf_long lLen, bit_ostream & rStream, unsigned int nThreads );
+
+    /** Parses the objects listed in m_vecOffsets on m_nLoadThreads threads.
+     *
+     *  \param rvecObjects receives the object read at each index of
+     *                     m_vecOffsets, or NULL if there is none
+     *  \param rmapErrors receives the error raised while reading
+     *                    each broken object, by index
+     *
+     *  \see SetLoadThreads
+     */
+    void LoadObjectsParallel( std::vector<PdfParserObject*> & rvecObjects, std::map<int,PdfError> & rmapErrors );
+
+    /** Parse an object from the xref table. Cross reference streams
+     *  are never encrypted, so they are parsed again without pEncrypt.
+     *
+     *  \param rpObject the object to parse, which is replaced if
+     *                  it has to be parsed again
+     *  \param rDevice the device rpObject reads from
+     *  \param rBuffer the buffer rpObject uses
+     *  \param lOffset the offset of the object
+     *  \param pEncrypt the encryption object or NULL
+     */
+    void ParseObject( PdfParserObject* & rpObject, const PdfRefCountedInputDevice & rDevice,
+                      const PdfRefCountedBuffer & rBuffer, pdf_long lOffset, PdfEncrypt* pEncrypt );
 
     /** Read the object with index nIndex from the object stream nObjNo
      *  and push it on the objects vector m_vecOffsets.
@@ -601,6 +710,8 @@ class PODOFO_API PdfParser : public PdfTokenizer {
 
     bool          m_bStrictParsing;
     bool          m_bIgnoreBrokenObjects;
+    bool          m_bDecodeLastUpdate;
+    unsigned int  m_nLoadThreads;
 
     int           m_nIncrementalUpdates;
     int           m_nRecursionDepth;
@@ -692,6 +803,38 @@ void PdfParser::SetIgnoreBrokenObjects( bool bBroken )
     m_bIgnoreBrokenObjects = bBroken;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+bool PdfParser::GetDecodeLastUpdate() const
+{
+    return m_bDecodeLastUpdate;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParser::SetDecodeLastUpdate( bool bLastUpdate )
+{
+    m_bDecodeLastUpdate = bLastUpdate;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfParser::GetLoadThreads() const
+{
+    return m_nLoadThreads;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParser::SetLoadThreads( unsigned int nThreads )
+{
+    m_nLoadThreads = nThreads;
+}
+
 // -----------------------------------------------------
 //
 // -----------------------------------------------------
@@ -38,6 +38,7 @@
 #include "PdfEncrypt.h"
 #include "PdfInputDevice.h"
 #include "PdfInputStream.h"
+#include "PdfOutputDevice.h"
 #include "PdfParser.h"
 #include "PdfStream.h"
 #include "PdfVariant.h"
@@ -180,6 +181,7 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
     PODOFO_ASSERT( !DelayedLoadDone() );
 #endif
     const char* pszToken;
+    size_t      lLen;
 
     m_device.Device()->Seek( m_lOffset );
     if( m_pEncrypt )
@@ -191,7 +193,7 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
     // endobj
 
     EPdfTokenType eTokenType;
-    bool gotToken = this->GetNextToken( pszToken, &eTokenType );
+    bool gotToken = this->GetNextTokenView( pszToken, lLen, &eTokenType );
     
     if (!gotToken)
     {
@@ -199,9 +201,9 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
     }
 
     // Check if we have an empty object or data
-    if( strncmp( pszToken, "endobj", s_nLenEndObj ) != 0 )
+    if( lLen < static_cast<size_t>(s_nLenEndObj) || strncmp( pszToken, "endobj", s_nLenEndObj ) != 0 )
     {
-        this->GetNextVariant( pszToken, eTokenType, *this, m_pEncrypt );
+        this->GetNextVariant( pszToken, lLen, eTokenType, *this, m_pEncrypt );
         this->SetDirty( false );
 
         if( !bIsTrailer )
@@ -240,17 +242,14 @@ void PdfParserObject::ParseFileComplete( bool bIsTrailer )
 // Only called during delayed loading. Must be careful to avoid
 // triggering recursive delay loading due to use of accessors of
 // PdfVariant or PdfObject.
-void PdfParserObject::ParseStream()
+// Shared by ParseStream() and WriteRawStream(): skip the end of line
+// after the stream keyword, and read the /Length key. Moves the device.
+pdf_long PdfParserObject::FindStreamData( pdf_int64 & lLen ) const
 {
-#if defined(PODOFO_EXTRA_CHECKS)
-    PODOFO_ASSERT( DelayedLoadDone() );
-    PODOFO_ASSERT( DelayedStreamLoadInProgress() );
-    PODOFO_ASSERT( !DelayedStreamLoadDone() );
-#endif
-
-    pdf_int64         lLen  = -1;
     int          c;
 
+    lLen = -1;
+
     if( !m_device.Device() || !m_pOwner )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
@@ -280,7 +279,7 @@ void PdfParserObject::ParseStream()
     
     pdf_long fLoc = m_device.Device()->Tell();	// we need to save this, since loading the Length key could disturb it!
 
-    PdfObject* pObj = this->GetDictionary_NoDL().GetKey( PdfName::KeyLength );  
+    const PdfObject* pObj = this->GetDictionary_NoDL().GetKey( PdfName::KeyLength );  
     if( pObj && pObj->IsNumber() )
     {
         lLen = pObj->GetNumber();   
@@ -325,6 +324,20 @@ void PdfParserObject::ParseStream()
         PODOFO_RAISE_ERROR( ePdfError_InvalidStreamLength );
     }
 
+    return fLoc;
+}
+
+void PdfParserObject::ParseStream()
+{
+#if defined(PODOFO_EXTRA_CHECKS)
+    PODOFO_ASSERT( DelayedLoadDone() );
+    PODOFO_ASSERT( DelayedStreamLoadInProgress() );
+    PODOFO_ASSERT( !DelayedStreamLoadDone() );
+#endif
+
+    pdf_int64 lLen;
+    pdf_long  fLoc = FindStreamData( lLen );
+
     m_device.Device()->Seek( fLoc );	// reset it before reading!
     PdfDeviceInputStream reader( m_device.Device() );
 
@@ -359,6 +372,47 @@ void PdfParserObject::ParseStream()
 }
 
 
+bool PdfParserObject::FindRawStream( pdf_long & lOffset, pdf_int64 & lLen ) const
+{
+    // encrypted streams are written decrypted
+    if( !m_bStream || m_pEncrypt || !m_device.Device() || !m_pOwner )
+        return false;
+
+    try {
+        lOffset = FindStreamData( lLen );
+    } catch( PdfError & ) {
+        // loading the stream reports the error
+        return false;
+    }
+
+    // a stream running past the end of the file gets loaded,
+    // which keeps what can be read of it
+    PdfInputDevice* pInput = m_device.Device();
+    pInput->Seek( 0, std::ios_base::end );
+    return lLen >= 0 && lOffset + lLen <= pInput->Tell();
+}
+
+bool PdfParserObject::CanWriteRawStream() const
+{
+    pdf_int64 lLen;
+    pdf_long  lOffset;
+    return FindRawStream( lOffset, lLen );
+}
+
+void PdfParserObject::WriteRawStream( PdfOutputDevice* pDevice ) const
+{
+    pdf_int64 lLen;
+    pdf_long  lOffset;
+    if( !FindRawStream( lOffset, lLen ) )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_InternalLogic );
+    }
+
+    pDevice->Print( "stream\n" );
+    m_device.Device()->CopyTo( pDevice, lOffset, static_cast<pdf_long>(lLen) );
+    pDevice->Print( "\nendstream\n" );
+}
+
 void PdfParserObject::DelayedLoadImpl()
 {
 #if defined(PODOFO_EXTRA_CHECKS)
@@ -115,6 +115,20 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     inline void SetObjectNumber( unsigned int nObjNo );
 
+    /** \returns the encryption object the stream of this
+     *            object is decrypted with, or NULL
+     */
+    inline PdfEncrypt* GetEncrypt() const;
+
+    /** Set the encryption object the stream of this object is
+     *  decrypted with, when it was parsed with a copy of it.
+     *  It is only included for usage in the PdfParser.
+     *
+     *  \param pEncrypt an encryption object equal to the one
+     *                  passed to ParseFile
+     */
+    inline void SetEncrypt( PdfEncrypt* pEncrypt );
+
     /** Tries to free all memory allocated by this
      *  PdfObject (variables and streams) and reads
      *  it from disk again if it is requested another time.
@@ -161,6 +175,16 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
      */
     void ParseStream();
 
+    /** Whether the stream can be written straight from the input
+     *  device. Reimplemented from PdfObject.
+     */
+    virtual bool CanWriteRawStream() const;
+
+    /** Write the stream straight from the input device, if it
+     *  was not loaded. Reimplemented from PdfObject.
+     */
+    virtual void WriteRawStream( PdfOutputDevice* pDevice ) const;
+
  private:
     /** Initialize private members in this object with their default values
      */
@@ -174,6 +198,22 @@ class PODOFO_API PdfParserObject : public PdfObject, public PdfTokenizer {
 
     void ReadObjectNumber();
 
+    /** Find the data of the stream and its length.
+     *
+     *  \param lLen the value of the /Length key
+     *  \returns the offset of the first byte of the stream data
+     */
+    pdf_long FindStreamData( pdf_int64 & lLen ) const;
+
+    /** Find the data of the stream, if it can be copied as it is:
+     *  it is not encrypted, and lies within the input device.
+     *
+     *  \param lOffset the offset of the first byte of the stream data
+     *  \param lLen the length of the stream data
+     *  \returns false if the stream has to be loaded to be written
+     */
+    bool FindRawStream( pdf_long & lOffset, pdf_int64 & lLen ) const;
+
  private:
     PdfEncrypt* m_pEncrypt;
     bool        m_bIsTrailer;
@@ -201,6 +241,22 @@ void PdfParserObject::SetObjectNumber( unsigned int nObjNo )
     m_reference.SetObjectNumber( nObjNo );
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+PdfEncrypt* PdfParserObject::GetEncrypt() const
+{
+    return m_pEncrypt;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfParserObject::SetEncrypt( PdfEncrypt* pEncrypt )
+{
+    m_pEncrypt = pEncrypt;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
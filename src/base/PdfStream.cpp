@@ -51,7 +51,7 @@ namespace PoDoFo {
 enum EPdfFilter PdfStream::eDefaultFilter = ePdfFilter_FlateDecode;
 
 PdfStream::PdfStream( PdfObject* pParent )
-    : m_pParent( pParent ), m_bAppend( false )
+    : m_pParent( pParent ), m_bAppend( false ), m_bFlateParameters( false )
 {
 }
 
@@ -246,6 +246,12 @@ void PdfStream::BeginAppend( const TVecFilters & vecFilters, bool bClearExisting
     }
 }
 
+void PdfStream::SetFlateParameters( const PdfFlateParameters & rParameters )
+{
+    m_flateParameters  = rParameters;
+    m_bFlateParameters = true;
+}
+
 void PdfStream::EndAppend()
 {
     PODOFO_RAISE_LOGIC_IF( !m_bAppend, "EndAppend() failed because BeginAppend() was not yet called!" );
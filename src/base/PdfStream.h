@@ -269,6 +269,22 @@ class PODOFO_API PdfStream {
      */
     void GetFilteredCopy( PdfOutputStream* pStream ) const;
     
+    /** Set how the Flate filter encodes the data of this stream,
+     *  when it is set or appended, or compressed while writing it.
+     *  These parameters take precedence over those of the PdfWriter.
+     *
+     *  \param rParameters the Flate parameters of this stream
+     *
+     *  \see PdfWriter::SetFlateParameters
+     */
+    void SetFlateParameters( const PdfFlateParameters & rParameters );
+
+    /**
+     *  \returns the Flate parameters of this stream, or NULL
+     *            if SetFlateParameters() was not called
+     */
+    inline const PdfFlateParameters* GetFlateParameters() const;
+
     /** Create a copy of a PdfStream object
      *  \param rhs the object to clone
      *  \returns a reference to this object
@@ -316,6 +332,9 @@ class PODOFO_API PdfStream {
     PdfObject*          m_pParent;
 
     bool                m_bAppend;
+
+    bool                m_bFlateParameters;
+    PdfFlateParameters  m_flateParameters;
 };
 
 // -----------------------------------------------------
@@ -362,6 +381,14 @@ bool PdfStream::IsAppending() const
     return m_bAppend;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfFlateParameters* PdfStream::GetFlateParameters() const
+{
+    return m_bFlateParameters ? &m_flateParameters : NULL;
+}
+
 };
 
 #endif // _PDF_STREAM_H_
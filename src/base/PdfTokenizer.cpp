@@ -52,6 +52,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+// SSE2 is part of every x86-64 processor, AVX2 is used when the processor
+// at hand has it. Other processors classify bytes one at a time.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PODOFO_TOKENIZER_SSE2 1
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PODOFO_TOKENIZER_AVX2 1
+#endif
+#endif
+
+#if defined(_MSC_VER) && defined(PODOFO_TOKENIZER_SSE2)
+#include <intrin.h>
+#endif
+
 #define PDF_BUFFER 4096
 
 #define DICT_SEP_LENGTH 2
@@ -148,6 +163,334 @@ const char* genHexMap()
     return map;
 }
 
+// Scanners return the index of the first byte of pBuffer, up to lLen,
+// where a run of bytes of a class ends.
+
+// the end of a run of whitespace
+static size_t SkipWhitespaceScalar( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    while( i < lLen && PdfTokenizer::IsWhitespace( pBuffer[i] ) )
+        ++i;
+    return i;
+}
+
+// the end of a comment, at the first end of line character
+static size_t FindEolScalar( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    while( i < lLen && pBuffer[i] != 0x0D && pBuffer[i] != 0x0A )
+        ++i;
+    return i;
+}
+
+// the end of a regular token, at the first whitespace or delimiter
+static size_t FindTokenEndScalar( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    while( i < lLen && PdfTokenizer::IsRegular( pBuffer[i] ) )
+        ++i;
+    return i;
+}
+
+#ifdef PODOFO_TOKENIZER_SSE2
+static inline unsigned FirstBit( unsigned nMask )
+{
+#ifdef _MSC_VER
+    unsigned long nIndex;
+    _BitScanForward( &nIndex, nMask );
+    return nIndex;
+#else
+    return __builtin_ctz( nMask );
+#endif
+}
+
+// The classes are tested with comparisons, as SSE2 has no byte shuffle:
+// pairs of characters that differ by a single bit are tested at once.
+static inline __m128i IsWhitespace16( __m128i v )
+{
+    __m128i m = _mm_cmpeq_epi8( v, _mm_setzero_si128() );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x09 ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x0A ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( _mm_and_si128( v, _mm_set1_epi8( ~0x01 ) ), _mm_set1_epi8( 0x0C ) ) );
+    return _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x20 ) ) );
+}
+
+static inline __m128i IsDelimiter16( __m128i v )
+{
+    const __m128i vOr  = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+    __m128i       m    = _mm_cmpeq_epi8( _mm_and_si128( v, _mm_set1_epi8( ~0x01 ) ), _mm_set1_epi8( '(' ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( _mm_and_si128( v, _mm_set1_epi8( ~0x02 ) ), _mm_set1_epi8( '<' ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( vOr, _mm_set1_epi8( '{' ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( vOr, _mm_set1_epi8( '}' ) ) );
+    m = _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '/' ) ) );
+    return _mm_or_si128( m, _mm_cmpeq_epi8( v, _mm_set1_epi8( '%' ) ) );
+}
+
+static inline __m128i IsEol16( __m128i v )
+{
+    return _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x0D ) ),
+                         _mm_cmpeq_epi8( v, _mm_set1_epi8( 0x0A ) ) );
+}
+
+static size_t SkipWhitespaceSSE2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        const __m128i v     = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pBuffer + i) );
+        const unsigned nMask = ~_mm_movemask_epi8( IsWhitespace16( v ) ) & 0xFFFF;
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + SkipWhitespaceScalar( pBuffer + i, lLen - i );
+}
+
+static size_t FindEolSSE2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        const __m128i v     = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pBuffer + i) );
+        const unsigned nMask = _mm_movemask_epi8( IsEol16( v ) );
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + FindEolScalar( pBuffer + i, lLen - i );
+}
+
+static size_t FindTokenEndSSE2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 16 <= lLen; i += 16 )
+    {
+        const __m128i v     = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pBuffer + i) );
+        const unsigned nMask = _mm_movemask_epi8( _mm_or_si128( IsWhitespace16( v ), IsDelimiter16( v ) ) );
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + FindTokenEndScalar( pBuffer + i, lLen - i );
+}
+#endif // PODOFO_TOKENIZER_SSE2
+
+#ifdef PODOFO_TOKENIZER_AVX2
+#define PODOFO_AVX2 __attribute__((target("avx2")))
+
+PODOFO_AVX2 static inline __m256i IsWhitespace32( __m256i v )
+{
+    __m256i m = _mm256_cmpeq_epi8( v, _mm256_setzero_si256() );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 0x09 ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 0x0A ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( _mm256_and_si256( v, _mm256_set1_epi8( ~0x01 ) ), _mm256_set1_epi8( 0x0C ) ) );
+    return _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 0x20 ) ) );
+}
+
+PODOFO_AVX2 static inline __m256i IsDelimiter32( __m256i v )
+{
+    const __m256i vOr = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) );
+    __m256i       m   = _mm256_cmpeq_epi8( _mm256_and_si256( v, _mm256_set1_epi8( ~0x01 ) ), _mm256_set1_epi8( '(' ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( _mm256_and_si256( v, _mm256_set1_epi8( ~0x02 ) ), _mm256_set1_epi8( '<' ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( vOr, _mm256_set1_epi8( '{' ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( vOr, _mm256_set1_epi8( '}' ) ) );
+    m = _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '/' ) ) );
+    return _mm256_or_si256( m, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '%' ) ) );
+}
+
+PODOFO_AVX2 static size_t SkipWhitespaceAVX2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 32 <= lLen; i += 32 )
+    {
+        const __m256i  v     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pBuffer + i) );
+        const unsigned nMask = ~static_cast<unsigned>(_mm256_movemask_epi8( IsWhitespace32( v ) ));
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + SkipWhitespaceSSE2( pBuffer + i, lLen - i );
+}
+
+PODOFO_AVX2 static size_t FindEolAVX2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 32 <= lLen; i += 32 )
+    {
+        const __m256i  v     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pBuffer + i) );
+        const unsigned nMask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 0x0D ) ),
+                             _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 0x0A ) ) ) ));
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + FindEolSSE2( pBuffer + i, lLen - i );
+}
+
+PODOFO_AVX2 static size_t FindTokenEndAVX2( const char* pBuffer, size_t lLen )
+{
+    size_t i = 0;
+    for( ; i + 32 <= lLen; i += 32 )
+    {
+        const __m256i  v     = _mm256_loadu_si256( reinterpret_cast<const __m256i*>(pBuffer + i) );
+        const unsigned nMask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256( IsWhitespace32( v ), IsDelimiter32( v ) ) ));
+        if( nMask )
+            return i + FirstBit( nMask );
+    }
+    return i + FindTokenEndSSE2( pBuffer + i, lLen - i );
+}
+
+#undef PODOFO_AVX2
+#endif // PODOFO_TOKENIZER_AVX2
+
+// Most runs are a few bytes long, and are cheaper to scan inline:
+// only the bytes after the first few go through a scanner
+static const size_t s_lShortRun = 16;
+
+struct TScanner {
+    size_t (*SkipWhitespace)( const char* pBuffer, size_t lLen );
+    size_t (*FindEol)( const char* pBuffer, size_t lLen );
+    size_t (*FindTokenEnd)( const char* pBuffer, size_t lLen );
+};
+
+// the fastest scanners the processor at hand supports
+static TScanner ChooseScanner()
+{
+#ifdef PODOFO_TOKENIZER_AVX2
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ) )
+    {
+        TScanner scanner = { SkipWhitespaceAVX2, FindEolAVX2, FindTokenEndAVX2 };
+        return scanner;
+    }
+#endif // PODOFO_TOKENIZER_AVX2
+
+#ifdef PODOFO_TOKENIZER_SSE2
+    TScanner scanner = { SkipWhitespaceSSE2, FindEolSSE2, FindTokenEndSSE2 };
+#else
+    TScanner scanner = { SkipWhitespaceScalar, FindEolScalar, FindTokenEndScalar };
+#endif // PODOFO_TOKENIZER_SSE2
+    return scanner;
+}
+
+static TScanner & GetScanner()
+{
+    static TScanner s_scanner = ChooseScanner();
+    return s_scanner;
+}
+
+// Powers of ten that are exact doubles
+static const double s_dPowersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// Integers of up to 18 digits fit a pdf_int64, and reals of up to 15
+// digits have a mantissa that is an exact double: dividing it by an
+// exact power of ten rounds correctly, as strtod does.
+static const int s_nMaxIntegerDigits = 18;
+static const int s_nMaxRealDigits    = 15;
+
+/** Classify a token made of the characters of numbers (digits, signs and
+ *  dots) as a number or a real, and convert it in the same pass.
+ *
+ *  Only numbers of the form [+-]digits[.digits] which convert exactly are
+ *  converted. The others, like "1-2" or "1.2.3", are left to the slower
+ *  conversions which handle them.
+ *
+ *  \param rbConverted set to true if rlNumber or rdReal was set
+ *  \returns ePdfDataType_Number, ePdfDataType_Real, or ePdfDataType_Unknown
+ *           if the token has other characters
+ */
+static EPdfDataType ScanNumber( const char* pToken, size_t lLen, pdf_int64 & rlNumber, double & rdReal, bool & rbConverted )
+{
+    EPdfDataType eDataType = ePdfDataType_Number;
+    bool         bSimple   = true;
+    pdf_uint64   lMantissa = 0;
+    int          nDigits   = 0;
+    int          nFraction = 0;
+
+    for( size_t i = 0; i < lLen; i++ )
+    {
+        const unsigned char c = static_cast<unsigned char>(pToken[i]);
+        if( static_cast<unsigned char>(c - '0') < 10 )
+        {
+            // only used while there are few enough digits not to overflow
+            lMantissa = lMantissa * 10 + (c - '0');
+            ++nDigits;
+            if( eDataType == ePdfDataType_Real )
+                ++nFraction;
+        }
+        else if( c == '.' )
+        {
+            bSimple   = bSimple && eDataType != ePdfDataType_Real;
+            eDataType = ePdfDataType_Real;
+        }
+        else if( c == '-' || c == '+' )
+            bSimple = bSimple && !i;
+        else
+        {
+            rbConverted = false;
+            return ePdfDataType_Unknown;
+        }
+    }
+
+    const bool bNegative = lLen && pToken[0] == '-';
+    if( eDataType == ePdfDataType_Number )
+    {
+        rbConverted = bSimple && nDigits && nDigits <= s_nMaxIntegerDigits;
+        if( rbConverted )
+            rlNumber = bNegative ? -static_cast<pdf_int64>(lMantissa) : static_cast<pdf_int64>(lMantissa);
+    }
+    else
+    {
+        rbConverted = bSimple && nDigits && nDigits <= s_nMaxRealDigits;
+        if( rbConverted )
+        {
+            rdReal = static_cast<double>(lMantissa) / s_dPowersOf10[nFraction];
+            if( bNegative )
+                rdReal = -rdReal;
+        }
+    }
+
+    return eDataType;
+}
+
+/** Convert the integer at the start of a token as strtol does,
+ *  for the tokens ScanNumber() does not convert.
+ *
+ *  \param rbParsed set to false if the token does not start with an integer
+ */
+static pdf_int64 ParseInteger( const char* pToken, size_t lLen, bool & rbParsed )
+{
+    // strtol needs a NULL-terminated copy of the token
+    const std::string sNumber( pToken, lLen );
+    char*             pszEnd;
+#ifdef _WIN64
+    const pdf_int64 lNumber = static_cast<pdf_int64>(_strtoui64( sNumber.c_str(), &pszEnd, 10 ));
+#else
+    const pdf_int64 lNumber = static_cast<pdf_int64>(strtol( sNumber.c_str(), &pszEnd, 10 ));
+#endif
+    rbParsed = pszEnd != sNumber.c_str();
+    return lNumber;
+}
+
+/** Convert an integer token, as ScanNumber() or else ParseInteger() does.
+ *
+ *  \param rbParsed set to false if the token does not start with an integer
+ */
+static pdf_int64 ReadInteger( const char* pToken, size_t lLen, bool & rbParsed )
+{
+    pdf_int64 lNumber;
+    double    dReal;
+    bool      bConverted;
+    if( ScanNumber( pToken, lLen, lNumber, dReal, bConverted ) == ePdfDataType_Number && bConverted )
+    {
+        rbParsed = true;
+        return lNumber;
+    }
+
+    return ParseInteger( pToken, lLen, rbParsed );
+}
+
 };
 
 const unsigned int PdfTokenizer::HEX_NOT_FOUND   = std::numeric_limits<unsigned int>::max();
@@ -207,7 +550,76 @@ PdfTokenizer::~PdfTokenizer()
 {
 }
 
+bool PdfTokenizer::SetScanner( EPdfScanner eScanner )
+{
+    PdfTokenizerNameSpace::TScanner scanner;
+
+    switch( eScanner )
+    {
+        case ePdfScanner_Default:
+            scanner = PdfTokenizerNameSpace::ChooseScanner();
+            break;
+        case ePdfScanner_Scalar:
+            scanner.SkipWhitespace = PdfTokenizerNameSpace::SkipWhitespaceScalar;
+            scanner.FindEol        = PdfTokenizerNameSpace::FindEolScalar;
+            scanner.FindTokenEnd   = PdfTokenizerNameSpace::FindTokenEndScalar;
+            break;
+#ifdef PODOFO_TOKENIZER_SSE2
+        case ePdfScanner_SSE2:
+            scanner.SkipWhitespace = PdfTokenizerNameSpace::SkipWhitespaceSSE2;
+            scanner.FindEol        = PdfTokenizerNameSpace::FindEolSSE2;
+            scanner.FindTokenEnd   = PdfTokenizerNameSpace::FindTokenEndSSE2;
+            break;
+#endif // PODOFO_TOKENIZER_SSE2
+#ifdef PODOFO_TOKENIZER_AVX2
+        case ePdfScanner_AVX2:
+            __builtin_cpu_init();
+            if( !__builtin_cpu_supports( "avx2" ) )
+                return false;
+
+            scanner.SkipWhitespace = PdfTokenizerNameSpace::SkipWhitespaceAVX2;
+            scanner.FindEol        = PdfTokenizerNameSpace::FindEolAVX2;
+            scanner.FindTokenEnd   = PdfTokenizerNameSpace::FindTokenEndAVX2;
+            break;
+#endif // PODOFO_TOKENIZER_AVX2
+        default:
+            return false;
+    }
+
+    PdfTokenizerNameSpace::GetScanner() = scanner;
+    return true;
+}
+
 bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
+{
+    const char* pToken;
+    size_t      lLen;
+
+    if( !this->GetNextTokenView( pToken, lLen, peType ) )
+    {
+        // Ensure the buffer points to NULL in case someone fails to check the return value.
+        pszToken = 0;
+        return false;
+    }
+
+    // tokens read into the buffer are already \0 terminated
+    if( pToken != m_buffer.GetBuffer() )
+    {
+        if ( !m_buffer.GetBuffer() || m_buffer.GetSize() == 0)
+        {
+            PODOFO_RAISE_ERROR(ePdfError_InvalidHandle);
+        }
+
+        lLen = PDF_MIN( lLen, m_buffer.GetSize() - 1 );
+        memcpy( m_buffer.GetBuffer(), pToken, lLen );
+        m_buffer.GetBuffer()[lLen] = '\0';
+    }
+
+    pszToken = m_buffer.GetBuffer();
+    return true;
+}
+
+bool PdfTokenizer::GetNextTokenView( const char*& pToken, size_t& lLen, EPdfTokenType* peType )
 {
     int  c;
     pdf_int64  counter  = 0;
@@ -215,24 +627,20 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
     // check first if there are queued tokens and return them first
     if( m_deqQueque.size() )
     {
-        TTokenizerPair pair = m_deqQueque.front();
-        m_deqQueque.pop_front();
+        const TTokenizerToken & token = m_deqQueque.front();
 
+        pToken = token.pszView ? token.pszView : &m_vecQueueBuffer[token.lOffset];
+        lLen   = token.lLen;
         if( peType )
-            *peType = pair.second;
+            *peType = token.eType;
 
-        if ( !m_buffer.GetBuffer() || m_buffer.GetSize() == 0)
-        {
-            PODOFO_RAISE_ERROR(ePdfError_InvalidHandle);
-        }
-
-        // make sure buffer is \0 terminated
-        strncpy(m_buffer.GetBuffer(), pair.first.c_str(), m_buffer.GetSize());
-        m_buffer.GetBuffer()[m_buffer.GetSize() - 1] = 0;
-        pszToken = m_buffer.GetBuffer();
+        m_deqQueque.pop_front();
         return true;
     }
 
+    // all queued tokens were read, and the last one is invalidated now
+    m_vecQueueBuffer.clear();
+
     if( !m_device.Device() )
     {
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
@@ -241,14 +649,30 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
     if( peType )
         *peType = ePdfTokenType_Token;
 
-    while( (c = m_device.Device()->Look()) != EOF
-           && counter + 1 < static_cast<pdf_int64>(m_buffer.GetSize()) )
+    // runs of whitespace, comments and regular characters are
+    // scanned in the read buffer of the device, many bytes at once
+    const PdfTokenizerNameSpace::TScanner & scanner = PdfTokenizerNameSpace::GetScanner();
+    PdfInputDevice* pDevice = m_device.Device();
+    char*           pBuffer = m_buffer.GetBuffer();
+    const pdf_int64 lMax    = static_cast<pdf_int64>(m_buffer.GetSize()) - 1;
+
+    while( (c = pDevice->Look()) != EOF
+           && counter < lMax )
     {
+        const char*  pRead = pDevice->GetReadBuffer();
+        const size_t lRead = pDevice->GetReadBufferLength();
+
         // ignore leading whitespaces
         if( !counter && IsWhitespace( c ) )
         {
-            // Consume the whitespace character
-            c = m_device.Device()->GetChar();
+            // Consume the whitespace characters
+            size_t lSkip = 1;
+            while( lSkip < lRead && lSkip < PdfTokenizerNameSpace::s_lShortRun && IsWhitespace( pRead[lSkip] ) )
+                ++lSkip;
+            if( lSkip == PdfTokenizerNameSpace::s_lShortRun )
+                lSkip += scanner.SkipWhitespace( pRead + lSkip, lRead - lSkip );
+
+            pDevice->SkipReadBuffer( lSkip );
             continue;
         }
         // ignore comments
@@ -256,14 +680,28 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
         {
             // Consume all characters before the next line break
 			// 2011-04-19 Ulrich Arnold: accept 0x0D, 0x0A and oX0D 0x0A as one EOL
-            do {
-                c = m_device.Device()->GetChar();
-            } while( c != EOF && c != 0x0D  && c != 0x0A );
+            for( ;; )
+            {
+                const size_t lEol = scanner.FindEol( pDevice->GetReadBuffer(), pDevice->GetReadBufferLength() );
+                if( lEol < pDevice->GetReadBufferLength() )
+                {
+                    pDevice->SkipReadBuffer( lEol );
+                    c = pDevice->GetChar();
+                    break;
+                }
+
+                pDevice->SkipReadBuffer( lEol );
+                if( pDevice->Look() == EOF )
+                {
+                    c = EOF;
+                    break;
+                }
+            }
 
             if ( c == 0x0D )
 			{
-                if ( m_device.Device()->Look() == 0x0A )
-	                c = m_device.Device()->GetChar();
+                if ( pDevice->Look() == 0x0A )
+	                c = pDevice->GetChar();
 			}
             // If we've already read one or more chars of a token, return them, since
             // comments are treated as token-delimiting whitespace. Otherwise keep reading
@@ -277,18 +715,27 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
             if( peType )
                 *peType = ePdfTokenType_Delimiter;
 
+            // hand out the token in place if the character after it was read
+            if( lRead > 1 || pDevice->IsStableBuffer( pRead, lRead ) )
+            {
+                lLen = (lRead > 1 && pRead[1] == c) ? 2 : 1;
+                pToken = pRead;
+                pDevice->SkipReadBuffer( lLen );
+                return true;
+            }
+
             // retrieve c really from stream
-            c = m_device.Device()->GetChar();
-            m_buffer.GetBuffer()[counter] = c;
+            c = pDevice->GetChar();
+            pBuffer[counter] = c;
             ++counter;
 
-            char n = m_device.Device()->Look();
+            char n = pDevice->Look();
             // Is n another < or > , ie are we opening/closing a dictionary?
             // If so, consume that character too.
             if( n == c )
             {
-                n = m_device.Device()->GetChar();
-                m_buffer.GetBuffer()[counter] = n;
+                n = pDevice->GetChar();
+                pBuffer[counter] = n;
                 ++counter;
             }
             // `m_buffer' contains one of < , > , << or >> ; we're done .
@@ -300,22 +747,43 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
             // we have a complete token and can return it.
             break;
         }
-        else
+        else if( IsDelimiter( c ) )
         {
-            // Consume the next character and add it to the token we're building.
-            c = m_device.Device()->GetChar();
-            m_buffer.GetBuffer()[counter] = c;
-            ++counter;
+            // All delimeters except << and >> (handled above) are
+            // one-character tokens, so if we hit one we can just return it
+            // immediately.
+            if( peType )
+                *peType = ePdfTokenType_Delimiter;
 
-            if( IsDelimiter( c ) )
+            pToken = pRead;
+            lLen   = 1;
+            pDevice->SkipReadBuffer( 1 );
+            return true;
+        }
+        else
+        {
+            // Consume the regular characters and add them to the token we're building.
+            const size_t lAvailable = PDF_MIN( lRead, static_cast<size_t>(lMax - counter) );
+            size_t       lToken     = 1;
+            while( lToken < lAvailable && lToken < PdfTokenizerNameSpace::s_lShortRun && IsRegular( pRead[lToken] ) )
+                ++lToken;
+            if( lToken == PdfTokenizerNameSpace::s_lShortRun )
+                lToken += scanner.FindTokenEnd( pRead + lToken, lAvailable - lToken );
+
+            // A token ending before the read buffer does, or at the end
+            // of stable memory, is complete: hand it out in place. Comments
+            // right after a token are consumed with it, by the loop.
+            if( !counter && (lToken < lRead ? pRead[lToken] != '%' : pDevice->IsStableBuffer( pRead, lRead )) )
             {
-                // All delimeters except << and >> (handled above) are
-                // one-character tokens, so if we hit one we can just return it
-                // immediately.
-                if( peType )
-                    *peType = ePdfTokenType_Delimiter;
-                break;
+                pToken = pRead;
+                lLen   = lToken;
+                pDevice->SkipReadBuffer( lToken );
+                return true;
             }
+
+            memcpy( pBuffer + counter, pRead, lToken );
+            pDevice->SkipReadBuffer( lToken );
+            counter += lToken;
         }
     }
 
@@ -324,12 +792,12 @@ bool PdfTokenizer::GetNextToken( const char*& pszToken , EPdfTokenType* peType )
     if( c == EOF && !counter )
     {
         // No characters were read before EOF, so we're out of data.
-        // Ensure the buffer points to NULL in case someone fails to check the return value.
-        pszToken = 0;
+        pToken = 0;
         return false;
     }
 
-    pszToken = m_buffer.GetBuffer();
+    pToken = m_buffer.GetBuffer();
+    lLen   = static_cast<size_t>(counter);
     return true;
 }
 
@@ -340,61 +808,65 @@ bool PdfTokenizer::IsNextToken( const char* pszToken )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
-    const char* pszRead;
-    bool gotToken = this->GetNextToken( pszRead, NULL );
+    const char* pRead;
+    size_t      lRead;
+    bool gotToken = this->GetNextTokenView( pRead, lRead, NULL );
 
     if (!gotToken)
     {
         PODOFO_RAISE_ERROR( ePdfError_UnexpectedEOF );
     }
 
-    return (strcmp( pszToken, pszRead ) == 0);
+    return (strlen( pszToken ) == lRead && memcmp( pszToken, pRead, lRead ) == 0);
 }
 
 pdf_long PdfTokenizer::GetNextNumber()
 {
     EPdfTokenType eType;
-    const char* pszRead;
-    bool gotToken = this->GetNextToken( pszRead, &eType );
+    const char*   pRead;
+    size_t        lRead;
+    bool gotToken = this->GetNextTokenView( pRead, lRead, &eType );
 
     if( !gotToken )
     {
         PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "Expected number" );
     }
 
-    char* end;
-#ifdef _WIN64
-    pdf_long l = _strtoui64( pszRead, &end, 10 );
-#else
-    pdf_long l = strtol( pszRead, &end, 10 );
-#endif
-    if( end == pszRead )
+    bool            bParsed;
+    const pdf_int64 l = PdfTokenizerNameSpace::ReadInteger( pRead, lRead, bParsed );
+    if( !bParsed )
     {
         // Don't consume the token
-        this->QuequeToken( pszRead, eType );
-        PODOFO_RAISE_ERROR_INFO( ePdfError_NoNumber, pszRead );
+        this->QuequeToken( pRead, lRead, eType );
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NoNumber, std::string( pRead, lRead ).c_str() );
     }
 
-    return l;
+    return static_cast<pdf_long>(l);
 }
 
 void PdfTokenizer::GetNextVariant( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 {
    EPdfTokenType eTokenType;
-   const char*   pszRead;
-   bool gotToken = this->GetNextToken( pszRead, &eTokenType );
+   const char*   pRead;
+   size_t        lRead;
+   bool gotToken = this->GetNextTokenView( pRead, lRead, &eTokenType );
 
    if (!gotToken)
    {
        PODOFO_RAISE_ERROR_INFO( ePdfError_UnexpectedEOF, "Expected variant." );
    }
 
-   this->GetNextVariant( pszRead, eTokenType, rVariant, pEncrypt );
+   this->GetNextVariant( pRead, lRead, eTokenType, rVariant, pEncrypt );
 }
 
 void PdfTokenizer::GetNextVariant( const char* pszToken, EPdfTokenType eType, PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 {
-    EPdfDataType eDataType = this->DetermineDataType( pszToken, eType, rVariant );
+    this->GetNextVariant( pszToken, strlen( pszToken ), eType, rVariant, pEncrypt );
+}
+
+void PdfTokenizer::GetNextVariant( const char* pToken, size_t lLen, EPdfTokenType eType, PdfVariant& rVariant, PdfEncrypt* pEncrypt )
+{
+    EPdfDataType eDataType = this->DetermineDataType( pToken, lLen, eType, rVariant );
 
     if( eDataType == ePdfDataType_Null ||
         eDataType == ePdfDataType_Bool ||
@@ -410,57 +882,53 @@ void PdfTokenizer::GetNextVariant( const char* pszToken, EPdfTokenType eType, Pd
 }
 
 EPdfDataType PdfTokenizer::DetermineDataType( const char* pszToken, EPdfTokenType eTokenType, PdfVariant& rVariant )
+{
+    return this->DetermineDataType( pszToken, strlen( pszToken ), eTokenType, rVariant );
+}
+
+EPdfDataType PdfTokenizer::DetermineDataType( const char* pToken, size_t lLen, EPdfTokenType eTokenType, PdfVariant& rVariant )
 {
     if( eTokenType == ePdfTokenType_Token )
     {
         // check for the two special datatypes
         // null and boolean.
         // check for numbers
-        if( strncmp( "null", pszToken, NULL_LENGTH ) == 0 )
+        if( lLen >= NULL_LENGTH && memcmp( "null", pToken, NULL_LENGTH ) == 0 )
         {
             rVariant = PdfVariant();
             return ePdfDataType_Null;
         }
-        else if( strncmp( "true", pszToken, TRUE_LENGTH ) == 0 )
+        else if( lLen >= TRUE_LENGTH && memcmp( "true", pToken, TRUE_LENGTH ) == 0 )
         {
             rVariant = PdfVariant( true );
             return ePdfDataType_Bool;
         }
-        else if( strncmp( "false", pszToken, FALSE_LENGTH ) == 0 )
+        else if( lLen >= FALSE_LENGTH && memcmp( "false", pToken, FALSE_LENGTH ) == 0 )
         {
             rVariant = PdfVariant( false );
             return ePdfDataType_Bool;
         }
 
-        EPdfDataType eDataType = ePdfDataType_Number;
-        const char*  pszStart  = pszToken;
-
-        while( *pszStart )
-        {
-            if( *pszStart == '.' )
-                eDataType = ePdfDataType_Real;
-            else if( !(isdigit( static_cast<const unsigned char>(*pszStart) ) || *pszStart == '-' || *pszStart == '+' ) )
-            {
-                eDataType = ePdfDataType_Unknown;
-                break;
-            }
-
-            ++pszStart;
-        }
+        // numbers are classified and converted in a single pass
+        pdf_int64          lNumber;
+        double             dVal;
+        bool               bConverted;
+        const EPdfDataType eDataType = PdfTokenizerNameSpace::ScanNumber( pToken, lLen, lNumber, dVal, bConverted );
 
         if( eDataType == ePdfDataType_Real )
         {
-            // DOM: strtod is locale dependend,
-            //      do not use it
-            //double dVal = strtod( pszToken, NULL );
-            double dVal;
-
-            m_doubleParser.clear(); // clear error state
-            m_doubleParser.str( pszToken );
-            if( !(m_doubleParser >> dVal) )
+            if( !bConverted )
             {
+                // DOM: strtod is locale dependend,
+                //      do not use it
+                //double dVal = strtod( pszToken, NULL );
                 m_doubleParser.clear(); // clear error state
-                PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, pszToken );
+                m_doubleParser.str( std::string( pToken, lLen ) );
+                if( !(m_doubleParser >> dVal) )
+                {
+                    m_doubleParser.clear(); // clear error state
+                    PODOFO_RAISE_ERROR_INFO( ePdfError_InvalidDataType, std::string( pToken, lLen ).c_str() );
+                }
             }
 
             rVariant = PdfVariant( dVal );
@@ -468,71 +936,78 @@ EPdfDataType PdfTokenizer::DetermineDataType( const char* pszToken, EPdfTokenTyp
         }
         else if( eDataType == ePdfDataType_Number )
         {
-#ifdef _WIN64
-            rVariant = PdfVariant( static_cast<pdf_int64>(_strtoui64( pszToken, NULL, 10 )) );
-#else
-            rVariant = PdfVariant( static_cast<pdf_int64>(strtol( pszToken, NULL, 10 )) );
-#endif
+            if( !bConverted )
+            {
+                bool bParsed;
+                lNumber = PdfTokenizerNameSpace::ParseInteger( pToken, lLen, bParsed );
+            }
+
+            rVariant = PdfVariant( lNumber );
+
             // read another two tokens to see if it is a reference
             // we cannot be sure that there is another token
             // on the input device, so if we hit EOF just return
             // ePdfDataType_Number .
             EPdfTokenType eSecondTokenType;
-            bool gotToken = this->GetNextToken( pszToken, &eSecondTokenType );
+            const char*   pSecond;
+            size_t        lSecond;
+            bool gotToken = this->GetNextTokenView( pSecond, lSecond, &eSecondTokenType );
             if (!gotToken)
                 // No next token, so it can't be a reference
                 return eDataType;
-            if( eSecondTokenType != ePdfTokenType_Token )
+
+            bool            bParsed = false;
+            const pdf_int64 l       = eSecondTokenType == ePdfTokenType_Token
+                ? PdfTokenizerNameSpace::ReadInteger( pSecond, lSecond, bParsed ) : 0;
+            if( !bParsed )
             {
-                this->QuequeToken( pszToken, eSecondTokenType );
+                this->QuequeToken( pSecond, lSecond, eSecondTokenType );
                 return eDataType;
             }
 
-
-            pszStart = pszToken;
-#ifdef _WIN64
-            pdf_long  l   = _strtoui64( pszStart, const_cast<char**>(&pszToken), 10 );
-#else
-            long  l   = strtol( pszStart, const_cast<char**>(&pszToken), 10 );
-#endif
-            if( pszToken == pszStart )
+            // Reading the third token from the input device invalidates the
+            // second one, unless it is in the stable memory of the device:
+            // a copy is queued instead.
+            std::string backup;
+            if( m_deqQueque.empty() && !(m_device.Device() && m_device.Device()->IsStableBuffer( pSecond, lSecond )) )
             {
-                this->QuequeToken( pszStart, eSecondTokenType );
-                return eDataType;
+                backup.assign( pSecond, lSecond );
+                pSecond = backup.c_str();
             }
 
-            std::string backup( pszStart );
             EPdfTokenType eThirdTokenType;
-            gotToken = this->GetNextToken( pszToken, &eThirdTokenType );
+            const char*   pThird;
+            size_t        lThird;
+            gotToken = this->GetNextTokenView( pThird, lThird, &eThirdTokenType );
             if (!gotToken)
                 // No third token, so it can't be a reference
                 return eDataType;
             if( eThirdTokenType == ePdfTokenType_Token &&
-                pszToken[0] == 'R' && pszToken[1] == '\0' )
+                lThird == 1 && pThird[0] == 'R' )
             {
-                rVariant = PdfReference( static_cast<unsigned int>(rVariant.GetNumber()),
+                rVariant = PdfReference( static_cast<unsigned int>(lNumber),
                                          static_cast<const pdf_uint16>(l) );
                 return ePdfDataType_Reference;
             }
             else
             {
-                this->QuequeToken( backup.c_str(), eSecondTokenType );
-                this->QuequeToken( pszToken, eThirdTokenType );
+                this->QuequeToken( pSecond, lSecond, eSecondTokenType );
+                this->QuequeToken( pThird, lThird, eThirdTokenType );
                 return eDataType;
             }
         }
     }
     else if( eTokenType == ePdfTokenType_Delimiter )
     {
-        if( strncmp( "<<", pszToken, DICT_SEP_LENGTH ) == 0 )
+        if( lLen >= DICT_SEP_LENGTH && memcmp( "<<", pToken, DICT_SEP_LENGTH ) == 0 )
             return ePdfDataType_Dictionary;
-        else if( pszToken[0] == '[' )
+        else if( pToken[0] == '[' )
             return ePdfDataType_Array;
-        else if( pszToken[0] == '(' )
+        else if( pToken[0] == '(' )
             return ePdfDataType_String;
-        else if( pszToken[0] == '<' )
+        else if( pToken[0] == '<' )
             return ePdfDataType_HexString;
-        else if( pszToken[0] == '/' )
+        else if( pToken[0] == '/' )
             return ePdfDataType_Name;
     }
 
@@ -545,7 +1020,7 @@ EPdfDataType PdfTokenizer::DetermineDataType( const char* pszToken, EPdfTokenTyp
         ss << "Got unexpected PDF data in" << PODOFO__FUNCTION__
 #endif
            << ": \""
-           << pszToken
+           << std::string( pToken, lLen )
            << "\". Current read offset is "
            << m_device.Device()->Tell()
            << " which should be around the problem.\n";
@@ -599,32 +1074,34 @@ void PdfTokenizer::ReadDictionary( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
     PdfName       key;
     PdfDictionary dict;
     EPdfTokenType eType;
-    const char *  pszToken;
+    const char *  pToken;
+    size_t        lLen;
 
     long dict_start_offset = m_device.Device()->Tell();
 
-    std::vector<std::string> key_vect;
+    // names are interned, so copying and sorting keys is cheap
+    std::vector<PdfName> key_vect;
     for( ;; )
     {
-        bool gotToken = this->GetNextToken( pszToken, &eType );
+        bool gotToken = this->GetNextTokenView( pToken, lLen, &eType );
         if (!gotToken)
             PODOFO_RAISE_ERROR_INFO(ePdfError_UnexpectedEOF, "Expected dictionary key name or >> delim.");
 
-        if( eType == ePdfTokenType_Delimiter && strncmp( ">>", pszToken, DICT_SEP_LENGTH ) == 0 )
+        if( eType == ePdfTokenType_Delimiter && lLen >= DICT_SEP_LENGTH && memcmp( ">>", pToken, DICT_SEP_LENGTH ) == 0 )
             break;
 
-        this->GetNextVariant( pszToken, eType, val, pEncrypt );
+        this->GetNextVariant( pToken, lLen, eType, val, pEncrypt );
         // Convert the read variant to a name; throws InvalidDataType if not a name.
         key = val.GetName();
 
         // 'Contents' key of a /Type/Sig dictionary is an unencrypted Hex string
-        bool bIsSigContents = key == PdfName( "Contents" ) &&
-            dict.HasKey( "Type" ) &&
-            dict.GetKey( "Type" )->GetDataType() == ePdfDataType_Name &&
-            dict.GetKey( "Type" )->GetName() == PdfName( "Sig" );
+        bool bIsSigContents = key == PdfName::KeyContents &&
+            dict.HasKey( PdfName::KeyType ) &&
+            dict.GetKey( PdfName::KeyType )->GetDataType() == ePdfDataType_Name &&
+            dict.GetKey( PdfName::KeyType )->GetName() == PdfName( "Sig" );
 
         if (key != PdfName::KeyType)
-            key_vect.push_back(key.GetName());
+            key_vect.push_back(key);
 
         // Get the next variant. If there isn't one, it'll throw UnexpectedEOF.
         this->GetNextVariant( val, bIsSigContents ? NULL : pEncrypt );
@@ -647,22 +1124,23 @@ void PdfTokenizer::ReadDictionary( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 
 void PdfTokenizer::ReadArray( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 {
-    const char*   pszToken;
+    const char*   pToken;
+    size_t        lLen;
     EPdfTokenType eType;
     PdfVariant    var;
     PdfArray      array;
 
     for( ;; )
     {
-        bool gotToken = this->GetNextToken( pszToken, &eType );
+        bool gotToken = this->GetNextTokenView( pToken, lLen, &eType );
         if (!gotToken)
         {
             PODOFO_RAISE_ERROR_INFO(ePdfError_UnexpectedEOF, "Expected array item or ] delim.");
         }
-        if( eType == ePdfTokenType_Delimiter && pszToken[0] == ']' )
+        if( eType == ePdfTokenType_Delimiter && pToken[0] == ']' )
             break;
 
-        this->GetNextVariant( pszToken, eType, var, pEncrypt );
+        this->GetNextVariant( pToken, lLen, eType, var, pEncrypt );
         array.push_back( var );
     }
 
@@ -812,7 +1290,8 @@ void PdfTokenizer::ReadHexString( PdfVariant& rVariant, PdfEncrypt* pEncrypt )
 void PdfTokenizer::ReadName( PdfVariant& rVariant )
 {
     EPdfTokenType eType;
-    const char*   pszToken;
+    const char*   pToken;
+    size_t        lLen;
 
     // Do special checking for empty names
     // as GetNextToken will ignore white spaces
@@ -827,7 +1306,7 @@ void PdfTokenizer::ReadName( PdfVariant& rVariant )
         return;
     }
 
-    bool gotToken = this->GetNextToken( pszToken, &eType );
+    bool gotToken = this->GetNextTokenView( pToken, lLen, &eType );
     if( !gotToken || eType != ePdfTokenType_Token )
     {
         // We got an empty name which is legal according to the PDF specification
@@ -836,15 +1315,43 @@ void PdfTokenizer::ReadName( PdfVariant& rVariant )
 
         // Enqueue the token again
         if( gotToken )
-            QuequeToken( pszToken, eType );
+            QuequeToken( pToken, lLen, eType );
     }
     else
-        rVariant = PdfName::FromEscaped( pszToken );
+        rVariant = PdfName::FromEscaped( pToken, static_cast<pdf_long>(lLen) );
 }
 
 void PdfTokenizer::QuequeToken( const char* pszToken, EPdfTokenType eType )
 {
-    m_deqQueque.push_back( TTokenizerPair( std::string( pszToken ), eType ) );
+    this->QuequeToken( pszToken, strlen( pszToken ), eType );
+}
+
+void PdfTokenizer::QuequeToken( const char* pToken, size_t lLen, EPdfTokenType eType )
+{
+    TTokenizerToken token;
+    token.pszView = NULL;
+    token.lLen    = lLen;
+    token.eType   = eType;
+
+    const char* pQueued = m_vecQueueBuffer.size() ? &m_vecQueueBuffer[0] : NULL;
+    if( m_device.Device() && m_device.Device()->IsStableBuffer( pToken, lLen ) )
+    {
+        // the token stays valid as long as the input device
+        token.pszView = pToken;
+        token.lOffset = 0;
+    }
+    else if( pQueued && pToken >= pQueued && pToken + lLen <= pQueued + m_vecQueueBuffer.size() )
+    {
+        // a token read from the queue again, which was already copied
+        token.lOffset = static_cast<size_t>(pToken - pQueued);
+    }
+    else
+    {
+        token.lOffset = m_vecQueueBuffer.size();
+        m_vecQueueBuffer.insert( m_vecQueueBuffer.end(), pToken, pToken + lLen );
+    }
+
+    m_deqQueque.push_back( token );
 }
 
 };
@@ -54,8 +54,30 @@ enum EPdfTokenType {
     ePdfTokenType_Unknown = 0xFF
 };
 
-typedef std::pair<std::string,EPdfTokenType> TTokenizerPair;
-typedef std::deque<TTokenizerPair>           TTokenizerQueque;
+/** The implementations a PdfTokenizer scans runs of
+ *  whitespace, comments and regular tokens with.
+ */
+enum EPdfScanner {
+    ePdfScanner_Default, ///< The fastest one the processor supports
+    ePdfScanner_Scalar,  ///< One byte at a time
+    ePdfScanner_SSE2,    ///< 16 bytes at a time
+    ePdfScanner_AVX2     ///< 32 bytes at a time
+};
+
+/** A token in the queue of a PdfTokenizer.
+ *
+ *  Tokens that are part of the stable memory of the input device
+ *  (see PdfInputDevice::IsStableBuffer) are queued as they are;
+ *  the others are copied to the queue buffer of the tokenizer.
+ */
+struct TTokenizerToken {
+    const char*   pszView;  ///< the token in the input, or NULL if it was copied
+    size_t        lOffset;  ///< offset of the copied token in the queue buffer
+    size_t        lLen;
+    EPdfTokenType eType;
+};
+
+typedef std::deque<TTokenizerToken>          TTokenizerQueque;
 typedef TTokenizerQueque::iterator           TITokenizerQueque;
 typedef TTokenizerQueque::const_iterator     TCITokenizerQueque;
 
@@ -90,9 +112,33 @@ class PODOFO_API PdfTokenizer {
      *                     more tokens to read.
      *
      *  \see GetBuffer
+     *  \see GetNextTokenView
      */
     virtual bool GetNextToken( const char *& pszToken, EPdfTokenType* peType = NULL);
 
+    /** Reads the next token from the current file position
+     *  ignoring all comments, without copying it when possible.
+     *
+     *  Tokens which are all in the read buffer of the input device are
+     *  not copied to the buffer of the tokenizer, as GetNextToken() does:
+     *  when reading from a buffer or a mapped file, most tokens are handed
+     *  out in place, and queued tokens are not copied either.
+     *
+     *  \param[out] pToken On true return, set to the first character of the
+     *                     token, which is NOT NULL-terminated. It points to
+     *                     the input or to memory owned by PdfTokenizer, and
+     *                     is invalidated by the next call reading from the
+     *                     tokenizer or the input device.
+     *  \param[out] lLen   On true return, set to the length of the token,
+     *                     which is never 0.
+     *  \param[out] peType On true return, if not NULL the type of the read token
+     *                     will be stored into this parameter.
+     *
+     *  \returns           True if a token was read, false if there are no
+     *                     more tokens to read.
+     */
+    virtual bool GetNextTokenView( const char *& pToken, size_t & lLen, EPdfTokenType* peType = NULL );
+
     /** Reads the next token from the current file position
      *  ignoring all comments and compare the passed token
      *  to the read token.
@@ -171,6 +217,17 @@ class PODOFO_API PdfTokenizer {
      */
     static const unsigned int HEX_NOT_FOUND;
 
+    /** Choose how all tokenizers scan runs of bytes, so that tests
+     *  and benchmarks can run each implementation. Call it only while
+     *  no tokenizer is reading.
+     *
+     *  \param eScanner the implementation to use
+     *
+     *  \returns false, leaving the current one in place, if this
+     *           build or the processor at hand lacks the implementation
+     */
+    static bool SetScanner( EPdfScanner eScanner );
+
  protected:
     /** Read the next variant from the current file position
      *  ignoring all comments.
@@ -184,6 +241,20 @@ class PODOFO_API PdfTokenizer {
      */
     void GetNextVariant( const char* pszToken, EPdfTokenType eType, PdfVariant& rVariant, PdfEncrypt* pEncrypt );
 
+    /** Read the next variant from the current file position
+     *  ignoring all comments.
+     *
+     *  \param pToken a token that has already been read, which does not have
+     *                to be NULL-terminated
+     *  \param lLen length of the token
+     *  \param eType type of the passed token
+     *  \param rVariant write the read variant to this value
+     *  \param pEncrypt an encryption object which is used to decrypt strings during parsing
+     *
+     *  \see GetNextTokenView
+     */
+    void GetNextVariant( const char* pToken, size_t lLen, EPdfTokenType eType, PdfVariant& rVariant, PdfEncrypt* pEncrypt );
+
     /** Determine the possible datatype of a token.
      *  Numbers, reals, bools or NULL values are parsed directly by this function
      *  and saved to a variant.
@@ -192,6 +263,15 @@ class PODOFO_API PdfTokenizer {
      */
     EPdfDataType DetermineDataType( const char* pszToken, EPdfTokenType eType, PdfVariant& rVariant );
 
+    /** Determine the possible datatype of a token,
+     *  which does not have to be NULL-terminated.
+     *
+     *  \returns the expected datatype
+     *
+     *  \see GetNextTokenView
+     */
+    EPdfDataType DetermineDataType( const char* pToken, size_t lLen, EPdfTokenType eType, PdfVariant& rVariant );
+
     void ReadDataType( EPdfDataType eDataType, PdfVariant& rVariant, PdfEncrypt* pEncrypt );
 
     /** Read a dictionary from the input device
@@ -246,6 +326,17 @@ class PODOFO_API PdfTokenizer {
      */
     void QuequeToken( const char* pszToken, EPdfTokenType eType );
 
+    /** Add a token, which does not have to be NULL-terminated,
+     *  to the queue of tokens.
+     *
+     *  \param pToken first character of the token
+     *  \param lLen length of the token
+     *  \param eType type of the token
+     *
+     *  \see GetNextTokenView
+     */
+    void QuequeToken( const char* pToken, size_t lLen, EPdfTokenType eType );
+
  protected:
     PdfRefCountedInputDevice m_device;
     PdfRefCountedBuffer      m_buffer;
@@ -264,6 +355,11 @@ class PODOFO_API PdfTokenizer {
 
     TTokenizerQueque m_deqQueque;
 
+    // Copies of the queued tokens that are not in the stable memory of
+    // the input device. It is emptied when the queue is, and is a member
+    // of the class to avoid reallocations while parsing.
+    std::vector<char> m_vecQueueBuffer;
+
     // A vector which is used as a buffer to read strings.
     // It is a member of the class to avoid reallocations while parsing.
     std::vector<char> m_vecBuffer; // we use a vector instead of a string
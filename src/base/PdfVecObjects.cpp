@@ -50,6 +50,11 @@ inline bool ObjectLittle( const PoDoFo::PdfObject* p1, const PoDoFo::PdfObject*
     return *p1 < *p2;
 }
 
+// The lookup table of GetObject() grows up to this many entries
+// more than twice the object count. Objects with higher numbers go
+// to a map, so that a few huge object numbers do not cost much memory.
+const size_t s_nIndexSlack = 4096;
+
 };
 
 namespace PoDoFo {
@@ -101,7 +106,7 @@ private:
 };
 
 PdfVecObjects::PdfVecObjects()
-    : m_bAutoDelete( false ), m_bCanReuseObjectNumbers( true ), m_nObjectCount( 1 ), m_bSorted( true ), m_pDocument( NULL ), m_pStreamFactory( NULL )
+    : m_bAutoDelete( false ), m_bCanReuseObjectNumbers( true ), m_nObjectCount( 1 ), m_bSorted( true ), m_nSortedSize( 0 ), m_pDocument( NULL ), m_pStreamFactory( NULL )
 {
 }
 
@@ -135,27 +140,32 @@ void PdfVecObjects::Clear()
     }
 
     m_vector.clear();
+    m_vecIndex.clear();
+    m_mapSparse.clear();
 
     m_bAutoDelete    = false;
     m_nObjectCount   = 1;
     m_bSorted        = true; // an emtpy vector is sorted
+    m_nSortedSize    = 0;
     m_pDocument      = NULL;
     m_pStreamFactory = NULL;
 }
 
 PdfObject* PdfVecObjects::GetObject( const PdfReference & ref ) const
 {
-    if( !m_bSorted )
-        const_cast<PdfVecObjects*>(this)->Sort();
-
-    PdfObject refObj( ref, NULL );
-    TCIVecObjects it = std::lower_bound( m_vector.begin(), m_vector.end(), &refObj, ObjectComparatorPredicate() );
-    if( it != m_vector.end() && (refObj.Reference() == (*it)->Reference()) )
+    const size_t nObjNo = ref.ObjectNumber();
+    if( nObjNo < m_vecIndex.size() )
     {
-        return *it;
+        PdfObject* pObj = m_vecIndex[nObjNo];
+        if( pObj && pObj->Reference().GenerationNumber() == ref.GenerationNumber() )
+            return pObj;
     }
 
-    return NULL;
+    if( m_mapSparse.empty() )
+        return NULL;
+
+    TCIMapSparseObjects it = m_mapSparse.find( ref );
+    return it != m_mapSparse.end() ? it->second : NULL;
 }
 
 size_t PdfVecObjects::GetIndex( const PdfReference & ref ) const
@@ -191,6 +201,7 @@ PdfObject* PdfVecObjects::RemoveObject( const PdfReference & ref, bool bMarkAsFr
         pObj = *(it.first);
         if( bMarkAsFree )
             this->AddFreeObject( pObj->Reference() );
+        this->RemoveFromIndex( pObj );
         m_vector.erase( it.first );
         return pObj;
     }
@@ -201,6 +212,7 @@ PdfObject* PdfVecObjects::RemoveObject( const PdfReference & ref, bool bMarkAsFr
 PdfObject* PdfVecObjects::RemoveObject( const TIVecObjects & it )
 {
     PdfObject* pObj = *it;
+    this->RemoveFromIndex( pObj );
     m_vector.erase( it );
     return pObj;
 }
@@ -281,16 +293,65 @@ void PdfVecObjects::insert_sorted( PdfObject* pObj )
     SetObjectCount( pObj->Reference() );
     pObj->SetOwner( this );
 
+    // Shifting the vector for each object inserted out of order takes
+    // quadratic time, when reading object streams for instance. The
+    // vector is sorted when it is iterated, which GetObject() does not need.
     if( m_bSorted && !m_vector.empty() && pObj->Reference() < m_vector.back()->Reference() )
     {
-        TVecObjects::iterator i_pos = 
-            std::lower_bound(m_vector.begin(),m_vector.end(),pObj,ObjectLittle);
-        m_vector.insert(i_pos, pObj );
+        m_bSorted     = false;
+        m_nSortedSize = m_vector.size();
+    }
+
+    m_vector.push_back( pObj );
+    this->AddToIndex( pObj );
+}
+
+void PdfVecObjects::AddToIndex( PdfObject* pObj )
+{
+    const PdfReference & ref    = pObj->Reference();
+    const size_t         nObjNo = ref.ObjectNumber();
+
+    if( nObjNo >= m_vecIndex.size() )
+    {
+        if( nObjNo >= PDF_MAX( m_vecIndex.capacity(), 2 * m_vector.size() + s_nIndexSlack ) )
+        {
+            m_mapSparse.insert( TMapSparseObjects::value_type( ref, pObj ) );
+            return;
+        }
+
+        m_vecIndex.resize( nObjNo + 1, NULL );
     }
-    else 
+
+    // another object has this number already
+    if( m_vecIndex[nObjNo] )
+        m_mapSparse.insert( TMapSparseObjects::value_type( ref, pObj ) );
+    else
+        m_vecIndex[nObjNo] = pObj;
+}
+
+void PdfVecObjects::RemoveFromIndex( const PdfObject* pObj )
+{
+    const PdfReference & ref    = pObj->Reference();
+    const size_t         nObjNo = ref.ObjectNumber();
+
+    if( nObjNo < m_vecIndex.size() && m_vecIndex[nObjNo] == pObj )
     {
-        m_vector.push_back( pObj );
+        m_vecIndex[nObjNo] = NULL;
+        return;
     }
+
+    TIMapSparseObjects it = m_mapSparse.find( ref );
+    if( it != m_mapSparse.end() && it->second == pObj )
+        m_mapSparse.erase( it );
+}
+
+void PdfVecObjects::RebuildIndex()
+{
+    m_vecIndex.clear();
+    m_mapSparse.clear();
+
+    for( TCIVecObjects it = m_vector.begin(); it != m_vector.end(); ++it )
+        this->AddToIndex( *it );
 }
 
 void PdfVecObjects::RenumberObjects( PdfObject* pTrailer, TPdfReferenceSet* pNotDelete, bool bDoGarbageCollection )
@@ -333,7 +394,7 @@ void PdfVecObjects::RenumberObjects( PdfObject* pTrailer, TPdfReferenceSet* pNot
         ++it;
     }
 
-    
+    this->RebuildIndex();
 }
 
 void PdfVecObjects::InsertOneReferenceIntoVector( const PdfObject* pObj, TVecReferencePointerList* pList )  
@@ -474,7 +535,10 @@ void PdfVecObjects::Sort()
 {
     if( !m_bSorted )
     {
-        std::sort( this->begin(), this->end(), ObjectLittle );
+        // the objects appended out of order are usually few
+        TIVecObjects itAppended = m_vector.begin() + m_nSortedSize;
+        std::sort( itAppended, m_vector.end(), ObjectLittle );
+        std::inplace_merge( m_vector.begin(), itAppended, m_vector.end(), ObjectLittle );
         m_bSorted = true;
     }
 }
@@ -87,6 +87,10 @@ typedef TVecObjects::const_iterator  TCIVecObjects;
  *
  *  These class contains also advanced funtions for searching of PdfObject's
  *  in a PdfVecObject. 
+ *
+ *  Objects are also indexed by object number, so that GetObject()
+ *  takes constant time. Objects inserted out of order are appended,
+ *  and the vector is sorted again the next time it is iterated.
  */
 class PODOFO_API PdfVecObjects {
     friend class PdfWriter;
@@ -153,6 +157,10 @@ class PODOFO_API PdfVecObjects {
     typedef TVecObservers::iterator       TIVecObservers;
     typedef TVecObservers::const_iterator TCIVecObservers;
 
+    typedef std::map<PdfReference,PdfObject*>  TMapSparseObjects;
+    typedef TMapSparseObjects::iterator        TIMapSparseObjects;
+    typedef TMapSparseObjects::const_iterator  TCIMapSparseObjects;
+
  public:
     /** Default constuctor 
      */
@@ -222,6 +230,10 @@ class PODOFO_API PdfVecObjects {
 
     /** Finds the object with the given reference in m_vecOffsets 
      *  and returns a pointer to it if it is found.
+     *
+     *  This takes constant time, unless the object numbers
+     *  of the vector are very sparse.
+     *
      *  \param ref the object to be found
      *  \returns the found object or NULL if no object was found.
      */
@@ -305,6 +317,9 @@ class PODOFO_API PdfVecObjects {
      *  the vector remains sorted w.r.t. 
      *  the ordering based on object and generation numbers
      *  m_bObjectCount will be increased for the object.
+     *
+     *  Objects are always appended: the vector is sorted again
+     *  when it is iterated, if pObj was inserted out of order.
      * 
      *  \param pObj pointer to the object you want to insert
      */
@@ -313,6 +328,9 @@ class PODOFO_API PdfVecObjects {
 
     /** 
      * Sort the objects in the vector based on their object and generation numbers
+     *
+     * Only the objects inserted out of order since the vector was
+     * last sorted are sorted, then merged with the others.
      */
     void Sort();
 
@@ -464,13 +482,33 @@ class PODOFO_API PdfVecObjects {
      */
     void GarbageCollection( TVecReferencePointerList* pList, PdfObject* pTrailer, TPdfReferenceSet* pNotDelete = NULL );
 
+    /** Add an object to the lookup table of GetObject()
+     *  \param pObj an object of the vector
+     */
+    void AddToIndex( PdfObject* pObj );
+
+    /** Remove an object from the lookup table of GetObject()
+     *  \param pObj an object of the vector
+     */
+    void RemoveFromIndex( const PdfObject* pObj );
+
+    /** Build the lookup table of GetObject() again,
+     *  after objects were renumbered
+     */
+    void RebuildIndex();
+
  private:
     bool                m_bAutoDelete;
     bool                m_bCanReuseObjectNumbers;
     size_t              m_nObjectCount;
     bool                m_bSorted;
+    size_t              m_nSortedSize;   ///< objects sorted when m_bSorted was last true
     TVecObjects         m_vector;
 
+    TVecObjects         m_vecIndex;      ///< objects by object number, or NULL
+    TMapSparseObjects   m_mapSparse;     ///< objects with an object number too high for m_vecIndex,
+                                         ///< or another generation of an object of m_vecIndex
+
 
     TVecObservers       m_vecObservers;
     TPdfReferenceList   m_lstFreeObjects;
@@ -497,6 +535,7 @@ inline size_t PdfVecObjects::GetSize() const
 inline void PdfVecObjects::Reserve( size_t size )
 {
     m_vector.reserve( size );
+    m_vecIndex.reserve( size );
 }
 
 // -----------------------------------------------------
@@ -568,6 +607,9 @@ inline void PdfVecObjects::SetStreamFactory( StreamFactory* pFactory )
 // -----------------------------------------------------
 inline TIVecObjects PdfVecObjects::begin()
 {
+    if( !m_bSorted )
+        this->Sort();
+
     return m_vector.begin();
 }
 
@@ -576,6 +618,9 @@ inline TIVecObjects PdfVecObjects::begin()
 // -----------------------------------------------------
 inline TCIVecObjects PdfVecObjects::begin() const
 {
+    if( !m_bSorted )
+        const_cast<PdfVecObjects*>(this)->Sort();
+
     return m_vector.begin();
 }
 
@@ -584,6 +629,9 @@ inline TCIVecObjects PdfVecObjects::begin() const
 // -----------------------------------------------------
 inline TIVecObjects PdfVecObjects::end()
 {
+    if( !m_bSorted )
+        this->Sort();
+
     return m_vector.end();
 }
 
@@ -592,6 +640,9 @@ inline TIVecObjects PdfVecObjects::end()
 // -----------------------------------------------------
 inline TCIVecObjects PdfVecObjects::end() const
 {
+    if( !m_bSorted )
+        const_cast<PdfVecObjects*>(this)->Sort();
+
     return m_vector.end();
 }
 
@@ -600,6 +651,9 @@ inline TCIVecObjects PdfVecObjects::end() const
 // -----------------------------------------------------
 inline PdfObject* PdfVecObjects::GetBack() 
 { 
+    if( !m_bSorted )
+        this->Sort();
+
     return m_vector.back(); 
 }
 
@@ -624,7 +678,13 @@ inline void PdfVecObjects::SetObjectCount( const PdfReference & rRef )
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
-inline PdfObject*& PdfVecObjects::operator[](size_t index) { return m_vector[index]; }
+inline PdfObject*& PdfVecObjects::operator[](size_t index)
+{
+    if( !m_bSorted )
+        this->Sort();
+
+    return m_vector[index];
+}
 
 //inline PdfObject const * & PdfVecObjects::operator[](int index) const { return m_vector[index]; }
 
@@ -36,6 +36,7 @@
 #include "PdfData.h"
 #include "PdfDate.h"
 #include "PdfDictionary.h"
+#include "PdfMemStream.h"
 //#include "PdfHintStream.h"
 #include "PdfObject.h"
 #include "PdfParser.h"
@@ -51,17 +52,284 @@
 #define LINEARIZATION_PADDING "          " 
 
 #include <iostream>
+#include <sstream>
 #include <stdlib.h>
+#include <math.h>
+
+#ifdef PODOFO_MULTI_THREAD
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#endif // PODOFO_MULTI_THREAD
 
 namespace PoDoFo {
 
+namespace {
+
+/** Sums the number of payload bits PdfDictionary::Write pulls from
+ *  a dictencode_stream for a variant and everything nested inside it.
+ */
+class PdfDictEncodeCounter {
+ public:
+    /** \param pReport if not NULL, each dictionary counted is added
+     *                 to the histogram and floor loss of this report
+     */
+    PdfDictEncodeCounter( PdfDictEncodeReport* pReport = NULL )
+        : m_pReport( pReport )
+    {
+    }
+
+    size_t Count( const PdfVariant & rVariant );
+
+ private:
+    /** Capacity of a dictionary with nKeys non /Type keys.
+     *  Most documents only use a handful of distinct key counts,
+     *  so values are cached instead of computing a factorial each time.
+     */
+    size_t KeyCountBits( size_t nKeys );
+
+    std::vector<size_t>  m_vecKeyCountBits;
+    PdfDictEncodeReport* m_pReport;
+};
+
+size_t PdfDictEncodeCounter::Count( const PdfVariant & rVariant )
+{
+    size_t nBits = 0;
+
+    if( rVariant.IsDictionary() )
+    {
+        const TKeyMap & rKeys = rVariant.GetDictionary().GetKeys();
+        size_t          nKeys = 0;
+
+        // the type key is always written first and never carries data
+        for( TCIKeyMap it = rKeys.begin(); it != rKeys.end(); ++it )
+        {
+            if( (*it).first != PdfName::KeyType )
+                ++nKeys;
+
+            nBits += this->Count( *(*it).second );
+        }
+
+        const size_t nKeyBits = this->KeyCountBits( nKeys );
+        nBits += nKeyBits;
+
+        if( m_pReport )
+        {
+            if( nKeys >= m_pReport->keyCounts.size() )
+                m_pReport->keyCounts.resize( nKeys + 1, 0 );
+            ++m_pReport->keyCounts[nKeys];
+
+            // log2(n!) through the log gamma function, as n! itself overflows
+            if( nKeys > 1 )
+                m_pReport->floorLossBits += lgamma( static_cast<double>(nKeys + 1) ) / log( 2.0 ) - nKeyBits;
+        }
+    }
+    else if( rVariant.IsArray() )
+    {
+        const PdfArray & rArray = rVariant.GetArray();
+        for( PdfArray::const_iterator it = rArray.begin(); it != rArray.end(); ++it )
+            nBits += this->Count( *it );
+    }
+
+    return nBits;
+}
+
+size_t PdfDictEncodeCounter::KeyCountBits( size_t nKeys )
+{
+    if( nKeys >= m_vecKeyCountBits.size() )
+        m_vecKeyCountBits.resize( nKeys + 1, static_cast<size_t>(-1) );
+
+    if( m_vecKeyCountBits[nKeys] == static_cast<size_t>(-1) )
+        m_vecKeyCountBits[nKeys] = size_available_bits( nKeys );
+
+    return m_vecKeyCountBits[nKeys];
+}
+
+/** Write an object with its stream Flate compressed, unless the
+ *  stream is empty or has a filter already. The stream is compressed
+ *  into a copy of the object, so that the document is left as it is.
+ */
+void WriteObjectCompressed( PdfObject* pObject, PdfOutputDevice* pDevice, EPdfWriteMode eWriteMode,
+                            PdfEncrypt* pEncrypt, const PdfFlateParameters & rParameters )
+{
+    const PdfMemStream* pStream = pObject->HasStream() ? dynamic_cast<const PdfMemStream*>(pObject->GetStream()) : NULL;
+    if( !pStream || !pStream->GetLength() || pObject->GetDictionary().HasKey( PdfName::KeyFilter ) )
+    {
+        pObject->WriteObject( pDevice, eWriteMode, pEncrypt );
+        return;
+    }
+
+    // the parameters of the stream win, as in PdfMemStream::FlateCompress()
+    const PdfFlateParameters* pParameters = pStream->GetFlateParameters() ? pStream->GetFlateParameters() : &rParameters;
+    std::auto_ptr<PdfFilter>  pFilter     = PdfFilterFactory::Create( ePdfFilter_FlateDecode, pParameters );
+    if( !pFilter.get() )
+    {
+        PODOFO_RAISE_ERROR( ePdfError_UnsupportedFilter );
+    }
+
+    // the copy gets a memory stream from an owner of its own, as the
+    // stream factory of the document may write streams as they are made
+    char*         pBuffer;
+    pdf_long      lLen;
+    PdfVecObjects owner;
+    PdfObject     compressed( pObject->Reference(), pObject->GetDictionary() );
+    compressed.SetOwner( &owner );
+
+    pFilter->Encode( pStream->Get(), pStream->GetLength(), &pBuffer, &lLen );
+    try {
+        compressed.GetDictionary().AddKey( PdfName::KeyFilter, PdfName( "FlateDecode" ) );
+
+        // the data is encoded already
+        PdfStream* pCompressed = compressed.GetStream();
+        pCompressed->BeginAppend( TVecFilters(), true, false );
+        pCompressed->Append( pBuffer, lLen );
+        pCompressed->EndAppend();
+    } catch( PdfError & e ) {
+        podofo_free( pBuffer );
+        throw e;
+    }
+    podofo_free( pBuffer );
+
+    compressed.WriteObject( pDevice, eWriteMode, pEncrypt );
+}
+
+/** Removes the encryption dictionary a Write() added to the
+ *  objects of the document once it is done, on error as well,
+ *  as it cannot be reused.
+ */
+class PdfEncryptObjectScope {
+ public:
+    PdfEncryptObjectScope( PdfVecObjects* pVecObjects, PdfObject* & rpEncryptObj )
+        : m_pVecObjects( pVecObjects ), m_rpEncryptObj( rpEncryptObj )
+    {
+    }
+
+    ~PdfEncryptObjectScope()
+    {
+        if( m_rpEncryptObj )
+        {
+            m_pVecObjects->RemoveObject( m_rpEncryptObj->Reference() );
+            delete m_rpEncryptObj;
+            m_rpEncryptObj = NULL;
+        }
+    }
+
+ private:
+    PdfVecObjects*  m_pVecObjects;
+    PdfObject* &    m_rpEncryptObj;
+};
+
+};
+
+#ifdef PODOFO_MULTI_THREAD
+/** Threads serializing objects for a PdfWriter, started once for
+ *  a whole Write() and handed one task per object to serialize.
+ */
+class PdfWriteThreads {
+ public:
+    PdfWriteThreads( unsigned int nThreads );
+
+    /** Stops the threads once the tasks queued are done
+     */
+    ~PdfWriteThreads();
+
+    /** Queue a task, which must not throw
+     */
+    void Run( const std::function<void()> & task );
+
+ private:
+    void Work();
+
+    std::mutex                        m_mutex;
+    std::condition_variable           m_wake;
+    std::deque<std::function<void()>> m_tasks;
+    bool                              m_bStop;
+    std::vector<std::thread>          m_threads;
+};
+
+PdfWriteThreads::PdfWriteThreads( unsigned int nThreads )
+    : m_bStop( false )
+{
+    for( unsigned int i = 0; i < nThreads; i++ )
+        m_threads.emplace_back( &PdfWriteThreads::Work, this );
+}
+
+PdfWriteThreads::~PdfWriteThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_bStop = true;
+    }
+    m_wake.notify_all();
+
+    for( std::thread & thread : m_threads )
+        thread.join();
+}
+
+void PdfWriteThreads::Run( const std::function<void()> & task )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_tasks.push_back( task );
+    }
+    m_wake.notify_one();
+}
+
+void PdfWriteThreads::Work()
+{
+    for( ;; )
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_wake.wait( lock, [this]() { return m_bStop || !m_tasks.empty(); } );
+            if( m_tasks.empty() )
+                return;
+
+            task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+/** Owns the threads of a PdfWriter for the duration of a Write()
+ */
+class PdfWriteThreadsScope {
+ public:
+    PdfWriteThreadsScope( PdfWriteThreads* & rpThreads, unsigned int nThreads )
+        : m_rpThreads( rpThreads )
+    {
+        m_rpThreads = nThreads > 1 ? new PdfWriteThreads( nThreads ) : NULL;
+    }
+
+    ~PdfWriteThreadsScope()
+    {
+        delete m_rpThreads;
+        m_rpThreads = NULL;
+    }
+
+ private:
+    PdfWriteThreads* & m_rpThreads;
+};
+
+};
+#endif // PODOFO_MULTI_THREAD
+
 PdfWriter::PdfWriter( PdfParser* pParser )
     : m_bXRefStream( false ), m_pEncrypt( NULL ), 
       m_pEncryptObj( NULL ), 
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
+      m_bLinearized( false ), m_nWriteThreads( 0 ),
+      m_lWriteMemoryBudget( 64 * 1024 * 1024 ), m_pWriteThreads( NULL ),
+      m_nObjectStreamSize( 100 ),
+      m_lFirstInXRef( 0 ),
       m_lLinearizedOffset(0),
       m_lLinearizedLastOffset(0),
       m_lTrailerOffset(0)
@@ -82,7 +350,10 @@ PdfWriter::PdfWriter( PdfVecObjects* pVecObjects, const PdfObject* pTrailer )
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
+      m_bLinearized( false ), m_nWriteThreads( 0 ),
+      m_lWriteMemoryBudget( 64 * 1024 * 1024 ), m_pWriteThreads( NULL ),
+      m_nObjectStreamSize( 100 ),
+      m_lFirstInXRef( 0 ),
       m_lLinearizedOffset(0),
       m_lLinearizedLastOffset(0),
       m_lTrailerOffset(0)
@@ -103,7 +374,10 @@ PdfWriter::PdfWriter( PdfVecObjects* pVecObjects )
       m_eWriteMode( ePdfWriteMode_Compact ),
       m_lPrevXRefOffset( 0 ),
       m_bIncrementalUpdate( false ),
-      m_bLinearized( false ), m_lFirstInXRef( 0 ),
+      m_bLinearized( false ), m_nWriteThreads( 0 ),
+      m_lWriteMemoryBudget( 64 * 1024 * 1024 ), m_pWriteThreads( NULL ),
+      m_nObjectStreamSize( 100 ),
+      m_lFirstInXRef( 0 ),
       m_lLinearizedOffset(0),
       m_lLinearizedLastOffset(0),
       m_lTrailerOffset(0)
@@ -152,7 +426,20 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
         PODOFO_RAISE_ERROR( ePdfError_InvalidHandle );
     }
 
+    // compressing a stream adds a /Filter key to its dictionary
+    if( pDevice->dictencode_stream && (m_eWriteMode & ePdfWriteMode_CompressStreams) == ePdfWriteMode_CompressStreams )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Cannot hide a payload while compressing streams." );
+    }
+
+#ifdef PODOFO_MULTI_THREAD
+    // The encryption object keeps the reference of the object being
+    // encrypted, so encrypted documents are written serially.
+    PdfWriteThreadsScope threads( m_pWriteThreads, m_pEncrypt ? 0 : m_nWriteThreads );
+#endif // PODOFO_MULTI_THREAD
+
     // setup encrypt dictionary
+    PdfEncryptObjectScope encryptObj( m_vecObjects, m_pEncryptObj );
     if( m_pEncrypt )
     {
         m_pEncrypt->GenerateEncryptionKey( m_identifier );
@@ -171,7 +458,24 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
     }
     else
     {
-        PdfXRef* pXRef = m_bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
+        const bool bObjectStreams = this->UseObjectStreams();
+        if( bObjectStreams )
+        {
+            // the decoder only finds the payload in top level objects
+            if( pDevice->dictencode_stream )
+            {
+                PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Cannot hide a payload in objects packed into object streams." );
+            }
+
+            if( m_eVersion < ePdfVersion_1_5 )
+                m_eVersion = ePdfVersion_1_5;
+
+            // created before the XRef stream, which has to be the last object
+            this->CreateObjectStreams();
+        }
+
+        const bool bXRefStream = m_bXRefStream || bObjectStreams;
+        PdfXRef*   pXRef       = bXRefStream ? new PdfXRefStream( m_vecObjects, this ) : new PdfXRef();
 
         try {
             if( !m_bIncrementalUpdate )
@@ -185,12 +489,18 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
             pXRef->Write( pDevice );
             
             // XRef streams contain the trailer in the XRef
-            if( !m_bXRefStream ) 
+            if( !bXRefStream ) 
             {
                 PdfObject  trailer;
+                pdf_long   lSize = pXRef->GetSize();
+
+                // an update only lists the objects it changes,
+                // yet its /Size still counts every object
+                if( m_bIncrementalUpdate )
+                    lSize = PDF_MAX( lSize, static_cast<pdf_long>(m_vecObjects->GetObjectCount()) );
                 
                 // if we have a dummy offset we write also a prev entry to the trailer
-                FillTrailerObject( &trailer, pXRef->GetSize(), false );
+                FillTrailerObject( &trailer, lSize, false );
                 
                 pDevice->Print("trailer\n");
                 trailer.WriteObject( pDevice, m_eWriteMode, NULL ); // Do not encrypt the trailer dictionary!!!
@@ -198,26 +508,16 @@ void PdfWriter::Write( PdfOutputDevice* pDevice, bool bRewriteXRefTable )
             
             pDevice->Print( "startxref\n%" PDF_FORMAT_UINT64 "\n%%%%EOF\n", pXRef->GetOffset() );
             delete pXRef;
+            this->DeleteObjectStreams();
         } catch( PdfError & e ) {
             // Make sure pXRef is always deleted
             delete pXRef;
-            
-            // P.Zent: Delete Encryption dictionary (cannot be reused)
-            if(m_pEncryptObj) {
-                m_vecObjects->RemoveObject(m_pEncryptObj->Reference());
-                delete m_pEncryptObj;
-            }
+            this->DeleteObjectStreams();
             
             e.AddToCallstack( __FILE__, __LINE__ );
             throw e;
         }
     }
-    
-    // P.Zent: Delete Encryption dictionary (cannot be reused)
-    if(m_pEncryptObj) {
-        m_vecObjects->RemoveObject(m_pEncryptObj->Reference());
-        delete m_pEncryptObj;
-    }
 }
 
 void PdfWriter::WriteUpdate( PdfOutputDevice* pDevice, PdfInputDevice* pSourceInputDevice, bool bRewriteXRefTable )
@@ -359,6 +659,11 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
 {
     TCIVecObjects itObjects, itObjectsEnd = vecObjects.end();
 
+    // Write() only starts threads for documents it may write in parallel
+    const bool              bParallel = m_pWriteThreads != NULL;
+    const bool              bCompress = (m_eWriteMode & ePdfWriteMode_CompressStreams) == ePdfWriteMode_CompressStreams;
+    std::vector<PdfObject*> vecParallel;
+
     for( itObjects = vecObjects.begin(); itObjects !=  itObjectsEnd; ++itObjects )
     {
         PdfObject *pObject = *itObjects;
@@ -388,13 +693,38 @@ void PdfWriter::WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects&
             }
         }
 
+        if( !m_mapObjectStreamEntries.empty() )
+        {
+            TMapObjectStreamEntries::const_iterator itEntry = m_mapObjectStreamEntries.find( pObject->Reference() );
+            if( itEntry != m_mapObjectStreamEntries.end() )
+            {
+                // written as part of its object stream
+                pXref->AddCompressedObject( pObject->Reference(), (*itEntry).second.first, (*itEntry).second.second );
+                continue;
+            }
+        }
+
+        if( bParallel )
+        {
+            vecParallel.push_back( pObject );
+            continue;
+        }
+
         pXref->AddObject( pObject->Reference(), pDevice->Tell(), true );
 
         // Make sure that we do not encrypt the encryption dictionary!
-        pObject->WriteObject( pDevice, m_eWriteMode, 
-                              (pObject == m_pEncryptObj ? NULL : m_pEncrypt) );
+        PdfEncrypt* pEncrypt = pObject == m_pEncryptObj ? NULL : m_pEncrypt;
+        if( bCompress )
+            WriteObjectCompressed( pObject, pDevice, m_eWriteMode, pEncrypt, m_flateParameters );
+        else
+            pObject->WriteObject( pDevice, m_eWriteMode, pEncrypt );
     }
 
+#ifdef PODOFO_MULTI_THREAD
+    if( !vecParallel.empty() )
+        WriteObjectsParallel( pDevice, vecParallel, pXref );
+#endif // PODOFO_MULTI_THREAD
+
     TCIPdfReferenceList itFree, itFreeEnd = vecObjects.GetFreeObjects().end();
     for( itFree = vecObjects.GetFreeObjects().begin(); itFree != itFreeEnd; ++itFree )
     {
@@ -448,6 +778,295 @@ void PdfWriter::WriteToBuffer( char** ppBuffer, pdf_long* pulLen )
     this->Write( &memDevice );
 }
 
+#ifdef PODOFO_MULTI_THREAD
+void PdfWriter::WriteObjectsParallel( PdfOutputDevice* pDevice, const std::vector<PdfObject*> & vecObjects, PdfXRef* pXref )
+{
+    // an object serialized ahead of the one being written
+    struct TQueuedObject {
+        PdfRefCountedBuffer buffer;
+        pdf_long            lLength;
+        size_t              lStreamLength;
+        std::string         payload;
+        size_t              nCapacity;
+        bool                bRaw;
+        bool                bDone;
+    };
+
+    const size_t nObjects  = vecObjects.size();
+    const size_t nQueue    = static_cast<size_t>(m_nWriteThreads) * 16;
+    const bool   bCompress = (m_eWriteMode & ePdfWriteMode_CompressStreams) == ePdfWriteMode_CompressStreams;
+
+    bit_istream*               pPayload = pDevice->dictencode_stream;
+    PdfDictEncodeCounter       counter;
+    std::vector<TQueuedObject> vecQueue( nQueue );
+    size_t                     nQueued      = 0;
+    size_t                     lQueuedBytes = 0;
+    size_t                     nRunning     = 0;
+    bool                       bFailed      = false;
+    PdfError                   error;
+    std::mutex                 mutex;
+    std::condition_variable    done;
+
+    auto serialize = [&]( size_t i ) {
+        TQueuedObject & rQueued = vecQueue[i % nQueue];
+        bit_istream     bits( rQueued.payload.data(), rQueued.payload.size() );
+        PdfOutputDevice device( &rQueued.buffer );
+
+        device.dictencode_stream = pPayload ? &bits : NULL;
+        if( bCompress )
+            WriteObjectCompressed( vecObjects[i], &device, m_eWriteMode, NULL, m_flateParameters );
+        else
+            vecObjects[i]->WriteObject( &device, m_eWriteMode, NULL );
+
+        // the slice must be exactly what the object consumed
+        if( pPayload && bits.bit_size != rQueued.nCapacity )
+        {
+            PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Object capacity differs from the written payload bits." );
+        }
+        return device.GetLength();
+    };
+
+    auto task = [&]( size_t i ) {
+        bool bSkip;
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            bSkip = bFailed;
+        }
+
+        pdf_long lLength = 0;
+        try {
+            if( !bSkip )
+                lLength = serialize( i );
+        } catch( PdfError & e ) {
+            std::lock_guard<std::mutex> lock( mutex );
+            if( !bFailed )
+                error = e;
+            bFailed = true;
+        }
+
+        std::lock_guard<std::mutex> lock( mutex );
+        vecQueue[i % nQueue].lLength = lLength;
+        vecQueue[i % nQueue].bDone   = true;
+        --nRunning;
+        done.notify_all();
+    };
+
+    // Objects are loaded by this thread, as they share the input device,
+    // and get the payload bits they would get if written serially, which
+    // are their capacity worth of bits following the ones of the previous
+    // objects. A stream nobody loaded is copied from the input by this
+    // thread when the object is written, as a serial write does, unless
+    // it gets compressed.
+    auto queue = [&]() {
+        const size_t    i       = nQueued++;
+        PdfObject*      pObject = vecObjects[i];
+        TQueuedObject & rQueued = vecQueue[i % nQueue];
+
+        rQueued.bRaw          = !bCompress && pObject->IsStreamLoadPending();
+        rQueued.bDone         = false;
+        rQueued.lStreamLength = 0;
+        if( !rQueued.bRaw && pObject->HasStream() )
+            rQueued.lStreamLength = static_cast<size_t>(pObject->GetStream()->GetLength());
+        lQueuedBytes += rQueued.lStreamLength;
+
+        if( pPayload )
+        {
+            rQueued.nCapacity = counter.Count( *pObject );
+            rQueued.payload   = bit_istream_pull_bytes( *pPayload, rQueued.nCapacity );
+            pPayload->bit_size += rQueued.nCapacity;
+        }
+
+        if( rQueued.bRaw )
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            ++nRunning;
+        }
+        m_pWriteThreads->Run( std::bind( task, i ) );
+    };
+
+    try {
+        for( size_t i = 0; i < nObjects; i++ )
+        {
+            // keep the threads busy with the objects following this one,
+            // as long as the queue has room and their streams fit the budget
+            while( nQueued < nObjects && nQueued - i < nQueue
+                   && (nQueued == i || lQueuedBytes < m_lWriteMemoryBudget) )
+                queue();
+
+            TQueuedObject & rQueued = vecQueue[i % nQueue];
+            if( rQueued.bRaw )
+                rQueued.lLength = serialize( i );
+            else
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                done.wait( lock, [&]() { return rQueued.bDone; } );
+                if( bFailed )
+                    throw error;
+            }
+
+            pXref->AddObject( vecObjects[i]->Reference(), pDevice->Tell(), true );
+            pDevice->Write( rQueued.buffer.GetBuffer(), rQueued.lLength );
+
+            rQueued.buffer = PdfRefCountedBuffer();
+            lQueuedBytes  -= rQueued.lStreamLength;
+        }
+    } catch( ... ) {
+        // the tasks still queued refer to this frame
+        std::unique_lock<std::mutex> lock( mutex );
+        bFailed = true;
+        done.wait( lock, [&]() { return nRunning == 0; } );
+        throw;
+    }
+}
+#endif // PODOFO_MULTI_THREAD
+
+bool PdfWriter::UseObjectStreams() const
+{
+    // strings of encrypted objects in an object stream are only encrypted
+    // along with the stream, and an update keeps the XRef kind of the document
+    return (m_eWriteMode & ePdfWriteMode_ObjectStreams) == ePdfWriteMode_ObjectStreams
+        && !m_pEncrypt && !m_bIncrementalUpdate;
+}
+
+void PdfWriter::CreateObjectStreams()
+{
+    std::vector<PdfObject*> vecMembers;
+
+    // collected first, as creating the object streams changes m_vecObjects
+    TCIVecObjects itObjects, itObjectsEnd = m_vecObjects->end();
+    for( itObjects = m_vecObjects->begin(); itObjects != itObjectsEnd; ++itObjects )
+    {
+        PdfObject* pObject = *itObjects;
+        if( pObject->Reference().GenerationNumber() != 0 )
+            continue;
+
+        // GetDataType() loads the object, but not its stream
+        pObject->GetDataType();
+        const PdfParserObject* pParserObject = dynamic_cast<const PdfParserObject*>(pObject);
+        if( pParserObject ? pParserObject->HasStreamToParse() : pObject->HasStream() )
+            continue;
+
+        vecMembers.push_back( pObject );
+    }
+
+    try {
+        for( size_t nFirst = 0; nFirst < vecMembers.size(); nFirst += m_nObjectStreamSize )
+        {
+            const size_t nCount  = PDF_MIN( vecMembers.size() - nFirst, static_cast<size_t>(m_nObjectStreamSize) );
+            // a reused free number would carry a generation greater than 0,
+            // which objects in an object stream cannot refer to
+            PdfObject*   pStream = new PdfObject( PdfReference( static_cast<unsigned int>(m_vecObjects->GetObjectCount()), 0 ), "ObjStm" );
+            m_vecObjects->push_back( pStream );
+            m_vecObjectStreams.push_back( pStream );
+
+            // the header lists each object number and its offset in the body
+            PdfRefCountedBuffer header;
+            PdfRefCountedBuffer body;
+            PdfOutputDevice     headerDevice( &header );
+            PdfOutputDevice     bodyDevice( &body );
+            for( size_t i = 0; i < nCount; i++ )
+            {
+                PdfObject* pObject = vecMembers[nFirst + i];
+
+                headerDevice.Print( "%u %" PDF_FORMAT_UINT64 " ", pObject->Reference().ObjectNumber(),
+                                    static_cast<pdf_uint64>(bodyDevice.GetLength()) );
+                pObject->Write( &bodyDevice, m_eWriteMode, NULL );
+                bodyDevice.Print( "\n" );
+
+                m_mapObjectStreamEntries[pObject->Reference()] =
+                    TObjectStreamEntry( pStream->Reference().ObjectNumber(), static_cast<pdf_uint32>(i) );
+            }
+
+            pStream->GetDictionary().AddKey( "N", static_cast<pdf_int64>(nCount) );
+            pStream->GetDictionary().AddKey( "First", static_cast<pdf_int64>(headerDevice.GetLength()) );
+
+            PdfStream* pData = pStream->GetStream();
+            pData->SetFlateParameters( m_flateParameters );
+            pData->BeginAppend();
+            pData->Append( header.GetBuffer(), headerDevice.GetLength() );
+            pData->Append( body.GetBuffer(), bodyDevice.GetLength() );
+            pData->EndAppend();
+        }
+    } catch( PdfError & e ) {
+        this->DeleteObjectStreams();
+        e.AddToCallstack( __FILE__, __LINE__ );
+        throw e;
+    }
+}
+
+void PdfWriter::DeleteObjectStreams()
+{
+    // their object numbers are not listed as free, as nothing refers to them
+    for( TCIVecObjects it = m_vecObjectStreams.begin(); it != m_vecObjectStreams.end(); ++it )
+        delete m_vecObjects->RemoveObject( (*it)->Reference(), false );
+
+    m_vecObjectStreams.clear();
+    m_mapObjectStreamEntries.clear();
+}
+
+size_t PdfWriter::GetDictEncodeCapacity( PdfDictEncodeReport* pReport ) const
+{
+    if( m_bLinearized || m_bXRefStream || this->UseObjectStreams() )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Capacity is only known for documents written with a XRef table." );
+    }
+
+    if( (m_eWriteMode & ePdfWriteMode_CompressStreams) == ePdfWriteMode_CompressStreams )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_NotImplemented, "Capacity is not known for documents whose streams get compressed." );
+    }
+
+    PdfDictEncodeCounter counter( pReport );
+    size_t               nBits = 0;
+
+    // same selection of objects as WritePdfObjects
+    TCIVecObjects itObjects, itObjectsEnd = m_vecObjects->end();
+    for( itObjects = m_vecObjects->begin(); itObjects != itObjectsEnd; ++itObjects )
+    {
+        if( m_bIncrementalUpdate && !(*itObjects)->IsDirty() )
+            continue;
+
+        const size_t nObjectBits = counter.Count( **itObjects );
+        if( pReport && nObjectBits )
+            pReport->objects.push_back( PdfDictEncodeReport::TObjectCapacity( (*itObjects)->Reference(), nObjectBits ) );
+        nBits += nObjectBits;
+    }
+
+    // Write() appends an encryption dictionary object
+    if( m_pEncrypt )
+    {
+        PdfObject encrypt;
+        m_pEncrypt->CreateEncryptionDictionary( encrypt.GetDictionary() );
+
+        // its reference is only known once it gets written
+        const size_t nObjectBits = counter.Count( encrypt );
+        if( pReport && nObjectBits )
+            pReport->objects.push_back( PdfDictEncodeReport::TObjectCapacity( encrypt.Reference(), nObjectBits ) );
+        nBits += nObjectBits;
+    }
+
+    // the trailer has the same keys as the one Write() creates,
+    // only the values differ, which does not change its capacity
+    PdfObject trailer;
+    FillTrailerObject( &trailer, m_vecObjects->GetSize(), false );
+    if( m_pEncrypt )
+        trailer.GetDictionary().AddKey( PdfName("Encrypt"), PdfReference() );
+
+    const size_t nTrailerBits = counter.Count( trailer );
+    if( pReport )
+        pReport->trailerBits = nTrailerBits;
+
+    return nBits + nTrailerBits;
+}
+
+size_t PdfWriter::GetObjectDictEncodeCapacity( const PdfVariant & rVariant )
+{
+    PdfDictEncodeCounter counter;
+    return counter.Count( rVariant );
+}
+
 /*
 PdfObject* PdfWriter::CreateLinearizationDictionary()
 {
@@ -35,6 +35,7 @@
 #define _PDF_WRITER_H_
 
 #include "PdfDefines.h"
+#include "PdfFilter.h"
 #include "PdfInputDevice.h"
 #include "PdfOutputDevice.h"
 #include "PdfVecObjects.h"
@@ -49,11 +50,49 @@ class PdfObject;
 class PdfPage;
 class PdfPagesTree;
 class PdfParser;
+class PdfVariant;
 class PdfVecObjects;
+class PdfWriteThreads;
 class PdfXRef;
 
 namespace NonPublic { class PdfHintStream; }
 
+/** Details of the capacity of the dictionary order encoding,
+ *  gathered by PdfWriter::GetDictEncodeCapacity while summing it.
+ */
+struct PODOFO_API PdfDictEncodeReport {
+    struct TObjectCapacity {
+        TObjectCapacity( const PdfReference & rRef, size_t nBits )
+            : reference( rRef ), bits( nBits )
+            {
+            }
+
+        PdfReference reference;
+        size_t       bits;
+    };
+
+    PdfDictEncodeReport()
+        : trailerBits( 0 ), floorLossBits( 0.0 )
+        {
+        }
+
+    /** The objects holding payload bits, in the order they get written */
+    std::vector<TObjectCapacity> objects;
+
+    /** keyCounts[n] is the number of dictionaries with n keys,
+     *  not counting /Type which never carries data
+     */
+    std::vector<size_t>          keyCounts;
+
+    /** The payload bits the trailer holds */
+    size_t                       trailerBits;
+
+    /** A dictionary with n keys has n! orders but only holds
+     *  floor(log2(n!)) bits: the sum of what is rounded away
+     */
+    double                       floorLossBits;
+};
+
 /** The PdfWriter class writes a list of PdfObjects as PDF file.
  *  The XRef section (which is the required table of contents for any
  *  PDF file) is created automatically.
@@ -166,6 +205,85 @@ class PODOFO_API PdfWriter {
      */
     inline bool GetUseXRefStream() const;
 
+    /** Serialize objects on several threads when writing.
+     *
+     *  The threads are started once for each Write() and serialize
+     *  objects into memory ahead of the one being written, along with
+     *  the compression of their stream with ePdfWriteMode_CompressStreams.
+     *  Each object is written as soon as the ones before it are, so that
+     *  the output is exactly the one of a single thread. At most 16
+     *  objects per thread are held in memory this way.
+     *  Streams which were never loaded are copied from the input
+     *  by the calling thread, as when writing serially.
+     *  If the output device hides a payload, each object is
+     *  first assigned the slice of payload bits it would get when
+     *  written serially.
+     *
+     *  Encrypted documents are always written by a single thread,
+     *  as is everything without PODOFO_MULTI_THREAD.
+     *  Default is 0.
+     *
+     *  \param nThreads the number of threads, 0 or 1 to write serially
+     */
+    inline void SetWriteThreads( unsigned int nThreads );
+
+    /**
+     *  \returns the number of threads serializing objects
+     */
+    inline unsigned int GetWriteThreads() const;
+
+    /** Set how many bytes of streams the objects serialized on
+     *  several threads ahead of the one being written may hold.
+     *  No object is serialized ahead once this size is reached,
+     *  so a single large stream is still written.
+     *  Default is 64 MB.
+     *
+     *  \param lBytes the size of the streams serialized ahead
+     *
+     *  \see SetWriteThreads
+     */
+    inline void SetWriteMemoryBudget( size_t lBytes );
+
+    /**
+     *  \returns the size of the streams of the objects serialized
+     *           on several threads ahead of the one being written
+     */
+    inline size_t GetWriteMemoryBudget() const;
+
+    /** Set how the Flate filter encodes the streams compressed
+     *  while writing: those of ePdfWriteMode_CompressStreams, the
+     *  object streams and the XRef stream. A stream given its own
+     *  parameters with PdfStream::SetFlateParameters() uses those.
+     *  Default is PdfFlateParameters().
+     *
+     *  \param rParameters the Flate parameters of the document
+     */
+    inline void SetFlateParameters( const PdfFlateParameters & rParameters );
+
+    /**
+     *  \returns how the Flate filter encodes the streams
+     *            compressed while writing
+     */
+    inline const PdfFlateParameters & GetFlateParameters() const;
+
+    /** Set the maximum number of objects packed into a single
+     *  object stream when writing with ePdfWriteMode_ObjectStreams.
+     *
+     *  Objects with a stream, with a generation other than 0 or part
+     *  of an encrypted document or an incremental update are
+     *  always written as top level objects.
+     *  Default is 100.
+     *
+     *  \param nObjects the number of objects per object stream, at least 1
+     *                  and at most 65536
+     */
+    inline void SetObjectStreamSize( unsigned int nObjects );
+
+    /**
+     *  \returns the maximum number of objects per object stream
+     */
+    inline unsigned int GetObjectStreamSize() const;
+
     /** Sets an offset to the previous XRef table. Set it to lower than
      *  or equal to 0, to not write a reference to the previous XRef table.
      *  The default is 0.
@@ -232,6 +350,31 @@ class PODOFO_API PdfWriter {
      */
     void WriteToBuffer( char** ppBuffer, pdf_long* pulLen );
 
+    /** Compute how many payload bits the dictionary order encoding
+     *  can hide in this document, without serializing it.
+     *
+     *  This visits the same dictionaries Write() would hand to
+     *  PdfDictionary::Write, including the trailer, so the result is
+     *  exactly the bit_size a bit_istream accumulates when the document
+     *  is written to a device with a dictencode_stream.
+     *
+     *  Only the cross reference table layout is supported: XRef streams
+     *  and linearized files raise ePdfError_NotImplemented.
+     *
+     *  \param pReport if not NULL, the details of the capacity are
+     *                 added to this report
+     *  \returns the capacity in bits
+     */
+    size_t GetDictEncodeCapacity( PdfDictEncodeReport* pReport = NULL ) const;
+
+    /** Compute how many payload bits the dictionary order encoding
+     *  can hide in a single object, including all nested dictionaries.
+     *
+     *  \param rVariant the object to inspect
+     *  \returns the capacity in bits
+     */
+    static size_t GetObjectDictEncodeCapacity( const PdfVariant & rVariant );
+
     /** Add required keys to a trailer object
      *  \param pTrailer add keys to this object
      *  \param lSize number of objects in the PDF file
@@ -258,6 +401,31 @@ class PODOFO_API PdfWriter {
      */ 
     void WritePdfObjects( PdfOutputDevice* pDevice, const PdfVecObjects& vecObjects, PdfXRef* pXref, bool bRewriteXRefTable = false ) PODOFO_LOCAL;
 
+    /** Write objects, serialized on the threads of the current Write()
+     *  \param pDevice write to this output device
+     *  \param vecObjects the objects to write, in order
+     *  \param pXref add all written objects to this XRefTable
+     *
+     *  \see SetWriteThreads
+     */
+    void WriteObjectsParallel( PdfOutputDevice* pDevice, const std::vector<PdfObject*> & vecObjects, PdfXRef* pXref ) PODOFO_LOCAL;
+
+    /**
+     *  \returns true if objects are packed into object streams by Write()
+     */
+    bool UseObjectStreams() const PODOFO_LOCAL;
+
+    /** Pack all objects which can be compressed into new object
+     *  streams, which are added to m_vecObjects until Write() is done.
+     *
+     *  \see SetObjectStreamSize
+     */
+    void CreateObjectStreams() PODOFO_LOCAL;
+
+    /** Remove the object streams created by CreateObjectStreams()
+     */
+    void DeleteObjectStreams() PODOFO_LOCAL;
+
     /** Creates a file identifier which is required in several
      *  PDF workflows. 
      *  All values from the files document information dictionary are
@@ -337,6 +505,19 @@ class PODOFO_API PdfWriter {
     bool            m_bIncrementalUpdate;
 
     bool            m_bLinearized;
+
+    unsigned int     m_nWriteThreads;
+    size_t           m_lWriteMemoryBudget;
+    PdfWriteThreads* m_pWriteThreads;      ///< threads of the current Write(), if it writes in parallel
+
+    PdfFlateParameters m_flateParameters;
+
+    typedef std::pair<pdf_objnum,pdf_uint32>       TObjectStreamEntry; ///< object stream and index in it
+    typedef std::map<PdfReference,TObjectStreamEntry> TMapObjectStreamEntries;
+
+    unsigned int            m_nObjectStreamSize;
+    TVecObjects             m_vecObjectStreams;   ///< object streams created by Write()
+    TMapObjectStreamEntries m_mapObjectStreamEntries;
  
     /**
      * This value is required when writing
@@ -386,6 +567,70 @@ bool PdfWriter::GetUseXRefStream() const
     return m_bXRefStream;
 }
 
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetWriteThreads( unsigned int nThreads )
+{
+    m_nWriteThreads = nThreads;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfWriter::GetWriteThreads() const
+{
+    return m_nWriteThreads;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetWriteMemoryBudget( size_t lBytes )
+{
+    m_lWriteMemoryBudget = lBytes;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+size_t PdfWriter::GetWriteMemoryBudget() const
+{
+    return m_lWriteMemoryBudget;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetFlateParameters( const PdfFlateParameters & rParameters )
+{
+    m_flateParameters = rParameters;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+const PdfFlateParameters & PdfWriter::GetFlateParameters() const
+{
+    return m_flateParameters;
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+void PdfWriter::SetObjectStreamSize( unsigned int nObjects )
+{
+    m_nObjectStreamSize = PDF_MIN( PDF_MAX( nObjects, 1U ), 65536U );
+}
+
+// -----------------------------------------------------
+// 
+// -----------------------------------------------------
+unsigned int PdfWriter::GetObjectStreamSize() const
+{
+    return m_nObjectStreamSize;
+}
+
 // -----------------------------------------------------
 // 
 // -----------------------------------------------------
@@ -105,9 +105,19 @@ PdfXRef::~PdfXRef()
 
 void PdfXRef::AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUsed )
 {
-    TIVecXRefBlock     it = m_vecBlocks.begin();
-    PdfXRef::TXRefItem item( rRef, offset );
-    bool               bInsertDone = false;
+    this->AddItem( PdfXRef::TXRefItem( rRef, offset ), bUsed );
+}
+
+void PdfXRef::AddCompressedObject( const PdfReference & rRef, pdf_objnum nStream, pdf_uint32 nIndex )
+{
+    this->AddItem( PdfXRef::TXRefItem( rRef, nStream, nIndex ), true );
+}
+
+void PdfXRef::AddItem( const TXRefItem & item, bool bUsed )
+{
+    const PdfReference & rRef = item.reference;
+    TIVecXRefBlock       it   = m_vecBlocks.begin();
+    bool                 bInsertDone = false;
 
     while( it != m_vecBlocks.end() )
     {
@@ -187,8 +197,12 @@ void PdfXRef::Write( PdfOutputDevice* pDevice )
                 ++itFree;
             }
 
-            this->WriteXRefEntry( pDevice, (*itItems).offset, (*itItems).reference.GenerationNumber(), 'n', 
-                                  (*itItems).reference.ObjectNumber()  );
+            if( (*itItems).compressed )
+                this->WriteXRefEntry( pDevice, (*itItems).offset, static_cast<pdf_gennum>((*itItems).index), 'c',
+                                      (*itItems).reference.ObjectNumber() );
+            else
+                this->WriteXRefEntry( pDevice, (*itItems).offset, (*itItems).reference.GenerationNumber(), 'n', 
+                                      (*itItems).reference.ObjectNumber()  );
             ++itItems;
         }
 
@@ -343,6 +357,11 @@ void PdfXRef::WriteSubSection( PdfOutputDevice* pDevice, pdf_objnum nFirst, pdf_
 void PdfXRef::WriteXRefEntry( PdfOutputDevice* pDevice, pdf_uint64 offset, 
                               pdf_gennum generation, char cMode, pdf_objnum ) 
 {
+    if( cMode == 'c' )
+    {
+        PODOFO_RAISE_ERROR_INFO( ePdfError_InternalLogic, "Objects in object streams can only be listed in a XRef stream." );
+    }
+
     pDevice->Print( "%0.10" PDF_FORMAT_UINT64 " %0.5hu %c \n", offset, generation, cMode );
 }
 
@@ -53,12 +53,19 @@ class PdfXRef {
  protected:
     struct TXRefItem{
         TXRefItem( const PdfReference & rRef, const pdf_uint64 & off ) 
-            : reference( rRef ), offset( off )
+            : reference( rRef ), offset( off ), index( 0 ), compressed( false )
+            {
+            }
+
+        TXRefItem( const PdfReference & rRef, pdf_objnum nStream, pdf_uint32 nIndex )
+            : reference( rRef ), offset( nStream ), index( nIndex ), compressed( true )
             {
             }
 
         PdfReference reference;
-        pdf_uint64   offset;
+        pdf_uint64   offset;     ///< the object number of the object stream if compressed
+        pdf_uint32   index;      ///< the index in the object stream if compressed
+        bool         compressed;
 
         bool operator<( const TXRefItem & rhs ) const
         {
@@ -136,6 +143,15 @@ class PdfXRef {
      */
     void AddObject( const PdfReference & rRef, pdf_uint64 offset, bool bUsed );
 
+    /** Add an object stored in an object stream to the XRef table.
+     *  Only a XRef stream can reference such objects.
+     *
+     *  \param rRef reference of this object
+     *  \param nStream the object number of the object stream
+     *  \param nIndex the index of the object in the object stream
+     */
+    void AddCompressedObject( const PdfReference & rRef, pdf_objnum nStream, pdf_uint32 nIndex );
+
     /** Write the XRef table to an output device.
      * 
      *  \param pDevice an output device (usually a PDF file)
@@ -185,9 +201,12 @@ class PdfXRef {
      *  
      *  @param pDevice the output device to which the XRef table 
      *                 should be written.
-     *  @param offset the offset of the object
-     *  @param generation the generation number
-     *  @param cMode the mode 'n' for object and 'f' for free objects
+     *  @param offset the offset of the object, or the object number
+     *                of its object stream if cMode = 'c'
+     *  @param generation the generation number, or the index
+     *                    of the object in its object stream if cMode = 'c'
+     *  @param cMode the mode 'n' for object, 'f' for free objects
+     *               and 'c' for objects compressed in an object stream
      *  @param objectNumber the object number of the currently written object if cMode = 'n' 
      *                       otherwise undefined
      */
@@ -203,6 +222,11 @@ class PdfXRef {
     virtual void EndWrite( PdfOutputDevice* pDevice );
 
  private:
+    /** Add an item to the block it follows or precedes,
+     *  or to a new block.
+     */
+    void AddItem( const TXRefItem & item, bool bUsed );
+
     const PdfReference* GetFirstFreeObject( PdfXRef::TCIVecXRefBlock itBlock, PdfXRef::TCIVecReferences itFree ) const;
     const PdfReference* GetNextFreeObject( PdfXRef::TCIVecXRefBlock itBlock, PdfXRef::TCIVecReferences itFree ) const;
 
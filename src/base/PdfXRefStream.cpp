@@ -51,9 +51,23 @@ namespace PoDoFo {
 PdfXRefStream::PdfXRefStream( PdfVecObjects* pParent, PdfWriter* pWriter )
     : m_pParent( pParent ), m_pWriter( pWriter ), m_pObject( NULL )
 {
-    m_bufferLen = 2 + sizeof( pdf_uint32 );
-
-    m_pObject    = pParent->CreateObject( "XRef" );
+    // the last field holds the index of objects in object streams,
+    // which may not fit in a byte
+    const bool bObjectStreams = (pWriter->GetWriteMode() & ePdfWriteMode_ObjectStreams) == ePdfWriteMode_ObjectStreams;
+    m_lastLen   = bObjectStreams && pWriter->GetObjectStreamSize() > 256 ? 2 : 1;
+    m_bufferLen = 1 + sizeof( pdf_uint32 ) + m_lastLen;
+
+    if( bObjectStreams )
+    {
+        // like the object streams, take a new number, so that the free list
+        // written to the stream stays intact and the stream comes after them
+        m_pObject = new PdfObject( PdfReference( static_cast<unsigned int>(pParent->GetObjectCount()), 0 ), "XRef" );
+        pParent->push_back( m_pObject );
+    }
+    else
+        m_pObject = pParent->CreateObject( "XRef" );
+
+    m_pObject->GetStream()->SetFlateParameters( pWriter->GetFlateParameters() );
     m_offset    = 0;
 }
 
@@ -87,8 +101,13 @@ void PdfXRefStream::WriteXRefEntry( PdfOutputDevice*, pdf_uint64 offset, pdf_gen
     if( cMode == 'n' && objectNumber == m_pObject->Reference().ObjectNumber() )
         m_offset = offset;
     
-    buffer[0]             = static_cast<char>( cMode == 'n' ? 1 : 0 );
-    buffer[m_bufferLen-1] = static_cast<char>( cMode == 'n' ? 0 : generation );
+    // an object stream index is stored as the generation
+    const pdf_gennum last = cMode == 'n' ? 0 : generation;
+
+    buffer[0]             = static_cast<char>( cMode == 'n' ? 1 : (cMode == 'c' ? 2 : 0) );
+    buffer[m_bufferLen-1] = static_cast<char>( last & 0xff );
+    if( m_lastLen > 1 )
+        buffer[m_bufferLen-2] = static_cast<char>( (last >> 8) & 0xff );
 
     const pdf_uint32 offset_be = ::PoDoFo::compat::podofo_htonl(static_cast<pdf_uint32>(offset));
     memcpy( &buffer[1], reinterpret_cast<const char*>(&offset_be), sizeof(pdf_uint32) );
@@ -102,7 +121,7 @@ void PdfXRefStream::EndWrite( PdfOutputDevice* pDevice )
 
     w.push_back( static_cast<pdf_int64>(1) );
     w.push_back( static_cast<pdf_int64>(sizeof(pdf_uint32)) );
-    w.push_back( static_cast<pdf_int64>(1) );
+    w.push_back( static_cast<pdf_int64>(m_lastLen) );
 
     // Add our self to the XRef table
     this->WriteXRefEntry( pDevice, pDevice->Tell(), 0, 'n' );
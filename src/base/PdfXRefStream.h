@@ -97,9 +97,12 @@ class PdfXRefStream : public PdfXRef {
      *  
      *  @param pDevice the output device to which the XRef table 
      *                 should be written.
-     *  @param offset the offset of the object
-     *  @param generation the generation number
-     *  @param cMode the mode 'n' for object and 'f' for free objects
+     *  @param offset the offset of the object, or the object number
+     *                of its object stream if cMode = 'c'
+     *  @param generation the generation number, or the index
+     *                    of the object in its object stream if cMode = 'c'
+     *  @param cMode the mode 'n' for object, 'f' for free objects
+     *               and 'c' for objects compressed in an object stream
      *  @param objectNumber the object number of the currently written object if cMode = 'n' 
      *                       otherwise undefined
      */
@@ -121,6 +124,7 @@ class PdfXRefStream : public PdfXRef {
     PdfArray       m_indeces;
 
     size_t         m_bufferLen; ///< The length of the internal buffer for one XRef entry
+    size_t         m_lastLen;   ///< The length of the last field of an entry
     pdf_uint64     m_offset;    ///< Offset of the XRefStream object
 };
 
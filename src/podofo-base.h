@@ -40,6 +40,8 @@
 #include "base/PdfDefines.h"
 #include "base/Pdf3rdPtyForwardDecl.h"
 #include "base/PdfArray.h"
+#include "base/PdfBufferInputDevice.h"
+#include "base/PdfMappedInputDevice.h"
 #include "base/PdfCanvas.h"
 #include "base/PdfColor.h"
 #include "base/PdfContentsTokenizer.h"
@@ -54,6 +56,7 @@
 #include "base/PdfExtension.h"
 #include "base/PdfFileStream.h"
 #include "base/PdfFilter.h"
+#include "base/PdfIdCodec.h"
 #include "base/PdfImmediateWriter.h"
 #include "base/PdfInputDevice.h"
 #include "base/PdfInputStream.h"
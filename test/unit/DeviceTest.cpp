@@ -19,10 +19,14 @@
  ***************************************************************************/
 
 #include "DeviceTest.h"
+#include "TestUtils.h"
 #include <podofo.h>
 
 #include <stdio.h>
 #include <string.h>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #define BUFFER_SIZE 4096
 
 using namespace PoDoFo;
@@ -120,3 +124,206 @@ void DeviceTest::testDevices()
     
 }
 
+void DeviceTest::testMappedDevice()
+{
+    const char* pszTestString = "%PDF-1.4\n1 0 obj\n<< /Key /Value >>\nendobj\n%%EOF\n";
+    long        lLen          = strlen( pszTestString );
+    std::string sFilename     = TestUtils::getTempFilename();
+
+    FILE* hFile = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile );
+    fwrite( pszTestString, 1, lLen, hFile );
+    fclose( hFile );
+
+    try {
+        PdfInputDevice       file( sFilename.c_str() );
+        PdfMappedInputDevice mapped( sFilename.c_str() );
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(lLen), mapped.GetLength() );
+
+        // walk the file, looking ahead at each character
+        for( long i = 0; i < lLen; i++ )
+        {
+            CPPUNIT_ASSERT_EQUAL( file.Tell(), mapped.Tell() );
+            CPPUNIT_ASSERT_EQUAL( file.Look(), mapped.Look() );
+            CPPUNIT_ASSERT_EQUAL( file.GetChar(), mapped.GetChar() );
+        }
+        CPPUNIT_ASSERT_EQUAL( EOF, mapped.GetChar() );
+        CPPUNIT_ASSERT( mapped.Eof() );
+
+        // seek relative to both ends, and read across the end
+        char szFile[BUFFER_SIZE];
+        char szMapped[BUFFER_SIZE];
+
+        file.Seek( -6, std::ios_base::end );
+        mapped.Seek( -6, std::ios_base::end );
+        CPPUNIT_ASSERT( !mapped.Eof() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(6), mapped.Read( szMapped, BUFFER_SIZE ) );
+        file.Read( szFile, 6 );
+        CPPUNIT_ASSERT( memcmp( szFile, szMapped, 6 ) == 0 );
+        CPPUNIT_ASSERT( mapped.Eof() );
+
+        file.Seek( 9 );
+        mapped.Seek( 9 );
+        CPPUNIT_ASSERT_EQUAL( file.Read( szFile, 8 ), mapped.Read( szMapped, 8 ) );
+        CPPUNIT_ASSERT( memcmp( szFile, szMapped, 8 ) == 0 );
+
+        mapped.Seek( -2, std::ios_base::cur );
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>('j'), mapped.GetChar() );
+    } catch( PdfError & ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw;
+    }
+
+    // an empty file reads as an empty buffer
+    hFile = fopen( sFilename.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile );
+    fclose( hFile );
+
+    try {
+        PdfMappedInputDevice empty( sFilename.c_str() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), empty.GetLength() );
+        CPPUNIT_ASSERT_EQUAL( EOF, empty.Look() );
+        CPPUNIT_ASSERT( empty.Eof() );
+    } catch( PdfError & ) {
+        TestUtils::deleteFile( sFilename.c_str() );
+        throw;
+    }
+
+    TestUtils::deleteFile( sFilename.c_str() );
+
+    CPPUNIT_ASSERT_THROW( PdfMappedInputDevice( sFilename.c_str() ), PdfError );
+}
+
+void DeviceTest::testCopyTo()
+{
+    // larger than the chunks copies go through
+    std::string sData;
+    for( int i = 0; i < 200000; i++ )
+        sData.push_back( static_cast<char>('a' + (i * 7) % 26) );
+
+    std::string sInput  = TestUtils::getTempFilename();
+    std::string sOutput = TestUtils::getTempFilename();
+
+    FILE* hFile = fopen( sInput.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile );
+    fwrite( sData.data(), 1, sData.size(), hFile );
+    fclose( hFile );
+
+    const std::streamoff lOffset  = 7;
+    const pdf_long       lLen     = 150000;
+    const std::string    sExpected = "head" + sData.substr( lOffset, lLen ) + "tail";
+
+    try {
+        std::istringstream   stream( sData );
+        PdfInputDevice       file( sInput.c_str() );
+        PdfInputDevice       streamed( &stream );
+        PdfBufferInputDevice buffer( sData.data(), sData.size() );
+        PdfInputDevice*      devices[] = { &file, &streamed, &buffer };
+
+        for( PdfInputDevice* pInput : devices )
+        {
+            // to a file, which the kernel can write to directly
+            {
+                PdfOutputDevice output( sOutput.c_str() );
+                output.Print( "head" );
+                pInput->CopyTo( &output, lOffset, lLen );
+                output.Print( "tail" );
+                CPPUNIT_ASSERT_EQUAL( sExpected.size(), output.GetLength() );
+                CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(lOffset + lLen), pInput->Tell() );
+            }
+
+            std::ifstream written( sOutput.c_str(), std::ios::binary );
+            std::string   sWritten( (std::istreambuf_iterator<char>( written )), std::istreambuf_iterator<char>() );
+            CPPUNIT_ASSERT( sWritten == sExpected );
+
+            // to memory
+            PdfRefCountedBuffer memory;
+            PdfOutputDevice     output( &memory );
+            output.Print( "head" );
+            pInput->CopyTo( &output, lOffset, lLen );
+            output.Print( "tail" );
+            CPPUNIT_ASSERT( std::string( memory.GetBuffer(), output.GetLength() ) == sExpected );
+        }
+
+        // ranges past the end are refused
+        PdfOutputDevice output;
+        CPPUNIT_ASSERT_THROW( buffer.CopyTo( &output, sData.size() - 10, 11 ), PdfError );
+        CPPUNIT_ASSERT_THROW( file.CopyTo( &output, sData.size() - 10, 11 ), PdfError );
+    } catch( PdfError & ) {
+        TestUtils::deleteFile( sInput.c_str() );
+        TestUtils::deleteFile( sOutput.c_str() );
+        throw;
+    }
+
+    TestUtils::deleteFile( sInput.c_str() );
+    TestUtils::deleteFile( sOutput.c_str() );
+}
+
+void DeviceTest::testReadBuffer()
+{
+    // larger than the read buffer of files and streams
+    std::string sData;
+    for( int i = 0; i < 200000; i++ )
+        sData.push_back( static_cast<char>((i * 131) % 251) );
+
+    std::string sInput = TestUtils::getTempFilename();
+    FILE*       hFile  = fopen( sInput.c_str(), "wb" );
+    CPPUNIT_ASSERT( hFile );
+    fwrite( sData.data(), 1, sData.size(), hFile );
+    fclose( hFile );
+
+    try {
+        std::istringstream   stream( sData );
+        PdfInputDevice       file( sInput.c_str() );
+        PdfInputDevice       streamed( &stream );
+        PdfBufferInputDevice buffer( sData.data(), sData.size() );
+        PdfInputDevice*      devices[] = { &file, &streamed, &buffer };
+
+        for( PdfInputDevice* pInput : devices )
+        {
+            // sequentially, through several refills
+            for( size_t i = 0; i < sData.size(); i++ )
+            {
+                CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(i), pInput->Tell() );
+                CPPUNIT_ASSERT_EQUAL( static_cast<int>(static_cast<unsigned char>(sData[i])), pInput->Look() );
+                CPPUNIT_ASSERT_EQUAL( static_cast<int>(static_cast<unsigned char>(sData[i])), pInput->GetChar() );
+            }
+            CPPUNIT_ASSERT( !pInput->Eof() );
+            CPPUNIT_ASSERT_EQUAL( EOF, pInput->Look() );
+            CPPUNIT_ASSERT( pInput->Eof() );
+
+            // seeks inside and outside of what was read last, mixed with reads
+            const std::streamoff offsets[] = { 70000, 69990, 70100, 5, 199990, 131072, 131071 };
+            for( std::streamoff lOffset : offsets )
+            {
+                pInput->Seek( lOffset );
+                CPPUNIT_ASSERT_EQUAL( lOffset, pInput->Tell() );
+                CPPUNIT_ASSERT_EQUAL( static_cast<int>(static_cast<unsigned char>(sData[lOffset])), pInput->GetChar() );
+
+                char szRead[BUFFER_SIZE];
+                const std::streamoff lRead = pInput->Read( szRead, BUFFER_SIZE );
+                const std::streamoff lLeft = static_cast<std::streamoff>(sData.size()) - lOffset - 1;
+                CPPUNIT_ASSERT_EQUAL( PDF_MIN( lLeft, static_cast<std::streamoff>(BUFFER_SIZE) ), lRead );
+                CPPUNIT_ASSERT( memcmp( szRead, sData.data() + lOffset + 1, static_cast<size_t>(lRead) ) == 0 );
+                CPPUNIT_ASSERT_EQUAL( lOffset + 1 + lRead, pInput->Tell() );
+                CPPUNIT_ASSERT_EQUAL( lRead < BUFFER_SIZE, pInput->Eof() );
+
+                pInput->Seek( -3, std::ios_base::cur );
+                CPPUNIT_ASSERT_EQUAL( lOffset + lRead - 2, pInput->Tell() );
+                CPPUNIT_ASSERT_EQUAL( static_cast<int>(static_cast<unsigned char>(sData[lOffset + lRead - 2])), pInput->Look() );
+            }
+
+            pInput->Seek( -1, std::ios_base::end );
+            CPPUNIT_ASSERT_EQUAL( static_cast<std::streamoff>(sData.size() - 1), pInput->Tell() );
+            CPPUNIT_ASSERT_EQUAL( static_cast<int>(static_cast<unsigned char>(sData[sData.size() - 1])), pInput->GetChar() );
+            CPPUNIT_ASSERT_EQUAL( EOF, pInput->GetChar() );
+            CPPUNIT_ASSERT( pInput->Eof() );
+        }
+    } catch( PdfError & ) {
+        TestUtils::deleteFile( sInput.c_str() );
+        throw;
+    }
+
+    TestUtils::deleteFile( sInput.c_str() );
+}
@@ -27,12 +27,30 @@ class DeviceTest : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE( DeviceTest );
     CPPUNIT_TEST( testDevices );
+    CPPUNIT_TEST( testMappedDevice );
+    CPPUNIT_TEST( testCopyTo );
+    CPPUNIT_TEST( testReadBuffer );
     CPPUNIT_TEST_SUITE_END();
 public:
     void setUp();
     void tearDown();
 
     void testDevices();
+
+    /** PdfMappedInputDevice must read a file as PdfInputDevice does
+     */
+    void testMappedDevice();
+
+    /** Input devices must copy ranges to output devices, whether
+     *  the kernel copies them or not
+     */
+    void testCopyTo();
+
+    /** Files, streams and buffers must agree on their position and
+     *  contents while reading through the read buffer, across refills
+     *  and seeks
+     */
+    void testReadBuffer();
 };
 
 #endif // _DEVICE_TEST_H_
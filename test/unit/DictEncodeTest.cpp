@@ -0,0 +1,831 @@
+#include "DictEncodeTest.h"
+
+#include <podofo.h>
+
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include <random>
+#include <sstream>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( DictEncodeTest );
+
+/** Fill vecObjects with dictionaries of various shapes and
+ *  return a trailer pointing to them.
+ */
+static void CreateTestObjects( PdfVecObjects & vecObjects, PdfObject & trailer )
+{
+    PdfObject* pCatalog = vecObjects.CreateObject( "Catalog" );
+    PdfObject* pInfo    = vecObjects.CreateObject();
+
+    pInfo->GetDictionary().AddKey( "Producer", PdfString( "DictEncodeTest" ) );
+    pInfo->GetDictionary().AddKey( "Title", PdfString( "capacity" ) );
+
+    // an empty dictionary, and a dictionary only holding a type
+    vecObjects.CreateObject();
+    vecObjects.CreateObject( "Empty" );
+
+    for( int i = 0; i < 40; i++ )
+    {
+        PdfObject* pObject = vecObjects.CreateObject( i % 2 ? "Thing" : NULL );
+
+        PdfArray array;
+        for( int j = 0; j <= i; j++ )
+        {
+            char szKey[16];
+            snprintf( szKey, sizeof(szKey), "K%d", (j * 7919) % 1000 );
+            pObject->GetDictionary().AddKey( szKey, static_cast<pdf_int64>(j) );
+
+            if( j % 5 == 0 )
+            {
+                PdfDictionary nested;
+                nested.AddKey( PdfName::KeyType, PdfName( "Nested" ) );
+                for( int k = 0; k < j; k++ )
+                    nested.AddKey( PdfName( std::string( 1, static_cast<char>('A' + k % 26) ) + static_cast<char>('a' + k / 26) ), static_cast<pdf_int64>(k) );
+                array.push_back( nested );
+            }
+        }
+        pObject->GetDictionary().AddKey( "Array", array );
+        pCatalog->GetDictionary().AddKey( PdfName( std::string( "Ref" ) + static_cast<char>('A' + i % 26) + static_cast<char>('a' + i / 26) ), pObject->Reference() );
+    }
+
+    PdfObject* pStream = vecObjects.CreateObject();
+    pStream->GetDictionary().AddKey( "Subtype", PdfName( "Data" ) );
+    pStream->GetStream()->Set( "0123456789" );
+
+    trailer.GetDictionary().AddKey( "Root", pCatalog->Reference() );
+    trailer.GetDictionary().AddKey( "Info", pInfo->Reference() );
+}
+
+/** Count the payload bits an actual write of the document consumes
+ */
+static size_t WriteCapacity( PdfWriter & writer )
+{
+    bit_istream     i_bitstream( NULL );
+    PdfOutputDevice device;
+
+    device.dictencode_stream = &i_bitstream;
+    writer.Write( &device );
+
+    return i_bitstream.bit_size;
+}
+
+void DictEncodeTest::setUp()
+{
+}
+
+void DictEncodeTest::tearDown()
+{
+}
+
+void DictEncodeTest::testCapacityMatchesWrite()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    size_t nCapacity = writer.GetDictEncodeCapacity();
+    CPPUNIT_ASSERT( nCapacity > 0 );
+    CPPUNIT_ASSERT_EQUAL( WriteCapacity( writer ), nCapacity );
+
+    // write the document and check the parsed version as well
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    writer.Write( &device );
+
+    PdfVecObjects parsedObjects;
+    PdfParser     parser( &parsedObjects );
+
+    parsedObjects.SetAutoDelete( true );
+    parser.ParseFile( buffer.GetBuffer(), static_cast<long>(device.GetLength()), false );
+
+    PdfWriter parsedWriter( &parser );
+    parsedWriter.SetWriteMode( ePdfWriteMode_Compact );
+
+    CPPUNIT_ASSERT_EQUAL( nCapacity, parsedWriter.GetDictEncodeCapacity() );
+    CPPUNIT_ASSERT_EQUAL( WriteCapacity( parsedWriter ), parsedWriter.GetDictEncodeCapacity() );
+}
+
+void DictEncodeTest::testObjectCapacity()
+{
+    PdfDictionary dict;
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), PdfWriter::GetObjectDictEncodeCapacity( dict ) );
+
+    // the type key is not part of the permutation
+    dict.AddKey( PdfName::KeyType, PdfName( "Test" ) );
+    dict.AddKey( "A", static_cast<pdf_int64>(1) );
+    dict.AddKey( "B", static_cast<pdf_int64>(2) );
+    dict.AddKey( "C", static_cast<pdf_int64>(3) );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), PdfWriter::GetObjectDictEncodeCapacity( dict ) );
+
+    // nested dictionaries add up
+    PdfArray array;
+    array.push_back( dict );
+    array.push_back( PdfVariant( static_cast<pdf_int64>(4) ) );
+    dict.AddKey( "D", array );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(4 + 2), PdfWriter::GetObjectDictEncodeCapacity( dict ) );
+}
+
+/** A sorted vector of n distinct keys
+ */
+static std::vector<std::string> SortedKeys( size_t n )
+{
+    std::vector<std::string> keys;
+    for( size_t i = 0; i < n; i++ )
+    {
+        char szKey[16];
+        snprintf( szKey, sizeof(szKey), "Key%06u", static_cast<unsigned int>(i) );
+        keys.push_back( szKey );
+    }
+    return keys;
+}
+
+/** A random rank below n!
+ */
+static mpz_class RandomRank( gmp_randclass & rand, size_t n )
+{
+    return rand.get_z_range( mpz_class_fac( n ) );
+}
+
+void DictEncodeTest::testAvailableBits()
+{
+    for( size_t n = 0; n < 64; n++ )
+        CPPUNIT_ASSERT_EQUAL( perm_available_bits( mpz_class_fac( n ) ), size_available_bits( n ) );
+}
+
+void DictEncodeTest::testRankMatchesGmp()
+{
+    gmp_randclass rand( gmp_randinit_default );
+    std::mt19937  shuffle_rand( 42 );
+    rand.seed( 42 );
+
+    for( size_t n = 0; n <= 40; n++ )
+    {
+        const std::vector<std::string> id = SortedKeys( n );
+        for( int i = 0; i < 50; i++ )
+        {
+            std::vector<std::string> v = id;
+            std::shuffle( v.begin(), v.end(), shuffle_rand );
+            CPPUNIT_ASSERT_EQUAL( rank1_mpz( id, v ), rank1( id, v ) );
+        }
+
+        // round trip through unrank
+        for( int i = 0; i < 50; i++ )
+        {
+            mpz_class r = RandomRank( rand, n );
+            std::vector<std::string> v = id;
+            unrank1( v, r );
+            CPPUNIT_ASSERT_EQUAL( r, rank1( id, v ) );
+        }
+    }
+}
+
+void DictEncodeTest::testUnrankMatchesGmp()
+{
+    gmp_randclass rand( gmp_randinit_default );
+    rand.seed( 42 );
+
+    for( size_t n = 0; n <= 40; n++ )
+    {
+        const std::vector<std::string> id = SortedKeys( n );
+        for( int i = 0; i < 50; i++ )
+        {
+            mpz_class r = RandomRank( rand, n );
+
+            std::vector<std::string> expected = id;
+            unrank1_mpz( expected, r );
+
+            std::vector<std::string> v = id;
+            unrank1( v, r );
+            CPPUNIT_ASSERT( expected == v );
+
+            if( r.fits_ulong_p() && n <= perm_word<uint64_t>::max_size )
+            {
+                v = id;
+                unrank1( v, static_cast<uint64_t>(r.get_ui()) );
+                CPPUNIT_ASSERT( expected == v );
+            }
+        }
+    }
+}
+
+void DictEncodeTest::testLargeRank()
+{
+    gmp_randclass rand( gmp_randinit_default );
+    rand.seed( 42 );
+
+    const size_t sizes[] = { 35, 36, 63, 64, 65, 100, 257, 1000, 4099 };
+    for( size_t n : sizes )
+    {
+        const std::vector<std::string> id = SortedKeys( n );
+        for( int i = 0; i < 5; i++ )
+        {
+            mpz_class r = RandomRank( rand, n );
+
+            // digit by digit reference
+            std::vector<std::string> expected = id;
+            mpz_class remaining = r;
+            for( size_t m = n; m; m-- )
+            {
+                std::swap( expected[m - 1], expected[mpz_class( remaining % m ).get_ui()] );
+                remaining /= m;
+            }
+
+            std::vector<std::string> v = id;
+            unrank1( v, r );
+            CPPUNIT_ASSERT( expected == v );
+            CPPUNIT_ASSERT_EQUAL( r, rank1( id, v ) );
+        }
+
+        // ranks past n! wrap around
+        std::vector<std::string> v = id;
+        std::vector<std::string> wrapped = id;
+        mpz_class r = RandomRank( rand, n );
+        unrank1( v, r );
+        unrank1( wrapped, r + 3 * mpz_class_fac( n ) );
+        CPPUNIT_ASSERT( v == wrapped );
+    }
+}
+
+void DictEncodeTest::testStreamingDecode()
+{
+    std::ostringstream streamed;
+    std::ostringstream buffered;
+    bit_ostream        streamedBits( streamed );
+    bit_ostream        bufferedBits( buffered );
+
+    const long   offsets[] = { 30, 10, 20, 50, 40, 60 };
+    const size_t sizes[]   = { 5, 3, 8, 16, 1, 7 };
+    for( size_t i = 0; i < 6; i++ )
+    {
+        mpz_class number = static_cast<unsigned long>(offsets[i] * 1237 + 11);
+        streamedBits.push( offsets[i], mpz_class( number ), sizes[i] );
+        bufferedBits.push( offsets[i], mpz_class( number ), sizes[i] );
+    }
+
+    // nothing below 20 yet
+    streamedBits.advance( 15 );
+    CPPUNIT_ASSERT( streamed.str().empty() );
+
+    // 10, 20 and 30 make 16 bits
+    streamedBits.advance( 35 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), streamed.str().size() );
+
+    // going back does not change anything
+    streamedBits.advance( 25 );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(2), streamed.str().size() );
+
+    streamedBits.flush();
+    bufferedBits.flush();
+    CPPUNIT_ASSERT( streamed.str() == buffered.str() );
+    CPPUNIT_ASSERT( !streamedBits.out_of_order() );
+
+    // pushing below the watermark is an error
+    streamedBits.push( 5, mpz_class( 1 ), 1 );
+    CPPUNIT_ASSERT( streamedBits.out_of_order() );
+}
+
+/** Write the document with a random payload filling its capacity
+ */
+static std::string WritePayload( PdfWriter & writer, std::string & payload )
+{
+    std::mt19937 rand( 42 );
+    payload.clear();
+    for( size_t i = 0; i < writer.GetDictEncodeCapacity() / 8; i++ )
+        payload.push_back( static_cast<char>(rand()) );
+
+    std::istringstream  input( payload );
+    bit_istream         i_bitstream( &input );
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    device.dictencode_stream = &i_bitstream;
+    writer.Write( &device );
+
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+void DictEncodeTest::testBitStreams()
+{
+    // larger than a stream block, and not a whole number of words
+    std::mt19937 rand( 7 );
+    std::string  payload;
+    for( int i = 0; i < 200003; i++ )
+        payload.push_back( static_cast<char>(rand()) );
+
+    for( int source = 0; source < 2; source++ )
+    {
+        std::istringstream input( payload );
+        bit_istream        bits = source ? bit_istream( &input ) : bit_istream( payload.data(), payload.size() );
+        std::ostringstream output;
+        bit_ostream        outputBits( output );
+
+        // chunks of all sizes, read as words, bytes or numbers
+        size_t nTotal = 0;
+        for( long i = 0; !bits.eof(); i++ )
+        {
+            const size_t nSize = 1 + (i * 37) % 200;
+            mpz_class number;
+            if( i % 3 == 0 && nSize <= 64 )
+                number = mpz_from_word( bit_istream_pull_word( bits, nSize ) );
+            else if( i % 3 == 1 )
+            {
+                const std::string bytes = bit_istream_pull_bytes( bits, nSize );
+                CPPUNIT_ASSERT_EQUAL( (nSize + 7) / 8, bytes.size() );
+                mpz_import( number.get_mpz_t(), bytes.size(), -1, 1, 0, 0, bytes.data() );
+            }
+            else
+                number = bit_istream_pull_mpz( bits, nSize );
+
+            CPPUNIT_ASSERT( mpz_sizeinbase( number.get_mpz_t(), 2 ) <= nSize );
+            outputBits.push( i, std::move( number ), nSize );
+            nTotal += nSize;
+        }
+        outputBits.flush();
+
+        // bits past the end of the payload are cleared
+        const std::string decoded = output.str();
+        CPPUNIT_ASSERT_EQUAL( nTotal / 8, decoded.size() );
+        CPPUNIT_ASSERT( decoded.compare( 0, payload.size(), payload ) == 0 );
+        CPPUNIT_ASSERT( decoded.find_first_not_of( '\0', payload.size() ) == std::string::npos );
+        CPPUNIT_ASSERT_EQUAL( static_cast<uint64_t>(0), bit_istream_pull_word( bits, 64 ) );
+    }
+
+    // bits a number does not carry are dropped
+    std::ostringstream output;
+    bit_ostream        outputBits( output );
+    outputBits.push( 0, mpz_class( 0x5a5 ), 4 );
+    outputBits.push( 1, mpz_class( 0x3 ), 4 );
+    outputBits.push( 2, mpz_class( 1 ) << 100, 8 );
+    outputBits.flush();
+    CPPUNIT_ASSERT( output.str() == std::string( "\x35\x00", 2 ) );
+}
+
+void DictEncodeTest::testRoundTrip()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    std::string payload;
+    std::string document = WritePayload( writer, payload );
+
+    // decode it back, with the parser advancing the stream
+    std::ostringstream output;
+    bit_ostream        o_bitstream( output );
+    PdfVecObjects      parsedObjects;
+    PdfParser          parser( &parsedObjects );
+
+    PdfRefCountedInputDevice inputDevice( document.data(), document.size() );
+    inputDevice.Device()->dictdecode_stream = &o_bitstream;
+
+    parsedObjects.SetAutoDelete( true );
+    parser.ParseFile( inputDevice, false );
+    o_bitstream.flush();
+
+    CPPUNIT_ASSERT( !o_bitstream.out_of_order() );
+    CPPUNIT_ASSERT( output.str() == payload );
+}
+
+void DictEncodeTest::testParallelDecode()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    std::string payload;
+    std::string document = WritePayload( writer, payload );
+
+    const unsigned int threads[] = { 1, 2, 7 };
+    for( unsigned int nThreads : threads )
+    {
+        std::ostringstream output;
+        bit_ostream        o_bitstream( output );
+        PdfVecObjects      parsedObjects;
+        PdfParser          parser( &parsedObjects );
+
+        parser.DecodeDictOrder( document.data(), document.size(), o_bitstream, nThreads );
+        o_bitstream.flush();
+
+        // nothing gets loaded
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), parsedObjects.GetSize() );
+        CPPUNIT_ASSERT( !o_bitstream.out_of_order() );
+        CPPUNIT_ASSERT( output.str() == payload );
+    }
+}
+
+/** Write the document with the first nBytes of payload hidden in it
+ */
+static std::string WriteBytes( PdfWriter & writer, const std::string & payload, size_t nBytes, size_t & nBits )
+{
+    std::istringstream  input( payload.substr( 0, nBytes ) );
+    bit_istream         i_bitstream( &input );
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+
+    device.dictencode_stream = &i_bitstream;
+    writer.Write( &device );
+
+    nBits = i_bitstream.bit_size;
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+void DictEncodeTest::testParallelWrite()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    std::string payload;
+    WritePayload( writer, payload );
+
+    // an empty, a short and a full payload
+    const size_t bytes[] = { 0, payload.size() / 3, payload.size() };
+    for( size_t nBytes : bytes )
+    {
+        size_t nSerialBits;
+        writer.SetWriteThreads( 0 );
+        std::string serial = WriteBytes( writer, payload, nBytes, nSerialBits );
+
+        const unsigned int threads[] = { 2, 4, 7 };
+        for( unsigned int nThreads : threads )
+        {
+            size_t nParallelBits;
+            writer.SetWriteThreads( nThreads );
+            std::string parallel = WriteBytes( writer, payload, nBytes, nParallelBits );
+
+            CPPUNIT_ASSERT_EQUAL( nSerialBits, nParallelBits );
+            CPPUNIT_ASSERT( serial == parallel );
+        }
+    }
+
+    // without any payload stream
+    writer.SetWriteThreads( 0 );
+    PdfRefCountedBuffer serialBuffer;
+    PdfOutputDevice     serialDevice( &serialBuffer );
+    writer.Write( &serialDevice );
+
+    writer.SetWriteThreads( 4 );
+    PdfRefCountedBuffer parallelBuffer;
+    PdfOutputDevice     parallelDevice( &parallelBuffer );
+    writer.Write( &parallelDevice );
+
+    CPPUNIT_ASSERT( std::string( serialBuffer.GetBuffer(), serialDevice.GetLength() ) ==
+                    std::string( parallelBuffer.GetBuffer(), parallelDevice.GetLength() ) );
+
+    // many more objects than the threads hold at once, which
+    // serialize them one after the other for the whole write
+    for( int i = 0; i < 2000; i++ )
+    {
+        PdfObject* pObject = vecObjects.CreateObject( "Many" );
+        for( int j = 0; j < 1 + i % 6; j++ )
+            pObject->GetDictionary().AddKey( PdfName( std::string( 1, static_cast<char>('a' + j) ) ), static_cast<pdf_int64>(i) );
+    }
+
+    WritePayload( writer, payload );
+
+    size_t nSerialBits;
+    writer.SetWriteThreads( 0 );
+    std::string serial = WriteBytes( writer, payload, payload.size(), nSerialBits );
+
+    size_t nParallelBits;
+    writer.SetWriteThreads( 2 );
+    std::string parallel = WriteBytes( writer, payload, payload.size(), nParallelBits );
+
+    CPPUNIT_ASSERT_EQUAL( nSerialBits, nParallelBits );
+    CPPUNIT_ASSERT( serial == parallel );
+}
+
+void DictEncodeTest::testFramedPayload()
+{
+    const std::string payload = "framed payload";
+    const std::string frame   = payload_frame( payload );
+    CPPUNIT_ASSERT_EQUAL( payload_frame_header_size + payload.size(), frame.size() );
+
+    // push each byte as a dictionary of its own, followed by garbage
+    std::ostringstream output;
+    bit_ostream        o_bitstream( output, true );
+    for( size_t i = 0; i < frame.size() + 3; i++ )
+    {
+        unsigned char c = i < frame.size() ? static_cast<unsigned char>(frame[i]) : 0xa5;
+        o_bitstream.push( static_cast<long>(i), mpz_class( c ), 8 );
+
+        CPPUNIT_ASSERT_EQUAL( i >= frame.size(), o_bitstream.done() );
+        o_bitstream.advance( static_cast<long>(i + 1) );
+        CPPUNIT_ASSERT_EQUAL( i + 1 >= frame.size(), o_bitstream.done() );
+    }
+    o_bitstream.flush();
+    CPPUNIT_ASSERT_EQUAL( bit_ostream::frame_complete, o_bitstream.frame() );
+    CPPUNIT_ASSERT( output.str() == payload );
+
+    // a damaged payload, a truncated one, and no frame at all
+    std::string damaged = frame;
+    damaged[payload_frame_header_size + 3] ^= 0x10;
+
+    std::string unframed = payload + payload;
+
+    const std::string               inputs[] = { damaged, frame.substr( 0, frame.size() - 1 ), unframed };
+    const bit_ostream::frame_state  states[] = { bit_ostream::frame_bad_checksum,
+                                                 bit_ostream::frame_payload,
+                                                 bit_ostream::frame_bad_magic };
+    for( size_t i = 0; i < 3; i++ )
+    {
+        std::ostringstream broken;
+        bit_ostream        brokenBits( broken, true );
+        for( size_t j = 0; j < inputs[i].size(); j++ )
+            brokenBits.push( static_cast<long>(j), mpz_class( static_cast<unsigned char>(inputs[i][j]) ), 8 );
+        brokenBits.flush();
+
+        CPPUNIT_ASSERT_EQUAL( states[i], brokenBits.frame() );
+        CPPUNIT_ASSERT_EQUAL( states[i] != bit_ostream::frame_payload, brokenBits.done() );
+    }
+
+    // ParseFile reads the whole document even once the payload is
+    // complete, DecodeDictOrder needs not
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    size_t      nBits;
+    std::string document = WriteBytes( writer, payload_frame( "short" ), std::string::npos, nBits );
+
+    std::ostringstream decoded;
+    bit_ostream        decodedBits( decoded, true );
+    PdfVecObjects      parsedObjects;
+    PdfParser          parser( &parsedObjects );
+
+    PdfRefCountedInputDevice inputDevice( document.data(), document.size() );
+    inputDevice.Device()->dictdecode_stream = &decodedBits;
+
+    parsedObjects.SetAutoDelete( true );
+    parser.ParseFile( inputDevice, false );
+    decodedBits.flush();
+
+    CPPUNIT_ASSERT_EQUAL( bit_ostream::frame_complete, decodedBits.frame() );
+    CPPUNIT_ASSERT( decoded.str() == "short" );
+    CPPUNIT_ASSERT_EQUAL( vecObjects.GetSize(), parsedObjects.GetSize() );
+
+    const unsigned int threads[] = { 0, 3 };
+    for( unsigned int nThreads : threads )
+    {
+        std::ostringstream onlyDecoded;
+        bit_ostream        onlyDecodedBits( onlyDecoded, true );
+        PdfVecObjects      unusedObjects;
+        PdfParser          decoder( &unusedObjects );
+
+        decoder.DecodeDictOrder( document.data(), static_cast<pdf_long>(document.size()), onlyDecodedBits, nThreads );
+        onlyDecodedBits.flush();
+
+        CPPUNIT_ASSERT_EQUAL( bit_ostream::frame_complete, onlyDecodedBits.frame() );
+        CPPUNIT_ASSERT( onlyDecoded.str() == "short" );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), unusedObjects.GetSize() );
+    }
+}
+
+/** Write the test objects to a document held in memory
+ */
+static std::string WriteCarrier()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateTestObjects( vecObjects, trailer );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+
+    std::ostringstream output;
+    PdfOutputDevice    device( &output );
+    writer.Write( &device );
+    return output.str();
+}
+
+void DictEncodeTest::testCodec()
+{
+    const std::string carrier = WriteCarrier();
+    const std::string payload = "hidden in the key order";
+
+    PdfIdCodec codec;
+    for( int framed = 0; framed < 2; framed++ )
+    {
+        codec.SetFramed( framed != 0 );
+        codec.SetThreads( 0 );
+
+        size_t nCapacity = codec.GetCapacity( carrier.data(), carrier.size() );
+        CPPUNIT_ASSERT( nCapacity >= payload.size() );
+
+        std::ostringstream output;
+        CPPUNIT_ASSERT_EQUAL( nCapacity, codec.Encode( carrier.data(), carrier.size(),
+                                                       payload.data(), payload.size(), output ) );
+        const std::string document = output.str();
+
+        // the same codec decodes any number of documents, on any number of threads
+        const unsigned int threads[] = { 0, 3 };
+        for( unsigned int nThreads : threads )
+        {
+            codec.SetThreads( nThreads );
+            std::string decoded = codec.Decode( document.data(), document.size() );
+            if( framed )
+                CPPUNIT_ASSERT( decoded == payload );
+            else
+                CPPUNIT_ASSERT( decoded.compare( 0, payload.size(), payload ) == 0 );
+        }
+
+        // a payload filling the document fits
+        std::string full( nCapacity, 'x' );
+        std::ostringstream fullOutput;
+        CPPUNIT_ASSERT_EQUAL( nCapacity, codec.Encode( carrier.data(), carrier.size(),
+                                                       full.data(), full.size(), fullOutput ) );
+        const std::string fullDocument = fullOutput.str();
+        CPPUNIT_ASSERT( codec.Decode( fullDocument.data(), fullDocument.size() ).compare( 0, full.size(), full ) == 0 );
+
+        // a payload one byte too large is cut, unless it is framed: the
+        // frame would claim more bytes than the document holds
+        std::string large( nCapacity + 1, 'x' );
+        std::ostringstream largeOutput;
+        if( framed )
+            CPPUNIT_ASSERT_THROW( codec.Encode( carrier.data(), carrier.size(),
+                                                large.data(), large.size(), largeOutput ), PdfError );
+        else
+            CPPUNIT_ASSERT_EQUAL( nCapacity, codec.Encode( carrier.data(), carrier.size(),
+                                                           large.data(), large.size(), largeOutput ) );
+    }
+
+    // the carrier itself holds no frame
+    CPPUNIT_ASSERT_THROW( codec.Decode( carrier.data(), carrier.size() ), PdfError );
+
+    // the frame header has no room for a length of 4 GiB, which is
+    // checked before the payload is even read
+    if( sizeof(size_t) > sizeof(uint32_t) )
+    {
+        const size_t       lHuge = static_cast<size_t>(std::numeric_limits<uint32_t>::max()) + 1;
+        std::ostringstream hugeOutput;
+        CPPUNIT_ASSERT_THROW( codec.Encode( carrier.data(), carrier.size(), payload.data(), lHuge, hugeOutput ), PdfError );
+        CPPUNIT_ASSERT( hugeOutput.str().empty() );
+    }
+
+    // a document too small for the frame header cannot even hold an
+    // empty framed payload
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+
+    PdfObject* pCatalog = vecObjects.CreateObject( "Catalog" );
+    pCatalog->GetDictionary().AddKey( "Lang", PdfString( "en" ) );
+    trailer.GetDictionary().AddKey( "Root", pCatalog->Reference() );
+
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( ePdfWriteMode_Compact );
+    const size_t nSmallBits = writer.GetDictEncodeCapacity();
+    CPPUNIT_ASSERT( nSmallBits > 0 && nSmallBits / 8 < payload_frame_header_size );
+
+    std::ostringstream small;
+    PdfOutputDevice    smallDevice( &small );
+    writer.Write( &smallDevice );
+    smallDevice.Flush();
+    const std::string smallCarrier = small.str();
+
+    codec.SetThreads( 0 );
+    codec.SetFramed( false );
+    std::ostringstream unframedOutput;
+    CPPUNIT_ASSERT_EQUAL( nSmallBits / 8, codec.Encode( smallCarrier.data(), smallCarrier.size(),
+                                                        "", 0, unframedOutput ) );
+
+    codec.SetFramed( true );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(0), codec.GetCapacity( smallCarrier.data(), smallCarrier.size() ) );
+    std::ostringstream framedOutput;
+    CPPUNIT_ASSERT_THROW( codec.Encode( smallCarrier.data(), smallCarrier.size(), "", 0, framedOutput ), PdfError );
+}
+
+void DictEncodeTest::testIncrementalUpdate()
+{
+    const std::string carrier = WriteCarrier();
+    const std::string payload = "short";
+
+    PdfIdCodec codec;
+    const size_t nFullCapacity = codec.GetCapacity( carrier.data(), carrier.size() );
+
+    codec.SetIncremental( true );
+    for( int framed = 0; framed < 2; framed++ )
+    {
+        codec.SetFramed( framed != 0 );
+        codec.SetThreads( 0 );
+
+        // the object with a stream is never rewritten
+        size_t nCapacity = codec.GetCapacity( carrier.data(), carrier.size() );
+        CPPUNIT_ASSERT( nCapacity >= payload.size() );
+        CPPUNIT_ASSERT( nCapacity <= nFullCapacity );
+
+        // only the capacity of the dictionaries actually rewritten is used
+        std::ostringstream output;
+        size_t nUsed = codec.Encode( carrier.data(), carrier.size(), payload.data(), payload.size(), output );
+        CPPUNIT_ASSERT( nUsed >= payload.size() );
+        CPPUNIT_ASSERT( nUsed < nCapacity );
+        const std::string document = output.str();
+
+        // the original bytes are kept, and only the few
+        // dictionaries the payload needs are appended
+        CPPUNIT_ASSERT( document.compare( 0, carrier.size(), carrier ) == 0 );
+        CPPUNIT_ASSERT( document.size() - carrier.size() < carrier.size() / 4 );
+
+        PdfVecObjects            parsedObjects;
+        PdfParser                parser( &parsedObjects );
+        PdfRefCountedInputDevice device( new PdfBufferInputDevice( document.data(), document.size() ) );
+        parsedObjects.SetAutoDelete( true );
+        parser.ParseFile( device, false );
+        CPPUNIT_ASSERT_EQUAL( 1, parser.GetNumberOfIncrementalUpdates() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(parsedObjects.GetObjectCount()),
+                              parser.GetTrailer()->GetDictionary().GetKeyAsLong( PdfName::KeySize ) );
+
+        const unsigned int threads[] = { 0, 3 };
+        for( unsigned int nThreads : threads )
+        {
+            codec.SetThreads( nThreads );
+            std::string decoded = codec.Decode( document.data(), document.size() );
+            if( framed )
+                CPPUNIT_ASSERT( decoded == payload );
+            else
+                CPPUNIT_ASSERT( decoded.compare( 0, payload.size(), payload ) == 0 );
+        }
+
+        // the dictionaries of the original document come first,
+        // and hold no frame
+        if( framed )
+        {
+            codec.SetIncremental( false );
+            CPPUNIT_ASSERT_THROW( codec.Decode( document.data(), document.size() ), PdfError );
+            codec.SetIncremental( true );
+        }
+    }
+}
+
+void DictEncodeTest::testCapacityReport()
+{
+    const std::string carrier = WriteCarrier();
+
+    PdfIdCodec codec;
+    for( int incremental = 0; incremental < 2; incremental++ )
+    {
+        codec.SetIncremental( incremental != 0 );
+
+        PdfIdCapacityReport report;
+        const size_t nCapacity = codec.GetCapacity( carrier.data(), carrier.size(), report );
+        CPPUNIT_ASSERT_EQUAL( codec.GetCapacity( carrier.data(), carrier.size() ), nCapacity );
+        CPPUNIT_ASSERT_EQUAL( nCapacity, report.capacity );
+        CPPUNIT_ASSERT_EQUAL( report.capacityBits / 8, nCapacity );
+
+        // every object holding bits is listed once
+        const PdfDictEncodeReport & dicts = report.dictionaries;
+        size_t nBits = dicts.trailerBits;
+        for( const PdfDictEncodeReport::TObjectCapacity & object : dicts.objects )
+        {
+            CPPUNIT_ASSERT( object.bits > 0 );
+            nBits += object.bits;
+        }
+        CPPUNIT_ASSERT_EQUAL( report.capacityBits, nBits );
+
+        // the histogram gives the capacity back, minus what is rounded away
+        double dBits = 0.0;
+        for( size_t nKeys = 2; nKeys < dicts.keyCounts.size(); nKeys++ )
+            dBits += dicts.keyCounts[nKeys] * lgamma( static_cast<double>(nKeys + 1) ) / log( 2.0 );
+        CPPUNIT_ASSERT( dicts.floorLossBits > 0.0 );
+        CPPUNIT_ASSERT_DOUBLES_EQUAL( dBits, nBits + dicts.floorLossBits, 1e-6 * dBits );
+
+        // updates leave most of the document alone
+        if( incremental )
+            CPPUNIT_ASSERT( report.rewrittenBytes > 0 && report.rewrittenBytes < carrier.size() );
+        else
+            CPPUNIT_ASSERT_EQUAL( carrier.size(), report.rewrittenBytes );
+
+        CPPUNIT_ASSERT( report.parseSeconds >= 0.0 && report.countSeconds >= 0.0 );
+    }
+}
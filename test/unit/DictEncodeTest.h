@@ -0,0 +1,91 @@
+#ifndef _DICT_ENCODE_TEST_H_
+#define _DICT_ENCODE_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/** This test tests the dictionary order encoding used by pdfid
+ */
+class DictEncodeTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( DictEncodeTest );
+    CPPUNIT_TEST( testCapacityMatchesWrite );
+    CPPUNIT_TEST( testObjectCapacity );
+    CPPUNIT_TEST( testAvailableBits );
+    CPPUNIT_TEST( testRankMatchesGmp );
+    CPPUNIT_TEST( testUnrankMatchesGmp );
+    CPPUNIT_TEST( testLargeRank );
+    CPPUNIT_TEST( testStreamingDecode );
+    CPPUNIT_TEST( testBitStreams );
+    CPPUNIT_TEST( testRoundTrip );
+    CPPUNIT_TEST( testParallelDecode );
+    CPPUNIT_TEST( testParallelWrite );
+    CPPUNIT_TEST( testFramedPayload );
+    CPPUNIT_TEST( testCodec );
+    CPPUNIT_TEST( testIncrementalUpdate );
+    CPPUNIT_TEST( testCapacityReport );
+    CPPUNIT_TEST_SUITE_END();
+
+ public:
+    void setUp();
+    void tearDown();
+
+    /** Compares PdfWriter::GetDictEncodeCapacity with the
+     *  bit count of an actual write
+     */
+    void testCapacityMatchesWrite();
+    void testObjectCapacity();
+
+    /** The machine word fast paths must agree with the gmp fallback
+     */
+    void testAvailableBits();
+    void testRankMatchesGmp();
+    void testUnrankMatchesGmp();
+
+    /** Checks the product tree conversion used for large
+     *  dictionaries against a digit by digit conversion
+     */
+    void testLargeRank();
+
+    /** bit_ostream must emit dictionaries below the parser's
+     *  watermark early, without changing the decoded payload
+     */
+    void testStreamingDecode();
+
+    /** bit_istream and bit_ostream must move bits in the same
+     *  order whatever the chunk sizes and word alignment
+     */
+    void testBitStreams();
+    void testRoundTrip();
+
+    /** PdfParser::DecodeDictOrder must decode the same
+     *  payload whatever the number of threads
+     */
+    void testParallelDecode();
+
+    /** PdfWriter must write the same bytes, and hide the same
+     *  bits, whatever the number of threads
+     */
+    void testParallelWrite();
+
+    /** bit_ostream must recover framed payloads, tell when they are
+     *  complete or broken, and let the parser stop early
+     */
+    void testFramedPayload();
+
+    /** PdfIdCodec must hide payloads in documents held in
+     *  memory, and recover them
+     */
+    void testCodec();
+
+    /** PdfIdCodec must append payloads to documents as incremental
+     *  updates, and only decode the newest update
+     */
+    void testIncrementalUpdate();
+
+    /** The capacity report must add up to the capacity it
+     *  comes with, for whole documents and updates
+     */
+    void testCapacityReport();
+};
+
+#endif // _DICT_ENCODE_TEST_H_
@@ -396,3 +396,38 @@ void EncryptTest::testEnableAlgorithms()
     printf("Decrypted buffer: %s\n", pEncBuffer );
     */
 
+void EncryptTest::testFailedWrite()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+
+    PdfObject* pCatalog = vecObjects.CreateObject( "Catalog" );
+    pCatalog->GetDictionary().AddKey( "Lang", PdfString( "en" ) );
+    trailer.GetDictionary().AddKey( "Root", pCatalog->Reference() );
+
+    std::auto_ptr<PdfEncrypt> pEncrypt( PdfEncrypt::CreatePdfEncrypt( "user", "owner", m_protection,
+                                                                       PdfEncrypt::ePdfEncryptAlgorithm_AESV2 ) );
+    PdfWriter writer( &vecObjects, &trailer );
+    writer.SetEncrypted( *pEncrypt );
+
+    const size_t lObjects = vecObjects.GetSize();
+
+    // the output device is too small
+    char            small[16];
+    PdfOutputDevice smallDevice( small, sizeof(small) );
+    CPPUNIT_ASSERT_THROW( writer.Write( &smallDevice ), PdfError );
+    CPPUNIT_ASSERT_EQUAL( lObjects, vecObjects.GetSize() );
+
+    // linearized documents cannot be written
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    writer.SetLinearized( true );
+    CPPUNIT_ASSERT_THROW( writer.Write( &device ), PdfError );
+    CPPUNIT_ASSERT_EQUAL( lObjects, vecObjects.GetSize() );
+
+    writer.SetLinearized( false );
+    writer.Write( &device );
+    CPPUNIT_ASSERT_EQUAL( lObjects, vecObjects.GetSize() );
+    CPPUNIT_ASSERT( std::string( buffer.GetBuffer(), device.GetLength() ).find( "/Encrypt" ) != std::string::npos );
+}
@@ -49,6 +49,7 @@ class EncryptTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testLoadEncrypedFilePdfParser );
   CPPUNIT_TEST( testLoadEncrypedFilePdfMemDocument );
   CPPUNIT_TEST( testEnableAlgorithms );
+  CPPUNIT_TEST( testFailedWrite );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -73,6 +74,11 @@ class EncryptTest : public CppUnit::TestFixture
   void testLoadEncrypedFilePdfMemDocument();
 
   void testEnableAlgorithms();
+
+  /** A failed write removes the encryption dictionary it added,
+   *  once, and the writer can write again afterwards.
+   */
+  void testFailedWrite();
     
  private:
   void TestAuthenticate( PoDoFo::PdfEncrypt* pEncrypt, int keyLength, int rValue );
@@ -132,3 +132,128 @@ void FilterTest::testCCITT()
 
 
 }
+
+// a buffer which compresses well, but not down to nothing
+static std::string FlateTestData()
+{
+    std::string sData;
+    for( int i = 0; i < 4096; i++ )
+    {
+        sData += s_pTestBuffer1 + (i * 7) % 64;
+        sData += static_cast<char>(i * 31);
+    }
+
+    return sData;
+}
+
+static pdf_long FlateEncodedLength( const std::string & sData, const PdfFlateParameters & rParameters )
+{
+    char*      pEncoded;
+    char*      pDecoded;
+    pdf_long   lEncoded;
+    pdf_long   lDecoded;
+
+    std::auto_ptr<PdfFilter> pFilter = PdfFilterFactory::Create( ePdfFilter_FlateDecode, &rParameters );
+    pFilter->Encode( sData.data(), sData.size(), &pEncoded, &lEncoded );
+
+    // any parameters are decoded by the default filter
+    std::auto_ptr<PdfFilter> pDecoder = PdfFilterFactory::Create( ePdfFilter_FlateDecode );
+    pDecoder->Decode( pEncoded, lEncoded, &pDecoded, &lDecoded );
+
+    CPPUNIT_ASSERT_EQUAL( static_cast<long>(sData.size()), static_cast<long>(lDecoded) );
+    CPPUNIT_ASSERT_EQUAL( memcmp( sData.data(), pDecoded, sData.size() ), 0 );
+
+    podofo_free( pEncoded );
+    podofo_free( pDecoded );
+    return lEncoded;
+}
+
+void FilterTest::testFlateParameters()
+{
+    const std::string sData = FlateTestData();
+
+    const pdf_long lStored  = FlateEncodedLength( sData, PdfFlateParameters( 0 ) );
+    const pdf_long lFastest = FlateEncodedLength( sData, PdfFlateParameters( 1 ) );
+    const pdf_long lBest    = FlateEncodedLength( sData, PdfFlateParameters( 9 ) );
+    CPPUNIT_ASSERT( lStored > static_cast<pdf_long>(sData.size()) );
+    CPPUNIT_ASSERT( lFastest < lStored );
+    CPPUNIT_ASSERT( lBest <= lFastest );
+    CPPUNIT_ASSERT_EQUAL( FlateEncodedLength( sData, PdfFlateParameters() ),
+                          FlateEncodedLength( sData, PdfFlateParameters( 6 ) ) );
+
+    // without string matching, the repeated text is not shrunk
+    const pdf_long lHuffman = FlateEncodedLength( sData, PdfFlateParameters( 9, ePdfFlateStrategy_HuffmanOnly ) );
+    CPPUNIT_ASSERT( lHuffman > lBest );
+    FlateEncodedLength( sData, PdfFlateParameters( 9, ePdfFlateStrategy_Filtered ) );
+    FlateEncodedLength( sData, PdfFlateParameters( 9, ePdfFlateStrategy_RLE ) );
+    FlateEncodedLength( sData, PdfFlateParameters( 9, ePdfFlateStrategy_Fixed ) );
+    FlateEncodedLength( sData, PdfFlateParameters( 9, ePdfFlateStrategy_Default, 9, 1 ) );
+
+    try {
+        FlateEncodedLength( sData, PdfFlateParameters( 10 ) );
+        CPPUNIT_FAIL( "Level 10 must be rejected." );
+    } catch( PdfError & e ) {
+        CPPUNIT_ASSERT_EQUAL( ePdfError_ValueOutOfRange, e.GetError() );
+    }
+
+    try {
+        FlateEncodedLength( sData, PdfFlateParameters( 6, ePdfFlateStrategy_Default, 16 ) );
+        CPPUNIT_FAIL( "A window of 2^16 bytes must be rejected." );
+    } catch( PdfError & e ) {
+        CPPUNIT_ASSERT_EQUAL( ePdfError_Flate, e.GetError() );
+    }
+}
+
+static std::string WriteFlateDocument( const PdfFlateParameters & rDocument, const PdfFlateParameters* pStream )
+{
+    const std::string sData = FlateTestData();
+
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+
+    PdfObject* pCatalog = vecObjects.CreateObject( "Catalog" );
+    trailer.GetDictionary().AddKey( "Root", pCatalog->Reference() );
+    for( int i = 0; i < 2; i++ )
+    {
+        PdfObject* pObject = vecObjects.CreateObject();
+        if( pStream && i )
+            pObject->GetStream()->SetFlateParameters( *pStream );
+
+        pObject->GetStream()->Set( sData.data(), sData.size(), TVecFilters() );
+    }
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice     device( &buffer );
+    PdfWriter           writer( &vecObjects, &trailer );
+    writer.SetWriteMode( static_cast<EPdfWriteMode>(ePdfWriteMode_Compact | ePdfWriteMode_CompressStreams) );
+    writer.SetFlateParameters( rDocument );
+    CPPUNIT_ASSERT( writer.GetFlateParameters() == rDocument );
+    writer.Write( &device );
+
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+void FilterTest::testWriterFlateParameters()
+{
+    const PdfFlateParameters stored( 0 );
+    const PdfFlateParameters best( 9 );
+
+    const size_t lStored = WriteFlateDocument( stored, NULL ).size();
+    const size_t lBest   = WriteFlateDocument( best, NULL ).size();
+    CPPUNIT_ASSERT( lStored > 2 * FlateTestData().size() );
+    CPPUNIT_ASSERT( lBest < lStored / 4 );
+
+    // the parameters of a stream take precedence over those of the document
+    const size_t lMixed = WriteFlateDocument( best, &stored ).size();
+    CPPUNIT_ASSERT( lMixed > lBest + FlateTestData().size() / 2 );
+    CPPUNIT_ASSERT( lMixed < lStored );
+
+    // streams being set use their own parameters too
+    PdfVecObjects vecObjects;
+    PdfObject* pObject = vecObjects.CreateObject();
+    const std::string sData = FlateTestData();
+    pObject->GetStream()->SetFlateParameters( stored );
+    pObject->GetStream()->Set( sData.data(), sData.size() );
+    CPPUNIT_ASSERT( pObject->GetStream()->GetLength() > static_cast<pdf_long>(sData.size()) );
+}
@@ -32,6 +32,8 @@ class FilterTest : public CppUnit::TestFixture
   CPPUNIT_TEST_SUITE( FilterTest );
   CPPUNIT_TEST( testFilters );
   CPPUNIT_TEST( testCCITT );
+  CPPUNIT_TEST( testFlateParameters );
+  CPPUNIT_TEST( testWriterFlateParameters );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -42,6 +44,10 @@ class FilterTest : public CppUnit::TestFixture
 
   void testCCITT();
 
+  void testFlateParameters();
+
+  void testWriterFlateParameters();
+
  private:
   void TestFilter( PoDoFo::EPdfFilter eFilter, const char * pTestBuffer, const long lTestLength );
 };
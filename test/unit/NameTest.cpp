@@ -22,6 +22,10 @@
 
 #include <podofo.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace PoDoFo;
 
 // Registers the fixture into the 'registry'
@@ -120,6 +124,66 @@ void NameTest::testFromEscaped()
     TestFromEscape( "Length#20With#20Spaces", "Length With Spaces" );
 }
 
+void NameTest::testOrdering()
+{
+    // common prefixes shorter and longer than 8 bytes, high bytes,
+    // and names that are a prefix of others
+    const char* apszNames[] = { "", "A", "AB", "ABCDEFG", "ABCDEFGH", "ABCDEFGHI", "ABCDEFGHIJ",
+                                "ABCDEFGI", "FontDescriptor", "FontFile", "FontFile2", "FontFile3",
+                                "Length", "Length1", "a", "\x7f", "\x80", "\xff", "\xff\xff" };
+    const size_t nNames = sizeof(apszNames) / sizeof(apszNames[0]);
+
+    for( size_t i = 0; i < nNames; i++ )
+    {
+        for( size_t j = 0; j < nNames; j++ )
+        {
+            PdfName name1( apszNames[i] );
+            PdfName name2( apszNames[j] );
+            std::string str1( apszNames[i] );
+            std::string str2( apszNames[j] );
+
+            CPPUNIT_ASSERT_EQUAL( str1 < str2, name1 < name2 );
+            CPPUNIT_ASSERT_EQUAL( str1 == str2, name1 == name2 );
+        }
+    }
+
+    // names built from different sources are the same name
+    PdfName name( std::string( "Interned" ) );
+    CPPUNIT_ASSERT( name == PdfName( "Interned" ) );
+    CPPUNIT_ASSERT( name == PdfName( "Interned and more", 8 ) );
+    CPPUNIT_ASSERT( name == PdfName::FromEscaped( "Int#65rned" ) );
+    CPPUNIT_ASSERT( &name.GetName() == &PdfName( "Interned" ).GetName() );
+}
+
+void NameTest::testInternedCount()
+{
+    // each thread keeps up to 256 atoms alive in its cache
+    const size_t nBefore = PdfName::GetInternedCount();
+    {
+        std::vector<PdfName> vecNames;
+        for( int i = 0; i < 10000; i++ )
+            vecNames.push_back( PdfName( "Transient" + std::to_string( i ) ) );
+
+        std::vector<PdfName> vecCopies( vecNames );
+        CPPUNIT_ASSERT( PdfName::GetInternedCount() + 256 >= nBefore + 10000 );
+        CPPUNIT_ASSERT( vecCopies[42] == PdfName( "Transient42" ) );
+    }
+    CPPUNIT_ASSERT( PdfName::GetInternedCount() <= nBefore + 256 );
+
+    // a name comes back as the same value once its atom was freed
+    CPPUNIT_ASSERT( PdfName( "Transient0" ) == PdfName( std::string( "Transient0" ) ) );
+    CPPUNIT_ASSERT( PdfName( "Transient0" ) < PdfName( "Transient1" ) );
+
+    // the cache of a thread is dropped when it exits
+    const size_t nMain = PdfName::GetInternedCount();
+    std::thread worker( []() {
+        for( int i = 0; i < 1000; i++ )
+            PdfName name( "Worker" + std::to_string( i ) );
+    } );
+    worker.join();
+    CPPUNIT_ASSERT_EQUAL( nMain, PdfName::GetInternedCount() );
+}
+
 //
 // Test encoding of names.
 // pszString : internal representation, ie unencoded name
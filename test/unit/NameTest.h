@@ -34,6 +34,8 @@ class NameTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testEquality );
   CPPUNIT_TEST( testWrite );
   CPPUNIT_TEST( testFromEscaped );
+  CPPUNIT_TEST( testOrdering );
+  CPPUNIT_TEST( testInternedCount );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -47,6 +49,15 @@ class NameTest : public CppUnit::TestFixture
   void testWrite();
   void testFromEscaped();
 
+  /** Names must sort as their unescaped values do, byte by byte,
+   *  whatever the length of their common prefix
+   */
+  void testOrdering();
+
+  /** Interned names must be freed once no name uses them
+   */
+  void testInternedCount();
+
  private:
 
   void TestName( const char* pszString, const char* pszExpectedEncoded );
@@ -38,6 +38,7 @@
 #include <sys/resource.h>
 #endif
 
+#include <algorithm>
 #include <limits>
 
 CPPUNIT_TEST_SUITE_REGISTRATION( ParserTest );
@@ -1981,6 +1982,324 @@ void ParserTest::testIsPdfFile()
     }     
 }
 
+// a document with enough objects for several batches of each thread,
+// with a stream every ten objects which is not compressed
+static void CreateLoadThreadsDocument( PoDoFo::PdfVecObjects & vecObjects, PoDoFo::PdfObject & trailer )
+{
+    PoDoFo::PdfArray kids;
+
+    PoDoFo::PdfObject* pCatalog = vecObjects.CreateObject( "Catalog" );
+    for( int i = 0; i < 500; i++ )
+    {
+        PoDoFo::PdfObject* pObject = vecObjects.CreateObject( "Thing" );
+        pObject->GetDictionary().AddKey( "Index", static_cast<PoDoFo::pdf_int64>(i) );
+        pObject->GetDictionary().AddKey( "Text", PoDoFo::PdfString( "plain text" ) );
+        if( i % 10 == 0 )
+            pObject->GetStream()->Set( "plain stream", 12, PoDoFo::TVecFilters() );
+
+        kids.push_back( pObject->Reference() );
+    }
+    pCatalog->GetDictionary().AddKey( "Kids", kids );
+    trailer.GetDictionary().AddKey( "Root", pCatalog->Reference() );
+
+    // the file identifier depends on the time without an info dictionary
+    PoDoFo::PdfObject* pInfo = vecObjects.CreateObject();
+    pInfo->GetDictionary().AddKey( "Producer", PoDoFo::PdfString( "ParserTest" ) );
+    trailer.GetDictionary().AddKey( "Info", pInfo->Reference() );
+}
+
+// the document of CreateLoadThreadsDocument, encrypted with pEncrypt
+// if it is not NULL
+static std::string WriteLoadThreadsDocument( const PoDoFo::PdfEncrypt* pEncrypt,
+                                             PoDoFo::EPdfWriteMode eWriteMode = PoDoFo::ePdfWriteMode_Compact,
+                                             unsigned int nObjectStreamSize = 100 )
+{
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfObject     trailer;
+
+    vecObjects.SetAutoDelete( true );
+    CreateLoadThreadsDocument( vecObjects, trailer );
+
+    PoDoFo::PdfWriter writer( &vecObjects, &trailer );
+    writer.SetWriteMode( eWriteMode );
+    writer.SetObjectStreamSize( nObjectStreamSize );
+    if( pEncrypt )
+        writer.SetEncrypted( *pEncrypt );
+
+    PoDoFo::PdfRefCountedBuffer buffer;
+    PoDoFo::PdfOutputDevice     device( &buffer );
+    writer.Write( &device );
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+// load a document on nThreads threads, and write its objects
+// and free objects back without encryption
+static std::string LoadThreadsObjects( const std::string & document, unsigned int nThreads )
+{
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfParser     parser( &vecObjects );
+
+    vecObjects.SetAutoDelete( true );
+    parser.SetLoadThreads( nThreads );
+    parser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( document.c_str(), document.size() ) ), false );
+
+    std::ostringstream      output;
+    PoDoFo::PdfOutputDevice device( &output );
+    for( PoDoFo::TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it )
+        (*it)->WriteObject( &device, PoDoFo::ePdfWriteMode_Compact, NULL );
+
+    const PoDoFo::TPdfReferenceList & rFree = vecObjects.GetFreeObjects();
+    for( PoDoFo::TCIPdfReferenceList it = rFree.begin(); it != rFree.end(); ++it )
+        output << "free " << it->ObjectNumber() << " " << it->GenerationNumber() << "\n";
+
+    device.Flush();
+    return output.str();
+}
+
+void ParserTest::testLoadThreads()
+{
+    const unsigned int threads[] = { 2, 3, 8 };
+
+    std::string plain = WriteLoadThreadsDocument( NULL );
+    std::string serial = LoadThreadsObjects( plain, 0 );
+    CPPUNIT_ASSERT( serial.find( "plain stream" ) != std::string::npos );
+    for( unsigned int nThreads : threads )
+        CPPUNIT_ASSERT( LoadThreadsObjects( plain, nThreads ) == serial );
+
+    // the first broken object raises the same error
+    std::string broken = plain;
+    const size_t lBroken = broken.find( "\n300 0 obj" );
+    CPPUNIT_ASSERT( lBroken != std::string::npos );
+    broken[lBroken + 7] = 'x';
+
+    for( unsigned int nThreads : { 0, 2, 3, 8 } )
+    {
+        try {
+            LoadThreadsObjects( broken, nThreads );
+            CPPUNIT_FAIL( "Should throw exception" );
+        } catch( PoDoFo::PdfError & error ) {
+            CPPUNIT_ASSERT_EQUAL( PoDoFo::ePdfError_NoObject, error.GetError() );
+        }
+    }
+
+    // each thread decrypts strings and streams with its own copy
+    PoDoFo::PdfEncrypt* pEncrypt = PoDoFo::PdfEncrypt::CreatePdfEncrypt( "", "owner" );
+    std::string encrypted = WriteLoadThreadsDocument( pEncrypt );
+    delete pEncrypt;
+
+    CPPUNIT_ASSERT( encrypted.find( "plain" ) == std::string::npos );
+    serial = LoadThreadsObjects( encrypted, 0 );
+    // encrypted strings are written as hex strings, and stay so
+    CPPUNIT_ASSERT( serial.find( "<706C61696E2074657874>" ) != std::string::npos );
+    CPPUNIT_ASSERT( serial.find( "plain stream" ) != std::string::npos );
+    for( unsigned int nThreads : threads )
+        CPPUNIT_ASSERT( LoadThreadsObjects( encrypted, nThreads ) == serial );
+}
+
+void ParserTest::testWriteObjectStreams()
+{
+    const PoDoFo::EPdfWriteMode eWriteMode = static_cast<PoDoFo::EPdfWriteMode>(PoDoFo::ePdfWriteMode_Compact | PoDoFo::ePdfWriteMode_ObjectStreams);
+
+    std::string plain = WriteLoadThreadsDocument( NULL );
+    PoDoFo::PdfVecObjects plainObjects;
+    PoDoFo::PdfParser     plainParser( &plainObjects );
+    plainObjects.SetAutoDelete( true );
+    plainParser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( plain.c_str(), plain.size() ) ), false );
+
+    // more than 256 objects per stream need a wider index in the XRef stream
+    for( unsigned int nObjectStreamSize : { 1, 64, 300 } )
+    {
+        std::string packed = WriteLoadThreadsDocument( NULL, eWriteMode, nObjectStreamSize );
+        CPPUNIT_ASSERT( packed.size() < plain.size() || nObjectStreamSize == 1 );
+        CPPUNIT_ASSERT( packed.compare( 0, 8, "%PDF-1.5" ) == 0 );
+        CPPUNIT_ASSERT( packed.find( "/ObjStm" ) != std::string::npos );
+
+        // only objects with a stream are left at the top level
+        CPPUNIT_ASSERT( packed.find( "\n2 0 obj" ) != std::string::npos );
+        CPPUNIT_ASSERT( packed.find( "\n3 0 obj" ) == std::string::npos );
+
+        PoDoFo::PdfVecObjects packedObjects;
+        PoDoFo::PdfParser     packedParser( &packedObjects );
+        packedObjects.SetAutoDelete( true );
+        packedParser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( packed.c_str(), packed.size() ) ), false );
+        CPPUNIT_ASSERT( packedParser.HasXRefStream() );
+
+        for( PoDoFo::TCIVecObjects it = plainObjects.begin(); it != plainObjects.end(); ++it )
+        {
+            const PoDoFo::PdfObject* pPacked = packedObjects.GetObject( (*it)->Reference() );
+            CPPUNIT_ASSERT( pPacked );
+
+            std::string expected;
+            std::string actual;
+            (*it)->ToString( expected, PoDoFo::ePdfWriteMode_Compact );
+            pPacked->ToString( actual, PoDoFo::ePdfWriteMode_Compact );
+            CPPUNIT_ASSERT_EQUAL( expected, actual );
+            CPPUNIT_ASSERT_EQUAL( (*it)->HasStream(), pPacked->HasStream() );
+        }
+    }
+
+    // encrypted documents are not packed
+    PoDoFo::PdfEncrypt* pEncrypt = PoDoFo::PdfEncrypt::CreatePdfEncrypt( "", "owner" );
+    std::string encrypted = WriteLoadThreadsDocument( pEncrypt, eWriteMode );
+    delete pEncrypt;
+    CPPUNIT_ASSERT( encrypted.find( "/ObjStm" ) == std::string::npos );
+}
+
+void ParserTest::testWriteObjectStreamsFreeObjects()
+{
+    const PoDoFo::EPdfWriteMode eWriteMode = static_cast<PoDoFo::EPdfWriteMode>(PoDoFo::ePdfWriteMode_Compact | PoDoFo::ePdfWriteMode_ObjectStreams);
+
+    // a document which lists free objects of a later generation in its xref
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+    CreateLoadThreadsDocument( vecObjects, trailer );
+
+    const unsigned int nFirstFree = static_cast<unsigned int>(vecObjects.GetObjectCount());
+    vecObjects.AddFreeObject( PoDoFo::PdfReference( nFirstFree, 1 ) );
+    vecObjects.AddFreeObject( PoDoFo::PdfReference( nFirstFree + 1, 1 ) );
+
+    PoDoFo::PdfRefCountedBuffer buffer;
+    PoDoFo::PdfOutputDevice     device( &buffer );
+    PoDoFo::PdfWriter           writer( &vecObjects, &trailer );
+    writer.SetWriteMode( eWriteMode );
+    writer.Write( &device );
+    std::string packed( buffer.GetBuffer(), device.GetLength() );
+
+    PoDoFo::PdfVecObjects packedObjects;
+    PoDoFo::PdfParser     packedParser( &packedObjects );
+    packedObjects.SetAutoDelete( true );
+    packedParser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( packed.c_str(), packed.size() ) ), false );
+    CPPUNIT_ASSERT( packedParser.HasXRefStream() );
+
+    // the object streams and the XRef stream do not take the free numbers
+    CPPUNIT_ASSERT( packed.find( "\n" + std::to_string( nFirstFree ) + " 1 obj" ) == std::string::npos );
+    CPPUNIT_ASSERT( packed.find( "\n" + std::to_string( nFirstFree + 1 ) + " 1 obj" ) == std::string::npos );
+    CPPUNIT_ASSERT( !packedObjects.GetObject( PoDoFo::PdfReference( nFirstFree, 1 ) ) );
+    CPPUNIT_ASSERT( !packedObjects.GetObject( PoDoFo::PdfReference( nFirstFree + 1, 1 ) ) );
+
+    const PoDoFo::TPdfReferenceList & rFree = packedObjects.GetFreeObjects();
+    CPPUNIT_ASSERT( std::find( rFree.begin(), rFree.end(), PoDoFo::PdfReference( nFirstFree, 1 ) ) != rFree.end() );
+    CPPUNIT_ASSERT( std::find( rFree.begin(), rFree.end(), PoDoFo::PdfReference( nFirstFree + 1, 1 ) ) != rFree.end() );
+
+    for( PoDoFo::TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it )
+    {
+        if( (*it)->IsDictionary() && (*it)->GetDictionary().HasKey( PoDoFo::PdfName::KeyType )
+            && (*it)->GetDictionary().GetKey( PoDoFo::PdfName::KeyType )->IsName()
+            && (*it)->GetDictionary().GetKey( PoDoFo::PdfName::KeyType )->GetName() == PoDoFo::PdfName( "XRef" ) )
+            continue;
+
+        const PoDoFo::PdfObject* pPacked = packedObjects.GetObject( (*it)->Reference() );
+        CPPUNIT_ASSERT( pPacked );
+
+        std::string expected;
+        std::string actual;
+        (*it)->ToString( expected, PoDoFo::ePdfWriteMode_Compact );
+        pPacked->ToString( actual, PoDoFo::ePdfWriteMode_Compact );
+        CPPUNIT_ASSERT_EQUAL( expected, actual );
+    }
+}
+
+void ParserTest::testWriteXRefStreamFreeObjects()
+{
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+    CreateLoadThreadsDocument( vecObjects, trailer );
+
+    const unsigned int nFirstFree = static_cast<unsigned int>(vecObjects.GetObjectCount());
+    vecObjects.AddFreeObject( PoDoFo::PdfReference( nFirstFree, 1 ) );
+
+    PoDoFo::PdfRefCountedBuffer buffer;
+    PoDoFo::PdfOutputDevice     device( &buffer );
+    PoDoFo::PdfWriter           writer( &vecObjects, &trailer );
+    writer.SetWriteMode( PoDoFo::ePdfWriteMode_Compact );
+    writer.SetUseXRefStream( true );
+    writer.Write( &device );
+    std::string written( buffer.GetBuffer(), device.GetLength() );
+
+    // without object streams, the XRef stream still reuses a free number
+    const std::string sXRef = "\n" + std::to_string( nFirstFree ) + " 1 obj";
+    CPPUNIT_ASSERT( written.find( sXRef ) != std::string::npos );
+    CPPUNIT_ASSERT( written.find( "/XRef", written.find( sXRef ) ) != std::string::npos );
+
+    PoDoFo::PdfVecObjects writtenObjects;
+    PoDoFo::PdfParser     parser( &writtenObjects );
+    writtenObjects.SetAutoDelete( true );
+    parser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( written.c_str(), written.size() ) ), false );
+    CPPUNIT_ASSERT( parser.HasXRefStream() );
+    CPPUNIT_ASSERT( writtenObjects.GetObject( PoDoFo::PdfReference( nFirstFree, 1 ) ) );
+}
+
+void ParserTest::testWriteCompressStreams()
+{
+    const PoDoFo::EPdfWriteMode eWriteMode = static_cast<PoDoFo::EPdfWriteMode>(PoDoFo::ePdfWriteMode_Compact | PoDoFo::ePdfWriteMode_CompressStreams);
+    std::string serial;
+
+    // with no budget, no object is serialized ahead of the one written
+    for( unsigned int nThreads : { 0, 2, 3, 8 } )
+    {
+        for( size_t lBudget : { static_cast<size_t>(0), static_cast<size_t>(64 * 1024 * 1024) } )
+        {
+            PoDoFo::PdfVecObjects vecObjects;
+            PoDoFo::PdfObject     trailer;
+            vecObjects.SetAutoDelete( true );
+            CreateLoadThreadsDocument( vecObjects, trailer );
+
+            PoDoFo::PdfWriter writer( &vecObjects, &trailer );
+            writer.SetWriteMode( eWriteMode );
+            writer.SetWriteThreads( nThreads );
+            writer.SetWriteMemoryBudget( lBudget );
+
+            PoDoFo::PdfRefCountedBuffer buffer;
+            PoDoFo::PdfOutputDevice     device( &buffer );
+            writer.Write( &device );
+            std::string document( buffer.GetBuffer(), device.GetLength() );
+
+            if( serial.empty() )
+                serial = document;
+            CPPUNIT_ASSERT( document == serial );
+
+            // streams are compressed into copies of their objects
+            for( PoDoFo::TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it )
+            {
+                if( !(*it)->HasStream() )
+                    continue;
+
+                CPPUNIT_ASSERT( !(*it)->GetDictionary().HasKey( PoDoFo::PdfName::KeyFilter ) );
+                CPPUNIT_ASSERT_EQUAL( static_cast<PoDoFo::pdf_long>(12), (*it)->GetStream()->GetLength() );
+            }
+        }
+    }
+
+    // libdeflate may keep such short data in a stored block, so only
+    // the filter and the decoded data are checked
+    CPPUNIT_ASSERT( serial.find( "/FlateDecode" ) != std::string::npos );
+
+    // the streams decode to their original data
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfParser     parser( &vecObjects );
+    vecObjects.SetAutoDelete( true );
+    parser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( serial.c_str(), serial.size() ) ), false );
+
+    size_t nStreams = 0;
+    for( PoDoFo::TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it )
+    {
+        if( !(*it)->HasStream() )
+            continue;
+
+        char*            pBuffer;
+        PoDoFo::pdf_long lLen;
+        (*it)->GetStream()->GetFilteredCopy( &pBuffer, &lLen );
+        std::string data( pBuffer, lLen );
+        PoDoFo::podofo_free( pBuffer );
+
+        CPPUNIT_ASSERT_EQUAL( std::string( "plain stream" ), data );
+        ++nStreams;
+    }
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(50), nStreams );
+}
+
 std::string ParserTest::generateXRefEntries( size_t count )
 {
     std::string strXRefEntries;
@@ -2045,4 +2364,91 @@ bool ParserTest::canOutOfMemoryKillUnitTests()
     return bCanTerminateProcess;
 }
 
+// parse a file and write it again on nThreads threads
+static std::string RewriteFile( const char* pszPath, bool bLoadOnDemand, unsigned int nThreads )
+{
+    PoDoFo::PdfVecObjects vecObjects;
+    PoDoFo::PdfParser     parser( &vecObjects );
+
+    vecObjects.SetAutoDelete( true );
+    parser.ParseFile( pszPath, bLoadOnDemand );
+
+    PoDoFo::PdfWriter writer( &parser );
+    writer.SetWriteMode( PoDoFo::ePdfWriteMode_Compact );
+    writer.SetWriteThreads( nThreads );
 
+    PoDoFo::PdfRefCountedBuffer buffer;
+    PoDoFo::PdfOutputDevice     device( &buffer );
+    writer.Write( &device );
+    return std::string( buffer.GetBuffer(), device.GetLength() );
+}
+
+void ParserTest::testParallelWriteRawStreams()
+{
+    // its first stream has an indirect /Length, which is kept when
+    // the stream is copied from the input without being loaded: only
+    // a parser loading objects on demand leaves streams unloaded
+    const std::string sPath = std::string( PODOFO_TEST_PDFS_DIR ) + "/inline-image.pdf";
+
+    const bool onDemand[] = { true, false };
+    for( bool bLoadOnDemand : onDemand )
+    {
+        const std::string serial = RewriteFile( sPath.c_str(), bLoadOnDemand, 0 );
+        CPPUNIT_ASSERT_EQUAL( bLoadOnDemand, serial.find( "/Length 6 0 R" ) != std::string::npos );
+
+        const unsigned int threads[] = { 2, 4 };
+        for( unsigned int nThreads : threads )
+            CPPUNIT_ASSERT( serial == RewriteFile( sPath.c_str(), bLoadOnDemand, nThreads ) );
+    }
+}
+
+void ParserTest::testWriteTruncatedRawStream()
+{
+    // the /Length of the stream runs past the end of the file
+    std::ostringstream oss;
+    std::vector<size_t> offsets;
+    oss << "%PDF-1.4\n";
+    offsets.push_back( oss.str().size() );
+    oss << "1 0 obj\n<</Type/Catalog>>\nendobj\n";
+    offsets.push_back( oss.str().size() );
+    oss << "2 0 obj\n<</Length 5000>>\nstream\n" << std::string( 100, 'x' ) << "\nendstream\nendobj\n";
+    const size_t lXRef = oss.str().size();
+    oss << "xref\n0 3\n0000000000 65535 f \n";
+    for( size_t lOffset : offsets )
+    {
+        char szEntry[21];
+        snprintf( szEntry, sizeof(szEntry), "%010zu 00000 n \n", lOffset );
+        oss << szEntry;
+    }
+    oss << "trailer\n<</Size 3/Root 1 0 R>>\nstartxref\n" << lXRef << "\n%%EOF\n";
+    const std::string input = oss.str();
+
+    const unsigned int threads[] = { 0, 2 };
+    for( unsigned int nThreads : threads )
+    {
+        PoDoFo::PdfVecObjects vecObjects;
+        PoDoFo::PdfParser     parser( &vecObjects );
+        vecObjects.SetAutoDelete( true );
+        parser.ParseFile( PoDoFo::PdfRefCountedInputDevice( new PoDoFo::PdfBufferInputDevice( input.c_str(), input.size() ) ), true );
+
+        PoDoFo::PdfWriter writer( &parser );
+        writer.SetWriteMode( PoDoFo::ePdfWriteMode_Compact );
+        writer.SetWriteThreads( nThreads );
+
+        PoDoFo::PdfRefCountedBuffer buffer;
+        PoDoFo::PdfOutputDevice     device( &buffer );
+        writer.Write( &device );
+        const std::string output( buffer.GetBuffer(), device.GetLength() );
+
+        // the stream is loaded, and its /Length is the number
+        // of bytes actually written
+        const size_t lKey = output.find( "/Length ", output.find( "2 0 obj" ) );
+        CPPUNIT_ASSERT( lKey != std::string::npos );
+        const long lLength = strtol( output.c_str() + lKey + 8, NULL, 10 );
+        CPPUNIT_ASSERT( lLength < 5000 );
+
+        const size_t lData = output.find( "stream\n", lKey );
+        CPPUNIT_ASSERT( lData != std::string::npos );
+        CPPUNIT_ASSERT( output.compare( lData + 7 + lLength, 10, "\nendstream" ) == 0 );
+    }
+}
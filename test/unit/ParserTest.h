@@ -41,6 +41,13 @@ class ParserTest : public CppUnit::TestFixture
     CPPUNIT_TEST( testReadXRefStreamContents );
     CPPUNIT_TEST( testReadObjects );
     CPPUNIT_TEST( testIsPdfFile );
+    CPPUNIT_TEST( testLoadThreads );
+    CPPUNIT_TEST( testWriteObjectStreams );
+    CPPUNIT_TEST( testWriteObjectStreamsFreeObjects );
+    CPPUNIT_TEST( testWriteXRefStreamFreeObjects );
+    CPPUNIT_TEST( testWriteCompressStreams );
+    CPPUNIT_TEST( testParallelWriteRawStreams );
+    CPPUNIT_TEST( testWriteTruncatedRawStream );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -74,6 +81,14 @@ public:
 
     //void testReadObjectFromStream();
     void testIsPdfFile();
+
+    void testLoadThreads();
+    void testWriteObjectStreams();
+    void testWriteObjectStreamsFreeObjects();
+    void testWriteXRefStreamFreeObjects();
+    void testWriteCompressStreams();
+    void testParallelWriteRawStreams();
+    void testWriteTruncatedRawStream();
     //void testReadNextTrailer();
     //void testCheckEOFMarker();
 
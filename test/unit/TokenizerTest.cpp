@@ -22,6 +22,12 @@
 
 #include <cppunit/Asserter.h>
 
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+
 using namespace PoDoFo;
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TokenizerTest );
@@ -138,6 +144,9 @@ void TokenizerTest::testNumbers()
     Test( "-2.970000", ePdfDataType_Real );
     Test( "0", ePdfDataType_Number );
     Test( "4.", ePdfDataType_Real, "4.000000" );
+    Test( "+17", ePdfDataType_Number, "17" );
+    Test( "-.5", ePdfDataType_Real, "-0.500000" );
+    Test( "1-2", ePdfDataType_Number, "1" );
 
 }
 
@@ -262,3 +271,274 @@ void TokenizerTest::testLocale()
 
     setlocale( LC_ALL, old );
 }
+
+// GetNextToken() as it was when it read one byte at a time
+static bool ReferenceNextToken( PdfInputDevice* pDevice, char* pBuffer, size_t lSize, EPdfTokenType* peType )
+{
+    int       c;
+    pdf_int64 counter = 0;
+
+    *peType = ePdfTokenType_Token;
+    while( (c = pDevice->Look()) != EOF && counter + 1 < static_cast<pdf_int64>(lSize) )
+    {
+        if( !counter && PdfTokenizer::IsWhitespace( c ) )
+        {
+            pDevice->GetChar();
+            continue;
+        }
+        else if( c == '%' )
+        {
+            do {
+                c = pDevice->GetChar();
+            } while( c != EOF && c != 0x0D && c != 0x0A );
+
+            if( c == 0x0D && pDevice->Look() == 0x0A )
+                c = pDevice->GetChar();
+            if( counter )
+                break;
+        }
+        else if( !counter && (c == '<' || c == '>') )
+        {
+            *peType = ePdfTokenType_Delimiter;
+            c = pDevice->GetChar();
+            pBuffer[counter++] = c;
+
+            char n = pDevice->Look();
+            if( n == c )
+                pBuffer[counter++] = pDevice->GetChar();
+            break;
+        }
+        else if( counter && (PdfTokenizer::IsWhitespace( c ) || PdfTokenizer::IsDelimiter( c )) )
+            break;
+        else
+        {
+            c = pDevice->GetChar();
+            pBuffer[counter++] = c;
+            if( PdfTokenizer::IsDelimiter( c ) )
+            {
+                *peType = ePdfTokenType_Delimiter;
+                break;
+            }
+        }
+    }
+
+    pBuffer[counter] = '\0';
+    return c != EOF || counter;
+}
+
+static std::string ScannerName( EPdfScanner eScanner )
+{
+    switch( eScanner )
+    {
+        case ePdfScanner_Scalar: return "scalar scanner";
+        case ePdfScanner_SSE2:   return "SSE2 scanner";
+        case ePdfScanner_AVX2:   return "AVX2 scanner";
+        default:                 return "default scanner";
+    }
+}
+
+void TokenizerTest::TestScanner( const std::string & sBuffer, size_t lTokenSize )
+{
+    // each implementation this build and processor have, and the default
+    const EPdfScanner scanners[] = { ePdfScanner_Scalar, ePdfScanner_SSE2, ePdfScanner_AVX2, ePdfScanner_Default };
+    for( EPdfScanner eScanner : scanners )
+    {
+        if( PdfTokenizer::SetScanner( eScanner ) )
+            TestScanner( sBuffer, lTokenSize, eScanner );
+    }
+}
+
+void TokenizerTest::TestScanner( const std::string & sBuffer, size_t lTokenSize, EPdfScanner eScanner )
+{
+    for( int nDevice = 0; nDevice < 2; nDevice++ )
+    {
+        std::istringstream stream( sBuffer );
+        PdfRefCountedInputDevice device( nDevice
+                                         ? new PdfInputDevice( &stream )
+                                         : new PdfBufferInputDevice( sBuffer.data(), sBuffer.size() ) );
+        PdfBufferInputDevice reference( sBuffer.data(), sBuffer.size() );
+        PdfTokenizer         tokenizer( device, PdfRefCountedBuffer( lTokenSize ) );
+        std::vector<char>    expected( lTokenSize );
+
+        for( ;; )
+        {
+            const char*   pszToken;
+            EPdfTokenType eType, eExpectedType;
+            const bool    bGot      = tokenizer.GetNextToken( pszToken, &eType );
+            const bool    bExpected = ReferenceNextToken( &reference, &expected[0], lTokenSize, &eExpectedType );
+
+            CPPUNIT_ASSERT_EQUAL_MESSAGE( ScannerName( eScanner ), bExpected, bGot );
+            if( !bGot )
+                break;
+
+            CPPUNIT_ASSERT_EQUAL_MESSAGE( ScannerName( eScanner ), std::string( &expected[0] ), std::string( pszToken ) );
+            CPPUNIT_ASSERT_EQUAL( static_cast<int>(eExpectedType), static_cast<int>(eType) );
+            CPPUNIT_ASSERT_EQUAL( reference.Tell(), device.Device()->Tell() );
+        }
+    }
+}
+
+void TokenizerTest::testScanner()
+{
+    // the sample PDFs
+    const char* pszCorpus[] = { "inline-image.pdf" };
+    for( const char* pszFilename : pszCorpus )
+    {
+        const std::string sPath = std::string( PODOFO_TEST_PDFS_DIR ) + "/" + pszFilename;
+        std::ifstream     file( sPath.c_str(), std::ios::binary );
+        CPPUNIT_ASSERT( file );
+
+        const std::string sData( (std::istreambuf_iterator<char>( file )), std::istreambuf_iterator<char>() );
+        TestScanner( sData, 4096 );
+        TestScanner( sData, 7 );
+    }
+
+    // random runs of each class of bytes, long enough to cross
+    // the blocks of the scanners and the read buffer of streams
+    const std::string classes[] = {
+        std::string( "\x00\x09\x0A\x0C\x0D\x20", 6 ),
+        "()<>[]{}/%",
+        "\x0D\x0A",
+        "azAZ09.+-#\\\x01\x7F\x80\xAB\xFE\xFF",
+    };
+    std::mt19937 rand( 42 );
+    std::string  sData;
+    while( sData.size() < 300000 )
+    {
+        const std::string & sClass = classes[rand() % 4];
+        const size_t        lRun   = rand() % 8 ? rand() % 8 + 1 : rand() % 200 + 1;
+        for( size_t i = 0; i < lRun; i++ )
+            sData.push_back( sClass[rand() % sClass.size()] );
+    }
+    TestScanner( sData, 4096 );
+    TestScanner( sData, 16 );
+
+    // runs of every length up to a few blocks, so that the byte ending
+    // them lands on and around each 16 and 32 byte boundary, both from
+    // the start of the run and from the bytes scanned after a short run
+    std::string sRuns;
+    for( size_t lRun = 1; lRun <= 100; lRun++ )
+    {
+        sRuns += "%" + std::string( lRun, 'c' ) + ( lRun % 2 ? "\n" : "\r" );
+        sRuns += std::string( lRun, ' ' );
+        sRuns += std::string( lRun, 'a' ) + "/";
+        sRuns += std::string( lRun, 'b' ) + "\t";
+    }
+    TestScanner( sRuns, 4096 );
+}
+
+void TokenizerTest::testTokenView()
+{
+    const std::string sBuffer( "<</Widths [1 2 3 4 0 R 5.5] /A(x)>> %comment\n7 8" );
+    const char* pszTokens[] = {
+        "<<", "/", "Widths", "[", "1", "2", "3", "4", "0", "R", "5.5", "]",
+        "/", "A", "(", "x", ")", ">>", "7", "8", NULL
+    };
+
+    PdfRefCountedInputDevice device( new PdfBufferInputDevice( sBuffer.data(), sBuffer.size() ) );
+    PdfTokenizer             tokenizer( device, PdfRefCountedBuffer( 4096 ) );
+    const char*              pToken;
+    size_t                   lLen;
+    for( int i = 0; pszTokens[i]; i++ )
+    {
+        CPPUNIT_ASSERT( tokenizer.GetNextTokenView( pToken, lLen ) );
+        CPPUNIT_ASSERT_EQUAL( std::string( pszTokens[i] ), std::string( pToken, lLen ) );
+        CPPUNIT_ASSERT( pToken >= sBuffer.data() && pToken + lLen <= sBuffer.data() + sBuffer.size() );
+    }
+    CPPUNIT_ASSERT( !tokenizer.GetNextTokenView( pToken, lLen ) );
+
+    // The numbers read ahead to look for a reference are queued: in place
+    // when reading from memory, copied when reading from a stream
+    for( int nDevice = 0; nDevice < 2; nDevice++ )
+    {
+        const std::string        sNumbers( "[1 2 3 4 0 R] 7 8 9" );
+        std::istringstream       stream( sNumbers );
+        PdfRefCountedInputDevice numbers( nDevice
+                                          ? new PdfInputDevice( &stream )
+                                          : new PdfBufferInputDevice( sNumbers.data(), sNumbers.size() ) );
+        PdfTokenizer             numberTokenizer( numbers, PdfRefCountedBuffer( 4096 ) );
+        PdfVariant               variant;
+
+        numberTokenizer.GetNextVariant( variant, NULL );
+        CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(4), variant.GetArray().size() );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(3), variant.GetArray()[2].GetNumber() );
+        CPPUNIT_ASSERT( variant.GetArray()[3].GetReference() == PdfReference( 4, 0 ) );
+
+        numberTokenizer.GetNextVariant( variant, NULL );
+        CPPUNIT_ASSERT_EQUAL( static_cast<pdf_int64>(7), variant.GetNumber() );
+
+        for( const char* pszNumber : { "8", "9" } )
+        {
+            CPPUNIT_ASSERT( numberTokenizer.GetNextTokenView( pToken, lLen ) );
+            CPPUNIT_ASSERT_EQUAL( std::string( pszNumber ), std::string( pToken, lLen ) );
+            CPPUNIT_ASSERT_EQUAL( !nDevice, pToken >= sNumbers.data() && pToken < sNumbers.data() + sNumbers.size() );
+        }
+        CPPUNIT_ASSERT( !numberTokenizer.GetNextTokenView( pToken, lLen ) );
+    }
+}
+
+void TokenizerTest::testNumberScanner()
+{
+    std::vector<std::string> tokens = {
+        "0", "-0", "+0", "007", "-", "+", ".", "-.", "1.", ".1", "1.2.3", "1-2", "+-1",
+        "123456789012345678", "-123456789012345678", "1234567890123456789",
+        "0.1", "0.3", "722.5", "123456789.012345", "1234567890.123456",
+        "0.000000000000001", "-0.0", "99999999999999.9",
+    };
+    std::mt19937 rand( 42 );
+    const char   szDigits[] = "0123456789";
+    for( int i = 0; i < 20000; i++ )
+    {
+        // mostly well formed numbers, and some runs of number characters
+        std::string  sToken;
+        const size_t lLen = rand() % 20 + 1;
+        if( rand() % 4 )
+        {
+            if( rand() % 3 == 0 )
+                sToken.push_back( rand() % 2 ? '-' : '+' );
+            const size_t lDot = rand() % 2 ? rand() % (lLen + 1) : lLen + 1;
+            for( size_t j = 0; j < lLen; j++ )
+            {
+                if( j == lDot )
+                    sToken.push_back( '.' );
+                sToken.push_back( szDigits[rand() % 10] );
+            }
+        }
+        else
+        {
+            for( size_t j = 0; j < lLen; j++ )
+                sToken.push_back( "0123456789.+-"[rand() % 13] );
+        }
+        tokens.push_back( sToken );
+    }
+
+    std::istringstream parser;
+    PdfLocaleImbue( parser );
+    for( const std::string & sToken : tokens )
+    {
+        PdfRefCountedInputDevice device( new PdfBufferInputDevice( sToken.data(), sToken.size() ) );
+        PdfTokenizer             tokenizer( device, PdfRefCountedBuffer( 4096 ) );
+        PdfVariant               variant;
+
+        if( sToken.find( '.' ) == std::string::npos )
+        {
+            tokenizer.GetNextVariant( variant, NULL );
+            CPPUNIT_ASSERT_EQUAL_MESSAGE( sToken, static_cast<pdf_int64>(strtol( sToken.c_str(), NULL, 10 )), variant.GetNumber() );
+            continue;
+        }
+
+        double dExpected;
+        parser.clear();
+        parser.str( sToken );
+        if( !(parser >> dExpected) )
+        {
+            CPPUNIT_ASSERT_THROW_MESSAGE( sToken, tokenizer.GetNextVariant( variant, NULL ), PdfError );
+            continue;
+        }
+
+        tokenizer.GetNextVariant( variant, NULL );
+        // exactly the same double, not only a close one
+        const double dReal = variant.GetReal();
+        CPPUNIT_ASSERT_MESSAGE( sToken, memcmp( &dExpected, &dReal, sizeof(double) ) == 0 );
+    }
+}
@@ -47,6 +47,9 @@ class TokenizerTest : public CppUnit::TestFixture
   CPPUNIT_TEST( testComments );
   CPPUNIT_TEST( testDictionary );
   CPPUNIT_TEST( testLocale );
+  CPPUNIT_TEST( testScanner );
+  CPPUNIT_TEST( testTokenView );
+  CPPUNIT_TEST( testNumberScanner );
   CPPUNIT_TEST_SUITE_END();
 
  public:
@@ -68,6 +71,22 @@ class TokenizerTest : public CppUnit::TestFixture
 
   void testLocale();
 
+  /** GetNextToken() scans many bytes at once: it must split the
+   *  sample PDFs and random input as reading byte by byte does.
+   */
+  void testScanner();
+
+  /** GetNextTokenView() hands out tokens in place when reading
+   *  from memory, including the queued ones.
+   */
+  void testTokenView();
+
+  /** Numbers are converted in a single pass: they must have the
+   *  values strtol and a C locale stream give, for any token made of
+   *  digits, signs and dots.
+   */
+  void testNumberScanner();
+
  private:
   void Test( const char* pszString, PoDoFo::EPdfDataType eDataType, const char* pszExpected = NULL );
 
@@ -86,6 +105,19 @@ class TokenizerTest : public CppUnit::TestFixture
    *                   order PdfTokenizer should read them from pszBuffer 
    */
   void TestStreamIsNextToken( const char* pszBuffer, const char* pszTokens[] );
+
+  /** Compare the tokens of a buffer with the ones of the byte by byte tokenizer,
+   *  read from memory and through the read buffer of a stream, with each
+   *  scanner implementation of this build and processor.
+   *
+   *  \param sBuffer the data to split in tokens
+   *  \param lTokenSize the size of the token buffer, which truncates longer tokens
+   */
+  void TestScanner( const std::string & sBuffer, size_t lTokenSize );
+
+  /** Same as above, with the scanner the tokenizers use at the moment
+   */
+  void TestScanner( const std::string & sBuffer, size_t lTokenSize, PoDoFo::EPdfScanner eScanner );
 };
 
 #endif // _TOKENIZER_TEST_H_
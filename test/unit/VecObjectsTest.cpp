@@ -0,0 +1,159 @@
+#include "VecObjectsTest.h"
+
+#include <podofo.h>
+
+#include <map>
+#include <random>
+
+using namespace PoDoFo;
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( VecObjectsTest );
+
+/** Check that vecObjects holds exactly the objects of mapObjects,
+ *  that all of them are found, and that it iterates in order.
+ */
+static void CheckObjects( const PdfVecObjects & vecObjects, const std::map<PdfReference,PdfObject*> & mapObjects )
+{
+    CPPUNIT_ASSERT_EQUAL( mapObjects.size(), vecObjects.GetSize() );
+
+    std::map<PdfReference,PdfObject*>::const_iterator itMap = mapObjects.begin();
+    for( TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it, ++itMap )
+    {
+        CPPUNIT_ASSERT( *it == itMap->second );
+        CPPUNIT_ASSERT( vecObjects.GetObject( itMap->first ) == itMap->second );
+    }
+}
+
+void VecObjectsTest::setUp()
+{
+}
+
+void VecObjectsTest::tearDown()
+{
+}
+
+void VecObjectsTest::testGetObject()
+{
+    PdfVecObjects vecObjects;
+    vecObjects.SetAutoDelete( true );
+
+    PdfObject* pFirst  = vecObjects.CreateObject();
+    PdfObject* pSecond = vecObjects.CreateObject( "Second" );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 1, 0 ) ) == pFirst );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 2, 0 ) ) == pSecond );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 0, 0 ) ) == NULL );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 3, 0 ) ) == NULL );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 2, 1 ) ) == NULL );
+
+    // freed numbers are reused, out of order
+    delete vecObjects.RemoveObject( PdfReference( 1, 0 ) );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 1, 0 ) ) == NULL );
+
+    PdfObject* pReused = vecObjects.CreateObject( "Reused" );
+    CPPUNIT_ASSERT( pReused->Reference() == PdfReference( 1, 0 ) );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 1, 0 ) ) == pReused );
+    CPPUNIT_ASSERT( *vecObjects.begin() == pReused );
+    CPPUNIT_ASSERT( vecObjects.GetBack() == pSecond );
+    CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(1), vecObjects.GetIndex( PdfReference( 2, 0 ) ) );
+
+    PdfObject* pRemoved = vecObjects.RemoveObject( vecObjects.begin() );
+    CPPUNIT_ASSERT( pRemoved == pReused );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 1, 0 ) ) == NULL );
+    delete pRemoved;
+}
+
+void VecObjectsTest::testGenerations()
+{
+    std::map<PdfReference,PdfObject*> mapObjects;
+    PdfVecObjects                     vecObjects;
+    vecObjects.SetAutoDelete( true );
+
+    const PdfReference refs[] = {
+        PdfReference( 5, 2 ), PdfReference( 5, 0 ), PdfReference( 3, 0 ), PdfReference( 5, 1 ),
+        // far beyond the lookup table
+        PdfReference( 8000000, 0 ), PdfReference( 8000000, 3 )
+    };
+    for( const PdfReference & ref : refs )
+    {
+        PdfObject* pObj = new PdfObject( ref, "Generation" );
+        vecObjects.push_back( pObj );
+        mapObjects[ref] = pObj;
+    }
+    CheckObjects( vecObjects, mapObjects );
+
+    // the remaining generations are still found
+    delete vecObjects.RemoveObject( PdfReference( 5, 2 ) );
+    mapObjects.erase( PdfReference( 5, 2 ) );
+    delete vecObjects.RemoveObject( PdfReference( 8000000, 0 ) );
+    mapObjects.erase( PdfReference( 8000000, 0 ) );
+    CheckObjects( vecObjects, mapObjects );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 5, 2 ) ) == NULL );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 8000000, 0 ) ) == NULL );
+}
+
+void VecObjectsTest::testRandomObjects()
+{
+    std::map<PdfReference,PdfObject*> mapObjects;
+    PdfVecObjects                     vecObjects;
+    std::mt19937                      generator( 4242 );
+    vecObjects.SetAutoDelete( true );
+
+    for( int nRound = 0; nRound < 20; nRound++ )
+    {
+        for( int i = 0; i < 500; i++ )
+        {
+            // mostly dense numbers, and a few huge ones
+            const unsigned int nObjNo = generator() % 100 ? generator() % 20000 + 1 : generator() % 8000000 + 1;
+            const PdfReference ref( nObjNo, static_cast<pdf_uint16>(generator() % 3) );
+            if( mapObjects.count( ref ) )
+                continue;
+
+            PdfObject* pObj = new PdfObject( ref, "Random" );
+            vecObjects.push_back( pObj );
+            mapObjects[ref] = pObj;
+        }
+
+        for( int i = 0; i < 100; i++ )
+        {
+            std::map<PdfReference,PdfObject*>::iterator it = mapObjects.lower_bound(
+                PdfReference( generator() % 20000 + 1, 0 ) );
+            if( it == mapObjects.end() )
+                continue;
+
+            CPPUNIT_ASSERT( vecObjects.RemoveObject( it->first, false ) == it->second );
+            delete it->second;
+            mapObjects.erase( it );
+        }
+
+        CheckObjects( vecObjects, mapObjects );
+        for( unsigned int nObjNo = 0; nObjNo <= 20001; nObjNo++ )
+        {
+            const PdfReference ref( nObjNo, 0 );
+            std::map<PdfReference,PdfObject*>::const_iterator it = mapObjects.find( ref );
+            CPPUNIT_ASSERT( vecObjects.GetObject( ref ) == (it == mapObjects.end() ? NULL : it->second) );
+        }
+    }
+}
+
+void VecObjectsTest::testRenumberObjects()
+{
+    PdfVecObjects vecObjects;
+    PdfObject     trailer;
+    vecObjects.SetAutoDelete( true );
+
+    PdfObject* pFar  = new PdfObject( PdfReference( 7000000, 0 ), "Far" );
+    PdfObject* pNear = new PdfObject( PdfReference( 10, 0 ), "Near" );
+    vecObjects.push_back( pFar );
+    vecObjects.push_back( pNear );
+
+    pNear->GetDictionary().AddKey( "Far", pFar->Reference() );
+    trailer.GetDictionary().AddKey( "Root", pNear->Reference() );
+
+    vecObjects.RenumberObjects( &trailer );
+    CPPUNIT_ASSERT( pNear->Reference() == PdfReference( 1, 0 ) );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 1, 0 ) ) == pNear );
+    CPPUNIT_ASSERT( vecObjects.GetObject( PdfReference( 10, 0 ) ) == NULL );
+    for( TCIVecObjects it = vecObjects.begin(); it != vecObjects.end(); ++it )
+        CPPUNIT_ASSERT( vecObjects.GetObject( (*it)->Reference() ) == *it );
+}
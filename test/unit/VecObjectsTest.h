@@ -0,0 +1,38 @@
+#ifndef _VEC_OBJECTS_TEST_H_
+#define _VEC_OBJECTS_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/** This test tests the class PdfVecObjects
+ */
+class VecObjectsTest : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE( VecObjectsTest );
+    CPPUNIT_TEST( testGetObject );
+    CPPUNIT_TEST( testGenerations );
+    CPPUNIT_TEST( testRandomObjects );
+    CPPUNIT_TEST( testRenumberObjects );
+    CPPUNIT_TEST_SUITE_END();
+
+ public:
+    void setUp();
+    void tearDown();
+
+    void testGetObject();
+
+    /** Objects with the same number and another generation
+     *  are found as well
+     */
+    void testGenerations();
+
+    /** Objects inserted and removed in random order, with some
+     *  huge object numbers, are found and iterated in order
+     */
+    void testRandomObjects();
+
+    /** Objects are found by their new reference after renumbering
+     */
+    void testRenumberObjects();
+};
+
+#endif // _VEC_OBJECTS_TEST_H_
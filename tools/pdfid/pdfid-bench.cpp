@@ -0,0 +1,1266 @@
+#include <podofo-base.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+using namespace PoDoFo;
+
+// each benchmark prints one JSON object per line, so that results
+// can be collected and compared over time
+
+using bench_clock = std::chrono::steady_clock;
+
+static double seconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// the largest resident set size of the process so far, in kilobytes
+static long peak_rss_kb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return -1;
+    return usage.ru_maxrss;
+}
+
+static std::vector<std::string> sorted_keys(size_t size)
+{
+    std::vector<std::string> keys;
+    keys.reserve(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        char key[32];
+        snprintf(key, sizeof(key), "Key%09zu", i);
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+void bench_rank_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " rank [<key_count>...]" << std::endl;
+}
+
+int bench_rank(const char *program_name, int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        char *end;
+        sizes.push_back(strtoul(argv[i], &end, 10));
+        if (*end || !sizes.back()) {
+            bench_rank_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (sizes.empty())
+        sizes = {1000, 10000, 100000};
+
+    gmp_randclass rand(gmp_randinit_default);
+    rand.seed(42);
+
+    for (size_t size : sizes)
+    {
+        const auto id = sorted_keys(size);
+        const size_t available_bits = size_available_bits(size);
+
+        // repeat small sizes so that timings are meaningful
+        const size_t rounds = std::max<size_t>(1, 100000 / size);
+
+        // the encoder unranks payload bits, the decoder ranks them back
+        std::vector<mpz_class> ranks;
+        for (size_t i = 0; i < rounds; i++)
+            ranks.push_back(rand.get_z_bits(available_bits));
+
+        std::vector<std::vector<std::string>> perms(rounds, id);
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < rounds; i++)
+            unrank1(perms[i], ranks[i]);
+        double unrank_seconds = seconds_since(start) / rounds;
+
+        std::vector<mpz_class> results(rounds);
+        start = bench_clock::now();
+        for (size_t i = 0; i < rounds; i++)
+            results[i] = rank1(id, perms[i]);
+        double rank_seconds = seconds_since(start) / rounds;
+
+        if (results != ranks) {
+            std::cerr << "rank mismatch for " << size << " keys" << std::endl;
+            return 1;
+        }
+
+        std::cout << "{\"benchmark\": \"rank\""
+                  << ", \"keys\": " << size
+                  << ", \"bits\": " << available_bits
+                  << ", \"unrank_seconds\": " << unrank_seconds
+                  << ", \"rank_seconds\": " << rank_seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_input_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " input <input_pdf>..." << std::endl;
+}
+
+// parse the whole file and count the payload bits, as `pdfid read` does
+static double time_parse(const PdfRefCountedInputDevice &device)
+{
+    std::ostringstream output;
+    bit_ostream o_bitstream(output);
+    PdfVecObjects objects;
+    PdfParser parser(&objects);
+
+    device.Device()->dictdecode_stream = &o_bitstream;
+    auto start = bench_clock::now();
+    parser.ParseFile(device, false);
+    o_bitstream.flush();
+    return seconds_since(start);
+}
+
+int bench_input(const char *program_name, int argc, char *argv[])
+{
+    if (argc < 2) {
+        bench_input_help(program_name, std::cerr);
+        return 1;
+    }
+
+    // keep the best of a few rounds, so that both devices
+    // get a warm page cache
+    const int rounds = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *path = argv[i];
+        double stream_seconds = 0, mapped_seconds = 0;
+        size_t size = 0;
+
+        try {
+            for (int round = 0; round < rounds; round++)
+            {
+                std::ifstream file(path, std::ifstream::in);
+                if (!file) {
+                    std::cerr << "failed to open file `" << path << "'" << std::endl;
+                    return 1;
+                }
+                PdfRefCountedInputDevice stream_device(new PdfInputDevice(&file));
+                double seconds = time_parse(stream_device);
+                if (!round || seconds < stream_seconds)
+                    stream_seconds = seconds;
+
+                PdfMappedInputDevice *mapped = new PdfMappedInputDevice(path);
+                PdfRefCountedInputDevice mapped_device(mapped);
+                size = mapped->GetLength();
+                seconds = time_parse(mapped_device);
+                if (!round || seconds < mapped_seconds)
+                    mapped_seconds = seconds;
+            }
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        const double megabytes = size / 1e6;
+        std::cout << "{\"benchmark\": \"input\""
+                  << ", \"file\": \"" << path << "\""
+                  << ", \"bytes\": " << size
+                  << ", \"stream_seconds\": " << stream_seconds
+                  << ", \"stream_mb_per_second\": " << megabytes / stream_seconds
+                  << ", \"mapped_seconds\": " << mapped_seconds
+                  << ", \"mapped_mb_per_second\": " << megabytes / mapped_seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_names_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " names [-j <threads>] [-n <copies>]" << std::endl;
+}
+
+// copy and destroy the same name on every thread, as dictionaries
+// do with their keys when objects are loaded or written in parallel
+static double time_name_copies(const PdfName &name, unsigned int threads, size_t copies)
+{
+    std::vector<std::thread> workers;
+    std::vector<size_t> lengths(threads);
+
+    auto start = bench_clock::now();
+    for (unsigned int t = 0; t < threads; t++)
+        workers.emplace_back([&name, &lengths, copies, t]() {
+            size_t length = 0;
+            for (size_t i = 0; i < copies; i++) {
+                PdfName copy(name);
+                length += copy.GetLength();
+            }
+            lengths[t] = length;
+        });
+    for (std::thread &worker : workers)
+        worker.join();
+    return seconds_since(start);
+}
+
+int bench_names(const char *program_name, int argc, char *argv[])
+{
+    unsigned long threads = std::thread::hardware_concurrency();
+    unsigned long copies = 10000000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[++i] : "";
+        char *end;
+        const unsigned long number = strtoul(value, &end, 10);
+        if ((strcmp(option, "-j") != 0 && strcmp(option, "-n") != 0) || !*value || *end || !number) {
+            bench_names_help(program_name, std::cerr);
+            return 1;
+        }
+        (option[1] == 'j' ? threads : copies) = number;
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    // a key common enough to be immortal, and one which is reference counted
+    const PdfName names[] = {PdfName::KeyType, PdfName("BenchCountedName")};
+    const int rounds = 3;
+
+    for (const PdfName &name : names)
+    {
+        double serial_seconds = 0, parallel_seconds = 0;
+        for (int round = 0; round < rounds; round++)
+        {
+            double seconds = time_name_copies(name, 1, copies);
+            if (!round || seconds < serial_seconds)
+                serial_seconds = seconds;
+
+            seconds = time_name_copies(name, threads, copies);
+            if (!round || seconds < parallel_seconds)
+                parallel_seconds = seconds;
+        }
+
+        std::cout << "{\"benchmark\": \"names\""
+                  << ", \"name\": \"" << name.GetName() << "\""
+                  << ", \"threads\": " << threads
+                  << ", \"copies_per_thread\": " << copies
+                  << ", \"serial_ns_per_copy\": " << serial_seconds * 1e9 / copies
+                  << ", \"parallel_ns_per_copy\": " << parallel_seconds * 1e9 / copies
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_load_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " load [-j <threads>] <input_pdf>..." << std::endl;
+}
+
+// load every object of a mapped file, without decoding any payload
+static double time_load(const char *path, unsigned int threads, size_t *objects)
+{
+    PdfRefCountedInputDevice device(new PdfMappedInputDevice(path));
+    PdfVecObjects vecObjects;
+    PdfParser parser(&vecObjects);
+
+    vecObjects.SetAutoDelete(true);
+    parser.SetLoadThreads(threads);
+    auto start = bench_clock::now();
+    parser.ParseFile(device, false);
+    const double seconds = seconds_since(start);
+    *objects = vecObjects.GetSize();
+    return seconds;
+}
+
+int bench_load(const char *program_name, int argc, char *argv[])
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+        char *end;
+        threads = strtoul(argv[2], &end, 10);
+        if (*end != '\0' || threads < 1) {
+            bench_load_help(program_name, std::cerr);
+            return 1;
+        }
+        first = 3;
+    }
+
+    if (first >= argc) {
+        bench_load_help(program_name, std::cerr);
+        return 1;
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    const int rounds = 3;
+
+    for (int i = first; i < argc; i++)
+    {
+        const char *path = argv[i];
+        double serial_seconds = 0, parallel_seconds = 0;
+        size_t objects = 0, size = 0;
+
+        try {
+            size = PdfMappedInputDevice(path).GetLength();
+            for (int round = 0; round < rounds; round++)
+            {
+                double seconds = time_load(path, 0, &objects);
+                if (!round || seconds < serial_seconds)
+                    serial_seconds = seconds;
+
+                seconds = time_load(path, threads, &objects);
+                if (!round || seconds < parallel_seconds)
+                    parallel_seconds = seconds;
+            }
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        const double megabytes = size / 1e6;
+        std::cout << "{\"benchmark\": \"load\""
+                  << ", \"file\": \"" << path << "\""
+                  << ", \"bytes\": " << size
+                  << ", \"objects\": " << objects
+                  << ", \"threads\": " << threads
+                  << ", \"serial_seconds\": " << serial_seconds
+                  << ", \"serial_mb_per_second\": " << megabytes / serial_seconds
+                  << ", \"parallel_seconds\": " << parallel_seconds
+                  << ", \"parallel_mb_per_second\": " << megabytes / parallel_seconds
+                  << ", \"speedup\": " << serial_seconds / parallel_seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_tokenize_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " tokenize <input_pdf>..." << std::endl;
+}
+
+// split the whole file in tokens, as the parser does while reading objects.
+// Stream data gets split too, which makes this a worst case for the lexer.
+// The parser reads views of the tokens, which are only copied when needed
+static double time_tokenize(const PdfRefCountedInputDevice &device, bool view, size_t *tokens)
+{
+    PdfRefCountedBuffer buffer(4096);
+    PdfTokenizer tokenizer(device, buffer);
+    const char *token;
+    size_t length;
+
+    *tokens = 0;
+    auto start = bench_clock::now();
+    if (view) {
+        while (tokenizer.GetNextTokenView(token, length))
+            ++*tokens;
+    } else {
+        while (tokenizer.GetNextToken(token))
+            ++*tokens;
+    }
+    return seconds_since(start);
+}
+
+int bench_tokenize(const char *program_name, int argc, char *argv[])
+{
+    if (argc < 2) {
+        bench_tokenize_help(program_name, std::cerr);
+        return 1;
+    }
+
+    const int rounds = 3;
+    // each device is read with GetNextToken(), and the mapped file
+    // with GetNextTokenView() too
+    const char *devices[] = {"file", "stream", "mapped", "mapped_view"};
+    const int device_count = sizeof(devices) / sizeof(devices[0]);
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *path = argv[i];
+        double seconds[device_count] = {0, 0, 0, 0};
+        size_t size = 0, tokens = 0;
+
+        try {
+            for (int round = 0; round < rounds; round++)
+            {
+                std::ifstream file(path, std::ifstream::binary);
+                if (!file) {
+                    std::cerr << "failed to open file `" << path << "'" << std::endl;
+                    return 1;
+                }
+
+                PdfMappedInputDevice *mapped = new PdfMappedInputDevice(path);
+                size = mapped->GetLength();
+
+                PdfRefCountedInputDevice device[device_count] = {
+                    PdfRefCountedInputDevice(path, "rb"),
+                    PdfRefCountedInputDevice(new PdfInputDevice(&file)),
+                    PdfRefCountedInputDevice(mapped),
+                    PdfRefCountedInputDevice(new PdfMappedInputDevice(path)),
+                };
+                for (int d = 0; d < device_count; d++)
+                {
+                    const double elapsed = time_tokenize(device[d], d == 3, &tokens);
+                    if (!round || elapsed < seconds[d])
+                        seconds[d] = elapsed;
+                }
+            }
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        const double megabytes = size / 1e6;
+        std::cout << "{\"benchmark\": \"tokenize\""
+                  << ", \"file\": \"" << path << "\""
+                  << ", \"bytes\": " << size
+                  << ", \"tokens\": " << tokens;
+        for (int d = 0; d < device_count; d++)
+            std::cout << ", \"" << devices[d] << "_seconds\": " << seconds[d]
+                      << ", \"" << devices[d] << "_mb_per_second\": " << megabytes / seconds[d];
+        std::cout << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_numbers_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " numbers [<count>...]" << std::endl;
+}
+
+// parses number-heavy data from memory, as found in fonts and object
+// streams: a /Widths array of integers and reals, a /Kids array of
+// references, and the object number and offset pairs heading object
+// streams, which are read with GetNextNumber()
+int bench_numbers(const char *program_name, int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        char *end;
+        sizes.push_back(strtoul(argv[i], &end, 10));
+        if (*end || !sizes.back()) {
+            bench_numbers_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (sizes.empty())
+        sizes = {100000, 1000000};
+
+    std::mt19937 rand(42);
+
+    for (size_t size : sizes)
+    {
+        std::string widths = "[", kids = "[", header;
+        pdf_int64 widths_sum = 0, header_sum = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            const pdf_int64 width = rand() % 2000;
+            widths_sum += width;
+            widths += std::to_string(width);
+            if (rand() % 4 == 0)
+                widths += "." + std::to_string(rand() % 1000);
+            widths += ' ';
+
+            kids += std::to_string(i + 1) + " 0 R ";
+
+            header_sum += static_cast<pdf_int64>(i) * 100;
+            header += std::to_string(i + 1) + ' ' + std::to_string(i * 100) + ' ';
+        }
+        widths += ']';
+        kids += ']';
+
+        double seconds[3];
+        const std::string *inputs[3] = {&widths, &kids, &header};
+        const char *names[3] = {"widths", "kids", "header"};
+        try {
+            for (int i = 0; i < 3; i++)
+            {
+                PdfRefCountedInputDevice device(new PdfBufferInputDevice(inputs[i]->data(), inputs[i]->size()));
+                PdfTokenizer tokenizer(device, PdfRefCountedBuffer(4096));
+                PdfVariant variant;
+                pdf_int64 sum = 0, expected = 0;
+
+                auto start = bench_clock::now();
+                if (i < 2) {
+                    tokenizer.GetNextVariant(variant, NULL);
+                } else {
+                    for (size_t j = 0; j < size; j++)
+                    {
+                        tokenizer.GetNextNumber();
+                        sum += tokenizer.GetNextNumber();
+                    }
+                }
+                seconds[i] = seconds_since(start);
+
+                if (i == 0) {
+                    for (const PdfObject &width : variant.GetArray())
+                        sum += static_cast<pdf_int64>(width.IsReal() ? width.GetReal() : width.GetNumber());
+                    expected = widths_sum;
+                } else if (i == 1) {
+                    sum = variant.GetArray().back().GetReference().ObjectNumber();
+                    expected = static_cast<pdf_int64>(size);
+                } else {
+                    expected = header_sum;
+                }
+                if (sum != expected) {
+                    std::cerr << names[i] << " parsed wrongly for " << size << " numbers" << std::endl;
+                    return 1;
+                }
+            }
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        std::cout << "{\"benchmark\": \"numbers\""
+                  << ", \"numbers\": " << size;
+        for (int i = 0; i < 3; i++)
+            std::cout << ", \"" << names[i] << "_seconds\": " << seconds[i]
+                      << ", \"" << names[i] << "_numbers_per_second\": " << size / seconds[i];
+        std::cout << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_objects_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " objects [<count>...]" << std::endl;
+}
+
+// looks up every object of a PdfVecObjects by reference, as walking a
+// document does, after inserting them in order and in random order
+int bench_objects(const char *program_name, int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        char *end;
+        sizes.push_back(strtoul(argv[i], &end, 10));
+        if (*end || !sizes.back()) {
+            bench_objects_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (sizes.empty())
+        sizes = {1000000};
+
+    std::mt19937 rand(42);
+
+    for (size_t size : sizes)
+    {
+        std::vector<PdfReference> refs;
+        for (size_t i = 0; i < size; i++)
+            refs.push_back(PdfReference(static_cast<unsigned int>(i + 1), 0));
+
+        std::vector<PdfReference> shuffled(refs);
+        std::shuffle(shuffled.begin(), shuffled.end(), rand);
+
+        // as the parser does, and as reading object streams does
+        double ordered_seconds, shuffled_seconds;
+        PdfVecObjects objects, shuffled_objects;
+        objects.SetAutoDelete(true);
+        shuffled_objects.SetAutoDelete(true);
+
+        auto start = bench_clock::now();
+        for (const PdfReference &ref : refs)
+            objects.push_back(new PdfObject(ref, PdfVariant()));
+        ordered_seconds = seconds_since(start);
+
+        start = bench_clock::now();
+        for (const PdfReference &ref : shuffled)
+            shuffled_objects.push_back(new PdfObject(ref, PdfVariant()));
+        // including the time to sort them, if that is done lazily
+        shuffled_objects.begin();
+        shuffled_seconds = seconds_since(start);
+
+        size_t found = 0;
+        start = bench_clock::now();
+        for (const PdfReference &ref : refs)
+            found += objects.GetObject(ref) != NULL;
+        const double sequential_seconds = seconds_since(start);
+
+        start = bench_clock::now();
+        for (const PdfReference &ref : shuffled)
+            found += objects.GetObject(ref) != NULL;
+        const double random_seconds = seconds_since(start);
+
+        if (found != 2 * size) {
+            std::cerr << "objects were not found" << std::endl;
+            return 1;
+        }
+
+        std::cout << "{\"benchmark\": \"objects\""
+                  << ", \"objects\": " << size
+                  << ", \"ordered_insert_per_second\": " << size / ordered_seconds
+                  << ", \"shuffled_insert_per_second\": " << size / shuffled_seconds
+                  << ", \"sequential_lookup_per_second\": " << size / sequential_seconds
+                  << ", \"random_lookup_per_second\": " << size / random_seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_objstm_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " objstm [-n <objects_per_stream>] <input_pdf>..." << std::endl;
+}
+
+// write a whole file again with the given write mode, and a XRef
+// stream if asked. The file is parsed again for each write, as
+// writing a XRef stream adds an object to the document
+static double time_rewrite(const char *path, EPdfWriteMode mode, bool xref_stream,
+                           unsigned int stream_size, size_t *bytes)
+{
+    PdfRefCountedInputDevice device(new PdfMappedInputDevice(path));
+    PdfVecObjects vecObjects;
+    PdfParser parser(&vecObjects);
+
+    vecObjects.SetAutoDelete(true);
+    parser.ParseFile(device, false);
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice output(&buffer);
+    PdfWriter writer(&parser);
+    writer.SetWriteMode(mode);
+    writer.SetUseXRefStream(xref_stream);
+    writer.SetObjectStreamSize(stream_size);
+
+    auto start = bench_clock::now();
+    writer.Write(&output);
+    const double seconds = seconds_since(start);
+    *bytes = output.GetLength();
+    return seconds;
+}
+
+int bench_objstm(const char *program_name, int argc, char *argv[])
+{
+    unsigned int stream_size = 100;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        char *end;
+        stream_size = strtoul(argv[2], &end, 10);
+        if (*end != '\0' || stream_size < 1) {
+            bench_objstm_help(program_name, std::cerr);
+            return 1;
+        }
+        first = 3;
+    }
+
+    if (first >= argc) {
+        bench_objstm_help(program_name, std::cerr);
+        return 1;
+    }
+
+    const EPdfWriteMode packed = static_cast<EPdfWriteMode>(ePdfWriteMode_Compact | ePdfWriteMode_ObjectStreams);
+
+    for (int i = first; i < argc; i++)
+    {
+        const char *path = argv[i];
+        size_t table_bytes, xref_stream_bytes, packed_bytes;
+        double table_seconds, xref_stream_seconds, packed_seconds;
+
+        try {
+            table_seconds = time_rewrite(path, ePdfWriteMode_Compact, false, stream_size, &table_bytes);
+            xref_stream_seconds = time_rewrite(path, ePdfWriteMode_Compact, true, stream_size, &xref_stream_bytes);
+            packed_seconds = time_rewrite(path, packed, true, stream_size, &packed_bytes);
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        std::cout << "{\"benchmark\": \"objstm\""
+                  << ", \"file\": \"" << path << "\""
+                  << ", \"objects_per_stream\": " << stream_size
+                  << ", \"table_bytes\": " << table_bytes
+                  << ", \"table_seconds\": " << table_seconds
+                  << ", \"xref_stream_bytes\": " << xref_stream_bytes
+                  << ", \"xref_stream_seconds\": " << xref_stream_seconds
+                  << ", \"packed_bytes\": " << packed_bytes
+                  << ", \"packed_seconds\": " << packed_seconds
+                  << ", \"packed_ratio\": " << static_cast<double>(packed_bytes) / table_bytes
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_compress_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " compress [-j <threads>] [-n <images>] [-s <width>] [-m <budget_mb>]" << std::endl;
+}
+
+// a document of uncompressed RGB images, noisy bands of colors
+// which Flate shrinks about as much as scanned pages
+static void image_document(PdfVecObjects &vecObjects, PdfObject &trailer, size_t images, size_t width)
+{
+    std::mt19937 rand(42);
+    std::vector<char> pixels(width * width * 3);
+
+    PdfObject *catalog = vecObjects.CreateObject("Catalog");
+    PdfArray kids;
+    for (size_t i = 0; i < images; i++)
+    {
+        for (size_t y = 0; y < width; y++)
+            for (size_t x = 0; x < width; x++)
+            {
+                char *pixel = &pixels[(y * width + x) * 3];
+                pixel[0] = static_cast<char>(x / 8 * 4 + i);
+                pixel[1] = static_cast<char>(y / 8 * 4 + rand() % 2);
+                pixel[2] = static_cast<char>((x + y) / 16 * 8);
+            }
+
+        PdfObject *image = vecObjects.CreateObject("XObject");
+        image->GetDictionary().AddKey("Subtype", PdfName("Image"));
+        image->GetDictionary().AddKey("Width", static_cast<pdf_int64>(width));
+        image->GetDictionary().AddKey("Height", static_cast<pdf_int64>(width));
+        image->GetDictionary().AddKey("ColorSpace", PdfName("DeviceRGB"));
+        image->GetDictionary().AddKey("BitsPerComponent", static_cast<pdf_int64>(8));
+        image->GetStream()->Set(pixels.data(), pixels.size(), TVecFilters());
+        kids.push_back(image->Reference());
+    }
+    catalog->GetDictionary().AddKey("Kids", kids);
+    trailer.GetDictionary().AddKey("Root", catalog->Reference());
+
+    PdfObject *info = vecObjects.CreateObject();
+    info->GetDictionary().AddKey("Producer", PdfString("pdfid-bench"));
+    trailer.GetDictionary().AddKey("Info", info->Reference());
+}
+
+// write a new image document, compressing its streams on the given threads
+static double time_compress(size_t images, size_t width, unsigned int threads, size_t budget,
+                            const PdfFlateParameters &parameters, std::string *output)
+{
+    PdfVecObjects vecObjects;
+    PdfObject trailer;
+    vecObjects.SetAutoDelete(true);
+    image_document(vecObjects, trailer, images, width);
+
+    PdfRefCountedBuffer buffer;
+    PdfOutputDevice device(&buffer);
+    PdfWriter writer(&vecObjects, &trailer);
+    writer.SetWriteMode(static_cast<EPdfWriteMode>(ePdfWriteMode_Compact | ePdfWriteMode_CompressStreams));
+    writer.SetWriteThreads(threads);
+    writer.SetWriteMemoryBudget(budget);
+    writer.SetFlateParameters(parameters);
+
+    auto start = bench_clock::now();
+    writer.Write(&device);
+    const double seconds = seconds_since(start);
+    output->assign(buffer.GetBuffer(), device.GetLength());
+    return seconds;
+}
+
+int bench_compress(const char *program_name, int argc, char *argv[])
+{
+    unsigned int threads = std::thread::hardware_concurrency();
+    size_t images = 100, width = 512, budget_mb = 64;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        const char *value = i + 1 < argc ? argv[++i] : "";
+        char *end;
+        const unsigned long number = strtoul(value, &end, 10);
+        bool valid = *value && !*end;
+        if (strcmp(option, "-j") == 0)
+            threads = number;
+        else if (strcmp(option, "-n") == 0)
+            images = number;
+        else if (strcmp(option, "-s") == 0)
+            width = number;
+        else if (strcmp(option, "-m") == 0)
+            budget_mb = number;
+        else
+            valid = false;
+
+        if (!valid || (strcmp(option, "-m") != 0 && !number)) {
+            bench_compress_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (threads < 1)
+        threads = 1;
+
+    const int rounds = 3;
+    double serial_seconds = 0, parallel_seconds = 0;
+    std::string serial, parallel;
+
+    try {
+        for (int round = 0; round < rounds; round++)
+        {
+            double seconds = time_compress(images, width, 0, budget_mb << 20, PdfFlateParameters(), &serial);
+            if (!round || seconds < serial_seconds)
+                serial_seconds = seconds;
+
+            seconds = time_compress(images, width, threads, budget_mb << 20, PdfFlateParameters(), &parallel);
+            if (!round || seconds < parallel_seconds)
+                parallel_seconds = seconds;
+        }
+    } catch (const PdfError &e) {
+        e.PrintErrorMsg();
+        return 1;
+    }
+
+    const double megabytes = images * width * width * 3 / 1e6;
+    std::cout << "{\"benchmark\": \"compress\""
+              << ", \"images\": " << images
+              << ", \"width\": " << width
+              << ", \"raw_bytes\": " << images * width * width * 3
+              << ", \"output_bytes\": " << serial.size()
+              << ", \"threads\": " << threads
+              << ", \"budget_mb\": " << budget_mb
+              << ", \"serial_seconds\": " << serial_seconds
+              << ", \"serial_mb_per_second\": " << megabytes / serial_seconds
+              << ", \"parallel_seconds\": " << parallel_seconds
+              << ", \"parallel_mb_per_second\": " << megabytes / parallel_seconds
+              << ", \"speedup\": " << serial_seconds / parallel_seconds
+              << ", \"identical\": " << (serial == parallel ? "true" : "false")
+              << ", \"peak_rss_kb\": " << peak_rss_kb()
+              << "}" << std::endl;
+    return 0;
+}
+
+void bench_flate_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " flate [-n <images>] [-s <width>] [<level>...]" << std::endl;
+}
+
+int bench_flate(const char *program_name, int argc, char *argv[])
+{
+    size_t images = 20, width = 512;
+    std::vector<int> levels;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        char *end;
+        if (strcmp(option, "-n") == 0 || strcmp(option, "-s") == 0)
+        {
+            const char *value = i + 1 < argc ? argv[++i] : "";
+            const unsigned long number = strtoul(value, &end, 10);
+            if (!*value || *end || !number) {
+                bench_flate_help(program_name, std::cerr);
+                return 1;
+            }
+            (option[1] == 'n' ? images : width) = number;
+            continue;
+        }
+
+        const long level = strtol(option, &end, 10);
+        if (!*option || *end || level < -1 || level > 9) {
+            bench_flate_help(program_name, std::cerr);
+            return 1;
+        }
+        levels.push_back(level);
+    }
+
+    std::vector<PdfFlateParameters> settings;
+    if (levels.empty())
+    {
+        for (int level = 0; level <= 9; level++)
+            settings.push_back(PdfFlateParameters(level));
+        settings.push_back(PdfFlateParameters(-1, ePdfFlateStrategy_RLE));
+        settings.push_back(PdfFlateParameters(-1, ePdfFlateStrategy_HuffmanOnly));
+    }
+    else
+        for (int level : levels)
+            settings.push_back(PdfFlateParameters(level));
+
+    const char *strategies[] = {"default", "filtered", "huffman_only", "rle", "fixed"};
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    const char *backend = "libdeflate";
+#else
+    const char *backend = "zlib";
+#endif // PODOFO_HAVE_LIBDEFLATE
+
+    const size_t raw_bytes = images * width * width * 3;
+    for (const PdfFlateParameters &parameters : settings)
+    {
+        const int rounds = 3;
+        double seconds = 0;
+        std::string output;
+
+        // serially, so that only the compression is measured
+        try {
+            for (int round = 0; round < rounds; round++)
+            {
+                const double round_seconds = time_compress(images, width, 0, 0, parameters, &output);
+                if (!round || round_seconds < seconds)
+                    seconds = round_seconds;
+            }
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+
+        std::cout << "{\"benchmark\": \"flate\""
+                  << ", \"backend\": \"" << backend << "\""
+                  << ", \"level\": " << parameters.m_nLevel
+                  << ", \"strategy\": \"" << strategies[parameters.m_eStrategy] << "\""
+                  << ", \"raw_bytes\": " << raw_bytes
+                  << ", \"output_bytes\": " << output.size()
+                  << ", \"ratio\": " << static_cast<double>(output.size()) / raw_bytes
+                  << ", \"seconds\": " << seconds
+                  << ", \"mb_per_second\": " << raw_bytes / 1e6 / seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_bits_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " bits [<payload_megabytes>...]" << std::endl;
+}
+
+// moves a payload through bit_istream and bit_ostream in chunks
+// the size of dictionary capacities, as writing and reading do
+int bench_bits(const char *program_name, int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; i++)
+    {
+        char *end;
+        sizes.push_back(strtoul(argv[i], &end, 10));
+        if (*end || !sizes.back()) {
+            bench_bits_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (sizes.empty())
+        sizes = {1, 16};
+
+    std::mt19937 rand(42);
+    std::uniform_int_distribution<size_t> keys(2, 40);
+
+    for (size_t size : sizes)
+    {
+        std::string payload;
+        for (size_t i = 0; i < size * 1000000; i++)
+            payload.push_back(static_cast<char>(rand()));
+
+        std::vector<size_t> chunks;
+        for (size_t bits = 0; bits < payload.size() * 8; bits += chunks.back())
+            chunks.push_back(size_available_bits(keys(rand)));
+
+        std::istringstream input(payload);
+        bit_istream i_bitstream(&input);
+        std::vector<mpz_class> numbers(chunks.size());
+        auto start = bench_clock::now();
+        for (size_t i = 0; i < chunks.size(); i++)
+            if (chunks[i] <= 64)
+                numbers[i] = mpz_from_word(bit_istream_pull_word(i_bitstream, chunks[i]));
+            else
+                numbers[i] = bit_istream_pull_mpz(i_bitstream, chunks[i]);
+        const double pull_seconds = seconds_since(start);
+
+        std::ostringstream output;
+        bit_ostream o_bitstream(output);
+        start = bench_clock::now();
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            o_bitstream.push(i, std::move(numbers[i]), chunks[i]);
+            o_bitstream.advance(i + 1);
+        }
+        o_bitstream.flush();
+        const double push_seconds = seconds_since(start);
+
+        if (output.str().compare(0, payload.size(), payload)) {
+            std::cerr << "payload mismatch for " << size << " MB" << std::endl;
+            return 1;
+        }
+
+        const double megabytes = payload.size() / 1e6;
+        std::cout << "{\"benchmark\": \"bits\""
+                  << ", \"bytes\": " << payload.size()
+                  << ", \"chunks\": " << chunks.size()
+                  << ", \"pull_seconds\": " << pull_seconds
+                  << ", \"pull_mb_per_second\": " << megabytes / pull_seconds
+                  << ", \"push_seconds\": " << push_seconds
+                  << ", \"push_mb_per_second\": " << megabytes / push_seconds
+                  << "}" << std::endl;
+    }
+    return 0;
+}
+
+void bench_codec_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " codec [-n <objects>] [-k <min_keys>:<max_keys>]"
+         " [-d uniform|geometric] [-v <names>] [-j <threads>] [-f]" << std::endl;
+}
+
+// a document holding objects dictionaries, with a number of keys drawn
+// from a distribution between min_keys and max_keys, and key names drawn
+// from a vocabulary of names
+static std::string synthetic_carrier(size_t objects, size_t min_keys, size_t max_keys, bool geometric,
+                                     size_t names)
+{
+    std::mt19937 rand(42);
+    std::uniform_int_distribution<size_t> uniform_keys(min_keys, max_keys);
+    // most dictionaries are small, a few get large
+    std::geometric_distribution<size_t> extra_keys(1.0 / (1.0 + (max_keys - min_keys) / 4.0));
+
+    PdfVecObjects vecObjects;
+    PdfObject trailer;
+    vecObjects.SetAutoDelete(true);
+
+    PdfObject *catalog = vecObjects.CreateObject("Catalog");
+    PdfArray kids;
+    for (size_t i = 0; i < objects; i++)
+    {
+        size_t keys = geometric
+            ? std::min(max_keys, min_keys + extra_keys(rand))
+            : uniform_keys(rand);
+
+        PdfObject *object = vecObjects.CreateObject();
+        for (size_t j = 0; j < keys; j++)
+        {
+            char key[32];
+            snprintf(key, sizeof(key), "K%zu", static_cast<size_t>(rand() % names));
+            object->GetDictionary().AddKey(key, static_cast<pdf_int64>(j));
+        }
+        kids.push_back(object->Reference());
+    }
+    catalog->GetDictionary().AddKey("Kids", kids);
+    trailer.GetDictionary().AddKey("Root", catalog->Reference());
+
+    std::ostringstream output;
+    PdfOutputDevice device(&output);
+    PdfWriter writer(&vecObjects, &trailer);
+    writer.SetWriteMode(ePdfWriteMode_Compact);
+    writer.Write(&device);
+    return output.str();
+}
+
+int bench_codec(const char *program_name, int argc, char *argv[])
+{
+    std::vector<size_t> sizes;
+    size_t min_keys = 2, max_keys = 20;
+    size_t names = 100000;
+    bool geometric = false;
+    PdfIdCodec codec;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *option = argv[i];
+        if (strcmp(option, "-f") == 0) {
+            codec.SetFramed(true);
+            continue;
+        }
+
+        const char *value = i + 1 < argc ? argv[++i] : "";
+        char *end;
+        bool valid;
+        if (strcmp(option, "-n") == 0) {
+            sizes.push_back(strtoul(value, &end, 10));
+            valid = !*end && sizes.back();
+        } else if (strcmp(option, "-k") == 0) {
+            min_keys = max_keys = strtoul(value, &end, 10);
+            if (*end == ':')
+                max_keys = strtoul(end + 1, &end, 10);
+            valid = !*end && min_keys <= max_keys;
+        } else if (strcmp(option, "-d") == 0) {
+            geometric = strcmp(value, "geometric") == 0;
+            valid = geometric || strcmp(value, "uniform") == 0;
+        } else if (strcmp(option, "-v") == 0) {
+            names = strtoul(value, &end, 10);
+            valid = !*end && names;
+        } else if (strcmp(option, "-j") == 0) {
+            codec.SetThreads(strtoul(value, &end, 10));
+            valid = !*end;
+        } else
+            valid = false;
+
+        if (!valid || !*value) {
+            bench_codec_help(program_name, std::cerr);
+            return 1;
+        }
+    }
+
+    if (sizes.empty())
+        sizes = {1000, 10000, 50000};
+
+    for (size_t size : sizes)
+    {
+        const std::string carrier = synthetic_carrier(size, min_keys, max_keys, geometric, names);
+        const double megabytes = carrier.size() / 1e6;
+
+        try {
+            auto start = bench_clock::now();
+            const size_t capacity = codec.GetCapacity(carrier.data(), carrier.size());
+            const double capacity_seconds = seconds_since(start);
+
+            // fill the whole capacity, so that every dictionary carries data
+            std::mt19937 rand(42);
+            std::string payload;
+            for (size_t i = 0; i < capacity; i++)
+                payload.push_back(static_cast<char>(rand()));
+
+            std::ostringstream output;
+            start = bench_clock::now();
+            codec.Encode(carrier.data(), carrier.size(), payload.data(), payload.size(), output);
+            const double write_seconds = seconds_since(start);
+            const std::string document = output.str();
+
+            start = bench_clock::now();
+            const std::string decoded = codec.Decode(document.data(), document.size());
+            const double read_seconds = seconds_since(start);
+
+            if (decoded.compare(0, payload.size(), payload)) {
+                std::cerr << "payload mismatch for " << size << " objects" << std::endl;
+                return 1;
+            }
+
+            const double bits = capacity * 8.0;
+            std::cout << "{\"benchmark\": \"codec\""
+                      << ", \"objects\": " << size
+                      << ", \"min_keys\": " << min_keys
+                      << ", \"max_keys\": " << max_keys
+                      << ", \"distribution\": \"" << (geometric ? "geometric" : "uniform") << "\""
+                      << ", \"names\": " << names
+                      << ", \"threads\": " << codec.GetThreads()
+                      << ", \"framed\": " << (codec.IsFramed() ? "true" : "false")
+                      << ", \"bytes\": " << carrier.size()
+                      << ", \"capacity_bits\": " << capacity * 8
+                      << ", \"capacity_seconds\": " << capacity_seconds
+                      << ", \"capacity_mb_per_second\": " << megabytes / capacity_seconds
+                      << ", \"write_seconds\": " << write_seconds
+                      << ", \"write_mb_per_second\": " << megabytes / write_seconds
+                      << ", \"write_bits_per_second\": " << bits / write_seconds
+                      << ", \"read_seconds\": " << read_seconds
+                      << ", \"read_mb_per_second\": " << document.size() / 1e6 / read_seconds
+                      << ", \"read_bits_per_second\": " << bits / read_seconds
+                      << ", \"peak_rss_kb\": " << peak_rss_kb()
+                      << "}" << std::endl;
+        } catch (const PdfError &e) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+    }
+    return 0;
+}
+
+struct PdfIDBenchmark {
+    const char *name;
+    int (*command)(const char *program_name, int argc, char *argv[]);
+    void (*help)(const char *program_name, std::ostream &o);
+};
+
+PdfIDBenchmark benchmarks[] = {
+    {
+        .name = "rank",
+        .command = bench_rank,
+        .help = bench_rank_help
+    },
+    {
+        .name = "input",
+        .command = bench_input,
+        .help = bench_input_help
+    },
+    {
+        .name = "load",
+        .command = bench_load,
+        .help = bench_load_help
+    },
+    {
+        .name = "names",
+        .command = bench_names,
+        .help = bench_names_help
+    },
+    {
+        .name = "tokenize",
+        .command = bench_tokenize,
+        .help = bench_tokenize_help
+    },
+    {
+        .name = "numbers",
+        .command = bench_numbers,
+        .help = bench_numbers_help
+    },
+    {
+        .name = "objects",
+        .command = bench_objects,
+        .help = bench_objects_help
+    },
+    {
+        .name = "objstm",
+        .command = bench_objstm,
+        .help = bench_objstm_help
+    },
+    {
+        .name = "compress",
+        .command = bench_compress,
+        .help = bench_compress_help
+    },
+    {
+        .name = "flate",
+        .command = bench_flate,
+        .help = bench_flate_help
+    },
+    {
+        .name = "bits",
+        .command = bench_bits,
+        .help = bench_bits_help
+    },
+    {
+        .name = "codec",
+        .command = bench_codec,
+        .help = bench_codec_help
+    },
+};
+
+void help(const char *program_name, std::ostream &o)
+{
+    for (const auto& benchmark : benchmarks)
+        benchmark.help(program_name, o);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        help(argv[0], std::cerr);
+        return 1;
+    }
+
+    const char *program_name = argv[0];
+    argc -= 1;
+    argv += 1;
+
+    for (const auto& benchmark : benchmarks)
+        if (strcmp(benchmark.name, argv[0]) == 0)
+            return benchmark.command(program_name, argc, argv);
+
+    help(program_name, std::cerr);
+    return 1;
+}
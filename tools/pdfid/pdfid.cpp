@@ -1,10 +1,20 @@
 #include <podofo-base.h>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <iostream>
+#include <iterator>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <cstdio>
 #include <cstring>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
 
 using namespace PoDoFo;
 
@@ -37,38 +47,105 @@ int open_input_file(std::ifstream &file, const char *path)
     }
 }
 
+// the whole input pdf, in memory
+struct PdfIDInput {
+    std::unique_ptr<PdfMappedInputDevice> mapping;
+    std::vector<char> data;
+
+    const char *buffer() const
+    {
+        return mapping ? mapping->GetBuffer() : data.data();
+    }
+
+    size_t size() const
+    {
+        return mapping ? mapping->GetLength() : data.size();
+    }
+};
+
+// regular files are mapped in memory, anything else (such as a pipe)
+// is read through a stream
+int open_input_pdf(PdfIDInput &input, const char *path)
+{
+    int rc;
+
+    struct stat st;
+    if (stat(path, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG) {
+        try {
+            input.mapping.reset(new PdfMappedInputDevice(path));
+            return 0;
+        } catch (const PdfError &) {
+            // some file systems can't map files
+        }
+    }
+
+    std::ifstream file;
+    if ((rc = open_input_file(file, path)))
+        return rc;
+    input.data.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+    return 0;
+}
+
+// parses the options in front of the arguments of read and write
+int parse_options(int &argc, char **&argv, PdfIdCodec &codec)
+{
+    while (argc >= 2 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-f") == 0) {
+            codec.SetFramed(true);
+            argc -= 1;
+            argv += 1;
+        } else if (strcmp(argv[1], "-u") == 0) {
+            codec.SetIncremental(true);
+            argc -= 1;
+            argv += 1;
+        } else if (strcmp(argv[1], "-j") == 0 && argc >= 3) {
+            char *end;
+            unsigned threads = strtoul(argv[2], &end, 10);
+            if (*end || !threads)
+                return 1;
+            codec.SetThreads(threads);
+            argc -= 2;
+            argv += 2;
+        } else
+            return 1;
+    }
+    return 0;
+}
+
 void pdfid_read_help(const char *program_name, std::ostream &o)
 {
     o << "Usage: " << program_name
-      << " read <input_pdf> [<output_data_file>]" << std::endl;
+      << " read [-f] [-u] [-j <threads>] <input_pdf> [<output_data_file>]" << std::endl;
 }
 
-int pdfid_read_stream(PdfParser &parser, std::ostream &output_data_stream, const char *input_filename)
+int pdfid_read_stream(const PdfIdCodec &codec, std::ostream &output_data_stream, const char *input_filename)
 {
     int rc;
 
-    bit_ostream o_bitstream(output_data_stream);
-
-    std::ifstream input_file_stream;
-    if ((rc = open_input_file(input_file_stream, input_filename)))
+    PdfIDInput input;
+    if ((rc = open_input_pdf(input, input_filename)))
         return rc;
 
-    PdfRefCountedInputDevice device(new PdfInputDevice(&input_file_stream));
-    device.Device()->dictdecode_stream = &o_bitstream;
     try {
-        parser.ParseFile(device, false);
+        codec.Decode(input.buffer(), input.size(), output_data_stream);
     } catch (const PdfError &e) {
         e.PrintErrorMsg();
         return 1;
     }
-    o_bitstream.flush();
     return 0;
 }
 
-int pdfid_read(PdfParser &parser, const char *program_name, int argc, char *argv[])
+int pdfid_read(const char *program_name, int argc, char *argv[])
 {
     int rc;
 
+    PdfIdCodec codec;
+    if (parse_options(argc, argv, codec)) {
+        pdfid_read_help(program_name, std::cerr);
+        return 1;
+    }
+
     if (argc != 2 && argc != 3) {
         pdfid_read_help(program_name, std::cerr);
         return 1;
@@ -79,73 +156,78 @@ int pdfid_read(PdfParser &parser, const char *program_name, int argc, char *argv
 
     // if there's no output file, write to stdout
     if (argc == 2)
-        return pdfid_read_stream(parser, std::cout, input_file);
+        return pdfid_read_stream(codec, std::cout, input_file);
 
     std::ofstream output_data_stream;
     if ((rc = open_output_file(output_data_stream, output_data_file)))
         return rc;
 
-    return pdfid_read_stream(parser, output_data_stream, input_file);
+    return pdfid_read_stream(codec, output_data_stream, input_file);
 }
 
 void pdfid_write_help(const char *program_name, std::ostream &o)
 {
     o << "Usage: " << program_name
-      << " write <input_pdf> <output_pdf> [<input_data>]" << std::endl;
+      << " write [-f] [-u] [-j <threads>] <input_pdf> <output_pdf> [<input_data>]" << std::endl;
 }
 
-int pdfid_write_stream(PdfParser &parser, std::istream &input_data_stream, const char *input_pdf_path, const char *output_pdf_path)
+int pdfid_write_stream(const PdfIdCodec &codec, std::istream &input_data_stream, const char *input_pdf_path, const char *output_pdf_path)
 {
     int rc;
 
     // open the input pdf file
-    std::ifstream input_file_stream;
-    if ((rc = open_input_file(input_file_stream, input_pdf_path)))
+    PdfIDInput input;
+    if ((rc = open_input_pdf(input, input_pdf_path)))
         return rc;
 
-    // setup the input device
-    PdfRefCountedInputDevice input_device(new PdfInputDevice(&input_file_stream));
-
-    // read the file
-    try {
-        parser.ParseFile(input_device, false);
-    } catch (const PdfError &e) {
-        e.PrintErrorMsg();
-        return 1;
-    }
-
-    // setup the output parser
-    PdfWriter writer(&parser);
-    writer.SetWriteMode(ePdfWriteMode_Compact);
-    writer.SetPdfVersion(ePdfVersion_1_6);
+    std::string payload((std::istreambuf_iterator<char>(input_data_stream)),
+                        std::istreambuf_iterator<char>());
 
     // setup the output device
     std::ofstream output_pdf_stream;
     if ((rc = open_output_file(output_pdf_stream, output_pdf_path)))
         return rc;
-    bit_istream i_bitstream(&input_data_stream);
     PdfOutputDevice device(&output_pdf_stream);
-    device.dictencode_stream = &i_bitstream;
 
     // write the pdf file
-    writer.Write(&device);
+    size_t capacity;
+    try {
+        capacity = codec.Encode(input.buffer(), input.size(), payload.data(), payload.size(), &device);
+    } catch (const PdfError &e) {
+        output_pdf_stream.close();
+        remove(output_pdf_path);
+
+        // a framed payload which does not fit whole is not written at all
+        if (codec.IsFramed() && e.GetError() == ePdfError_ValueOutOfRange)
+            capacity = codec.GetCapacity(input.buffer(), input.size());
+        if (!codec.IsFramed() || e.GetError() != ePdfError_ValueOutOfRange || payload.size() <= capacity) {
+            e.PrintErrorMsg();
+            return 1;
+        }
+    }
 
-    // if all input data was consumed, the write succeeded
-    if (i_bitstream.eof())
+    // if all input data fit, the write succeeded
+    if (payload.size() <= capacity)
         return 0;
 
     std::cerr << "The PDF file doesn't have sufficient capacity to "
         "hold all given data." << std::endl;
     std::cerr << "The file can hold at most " <<
-        i_bitstream.bit_size / 8 << " hidden bytes " << std::endl;
+        capacity << " hidden bytes " << std::endl;
     return 2;
 }
 
 
-int pdfid_write(PdfParser &parser, const char *program_name, int argc, char *argv[])
+int pdfid_write(const char *program_name, int argc, char *argv[])
 {
     int rc;
 
+    PdfIdCodec codec;
+    if (parse_options(argc, argv, codec)) {
+        pdfid_write_help(program_name, std::cerr);
+        return 1;
+    }
+
     if (argc != 3 && argc != 4) {
         pdfid_write_help(program_name, std::cerr);
         return 1;
@@ -156,64 +238,286 @@ int pdfid_write(PdfParser &parser, const char *program_name, int argc, char *arg
     const char *input_data_path = argv[3];
 
     if (argc == 3)
-        return pdfid_write_stream(parser, std::cin, input_pdf_path, output_pdf_path);
+        return pdfid_write_stream(codec, std::cin, input_pdf_path, output_pdf_path);
 
     // setup the input data stream
     std::ifstream input_data_stream;
     if ((rc = open_input_file(input_data_stream, input_data_path)))
         return rc;
 
-    return pdfid_write_stream(parser, input_data_stream, input_pdf_path, output_pdf_path);
+    return pdfid_write_stream(codec, input_data_stream, input_pdf_path, output_pdf_path);
 }
 
 void pdfid_capacity_help(const char *program_name, std::ostream &o)
 {
-    o << "Usage: " << program_name << " capacity <input_pdf>" << std::endl;
+    o << "Usage: " << program_name << " capacity [-u] [--report=json] <input_pdf>" << std::endl;
 }
 
-int pdfid_capacity(PdfParser &parser, const char *program_name, int argc, char *argv[])
+// writes a string as a JSON string literal
+static void write_json_string(std::ostream &o, const std::string &str)
+{
+    o << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            o << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            o << escape;
+        } else
+            o << c;
+    }
+    o << '"';
+}
+
+// the whole report, as a single JSON object
+static void write_capacity_report(std::ostream &o, const char *path, size_t size,
+                                  const PdfIdCapacityReport &report)
+{
+    const PdfDictEncodeReport &dicts = report.dictionaries;
+
+    o << "{\"file\": ";
+    write_json_string(o, path);
+    o << ", \"bytes\": " << size
+      << ", \"capacity_bytes\": " << report.capacity
+      << ", \"capacity_bits\": " << report.capacityBits
+      << ", \"rewritten_bytes\": " << report.rewrittenBytes
+      << ", \"floor_loss_bits\": " << dicts.floorLossBits
+      << ", \"trailer_bits\": " << dicts.trailerBits
+      << ", \"seconds\": {\"parse\": " << report.parseSeconds
+      << ", \"select\": " << report.selectSeconds
+      << ", \"count\": " << report.countSeconds << "}";
+
+    // only the key counts some dictionary has
+    o << ", \"key_counts\": {";
+    const char *separator = "";
+    for (size_t keys = 0; keys < dicts.keyCounts.size(); keys++) {
+        if (!dicts.keyCounts[keys])
+            continue;
+        o << separator << "\"" << keys << "\": " << dicts.keyCounts[keys];
+        separator = ", ";
+    }
+
+    o << "}, \"objects\": [";
+    separator = "";
+    for (const auto &object : dicts.objects) {
+        o << separator << "{\"object\": " << object.reference.ObjectNumber()
+          << ", \"generation\": " << object.reference.GenerationNumber()
+          << ", \"bits\": " << object.bits << "}";
+        separator = ", ";
+    }
+    o << "]}" << std::endl;
+}
+
+int pdfid_capacity(const char *program_name, int argc, char *argv[])
 {
     int rc;
 
+    PdfIdCodec codec;
+    bool report = false;
+    while (argc >= 2 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-u") == 0)
+            codec.SetIncremental(true);
+        else if (strcmp(argv[1], "--report=json") == 0)
+            report = true;
+        else {
+            pdfid_capacity_help(program_name, std::cerr);
+            return 1;
+        }
+        argc -= 1;
+        argv += 1;
+    }
+
     if (argc != 2) {
         pdfid_capacity_help(program_name, std::cerr);
         return 1;
     }
 
-    std::ifstream input_file_stream;
-    if ((rc = open_input_file(input_file_stream, argv[1])))
+    PdfIDInput input;
+    if ((rc = open_input_pdf(input, argv[1])))
         return rc;
 
-    PdfRefCountedInputDevice input_device(new PdfInputDevice(&input_file_stream));
+    // count the bytes the writer would hide, without writing anything.
+    // the capacity is displayed in bytes, as the API doesn't have a
+    // bit-level granularity anyway
+    size_t capacity;
+    PdfIdCapacityReport capacity_report;
     try {
-        parser.ParseFile(input_device, false);
+        if (report)
+            capacity = codec.GetCapacity(input.buffer(), input.size(), capacity_report);
+        else
+            capacity = codec.GetCapacity(input.buffer(), input.size());
     } catch (const PdfError &e) {
         e.PrintErrorMsg();
         return 1;
     }
 
-    // setup the output parser
-    PdfWriter writer(&parser);
-    writer.SetWriteMode(ePdfWriteMode_Compact);
-    writer.SetPdfVersion(ePdfVersion_1_6);
+    if (report)
+        write_capacity_report(std::cout, argv[1], input.size(), capacity_report);
+    else
+        std::cout << capacity << std::endl;
+    return 0;
+}
 
-    // setup the output device
-    bit_istream i_bitstream(nullptr);
-    PdfOutputDevice output_device;
-    output_device.dictencode_stream = &i_bitstream;
+void pdfid_batch_help(const char *program_name, std::ostream &o)
+{
+    o << "Usage: " << program_name
+      << " batch [-j <workers>] <manifest>" << std::endl;
+}
 
-    // write the pdf file
-    writer.Write(&output_device);
+// a manifest line, either
+//   read <input_pdf> <output_data_file>
+//   write <input_pdf> <output_pdf> <input_data>
+struct PdfIDJob {
+    std::string line;
+    std::vector<std::string> args;
+    int (*command)(const char *program_name, int argc, char *argv[]);
+    long input_size;
+};
 
-    // the capacity should be displayed in bytes, as the API doesn't
-    // have a bit-level granualarity anyway
-    std::cout << i_bitstream.bit_size / 8 << std::endl;
+int pdfid_batch_parse(std::istream &manifest, std::vector<PdfIDJob> &jobs)
+{
+    std::string line;
+    for (size_t line_number = 1; std::getline(manifest, line); line_number++)
+    {
+        PdfIDJob job;
+        std::istringstream line_stream(line);
+        std::string arg;
+        while (line_stream >> arg)
+            job.args.push_back(arg);
+
+        // skip blank lines and comments
+        if (job.args.empty() || job.args[0][0] == '#')
+            continue;
+
+        // the worker pool replaces -j, but payloads may be framed
+        // or written as incremental updates
+        size_t first = 1;
+        while (first < job.args.size() && (job.args[first] == "-f" || job.args[first] == "-u"))
+            first++;
+
+        if (job.args[0] == "read" && job.args.size() - first == 2)
+            job.command = pdfid_read;
+        else if (job.args[0] == "write" && job.args.size() - first == 3)
+            job.command = pdfid_write;
+        else {
+            std::cerr << "invalid job on line " << line_number
+                      << ": `" << line << "'" << std::endl;
+            return 1;
+        }
+
+        // only used to report the throughput
+        std::ifstream input_file(job.args[first], std::ifstream::ate);
+        job.input_size = input_file ? static_cast<long>(input_file.tellg()) : 0;
+
+        job.line = line;
+        jobs.push_back(std::move(job));
+    }
     return 0;
 }
 
+int pdfid_batch_run(PdfIDJob &job, const char *program_name)
+{
+    std::vector<char *> argv;
+    for (auto &arg : job.args)
+        argv.push_back(&arg[0]);
+    argv.push_back(NULL);
+
+    // each job gets its own codec, nothing is shared between workers
+    try {
+        return job.command(program_name, static_cast<int>(job.args.size()), argv.data());
+    } catch (const PdfError &e) {
+        e.PrintErrorMsg();
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 1;
+}
+
+int pdfid_batch(const char *program_name, int argc, char *argv[])
+{
+    int rc;
+
+    unsigned workers = std::thread::hardware_concurrency();
+    if (argc == 4 && strcmp(argv[1], "-j") == 0) {
+        char *end;
+        workers = strtoul(argv[2], &end, 10);
+        if (*end || !workers) {
+            pdfid_batch_help(program_name, std::cerr);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc != 2) {
+        pdfid_batch_help(program_name, std::cerr);
+        return 1;
+    }
+
+#ifndef PODOFO_MULTI_THREAD
+    // without it, the library doesn't lock its global state
+    workers = 1;
+#endif
+    if (!workers)
+        workers = 1;
+
+    std::ifstream manifest;
+    if ((rc = open_input_file(manifest, argv[1])))
+        return rc;
+
+    std::vector<PdfIDJob> jobs;
+    if ((rc = pdfid_batch_parse(manifest, jobs)))
+        return rc;
+
+    // workers pick the next job until there are none left
+    std::atomic<size_t> next_job(0);
+    std::atomic<size_t> failed_jobs(0);
+    std::atomic<long> processed_size(0);
+    std::mutex report_mutex;
+
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_job++) < jobs.size())
+        {
+            auto job_start = std::chrono::steady_clock::now();
+            int job_rc = pdfid_batch_run(jobs[i], program_name);
+            std::chrono::duration<double> job_time = std::chrono::steady_clock::now() - job_start;
+
+            if (job_rc)
+                failed_jobs++;
+            else
+                processed_size += jobs[i].input_size;
+
+            std::lock_guard<std::mutex> lock(report_mutex);
+            std::cout << (job_rc ? "failed" : "ok") << '\t'
+                      << job_time.count() << '\t'
+                      << jobs[i].line << std::endl;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < workers && i < jobs.size(); i++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+
+    std::chrono::duration<double> total_time = std::chrono::steady_clock::now() - start;
+    double megabytes = processed_size / 1e6;
+    std::cout << jobs.size() << " jobs, "
+              << failed_jobs << " failed, "
+              << megabytes << " MB in "
+              << total_time.count() << " s ("
+              << (total_time.count() > 0 ? megabytes / total_time.count() : 0)
+              << " MB/s)" << std::endl;
+    return failed_jobs ? 1 : 0;
+}
+
 struct PdfIDSubcommand {
     const char *name;
-    int (*command)(PdfParser &parser, const char *program_name, int argc, char *argv[]);
+    int (*command)(const char *program_name, int argc, char *argv[]);
     void (*help)(const char *program_name, std::ostream &o);
 };
 
@@ -233,6 +537,11 @@ PdfIDSubcommand subcommands[] = {
         .command = pdfid_capacity,
         .help = pdfid_capacity_help
     },
+    {
+        .name = "batch",
+        .command = pdfid_batch,
+        .help = pdfid_batch_help
+    },
 };
 
 void help(const char *program_name, std::ostream &o)
@@ -246,11 +555,6 @@ int main(int argc, char* argv[])
     PdfError::EnableLogging(true);
     PdfError::EnableDebug(true);
 
-    PdfVecObjects objects;
-    PdfParser parser(&objects);
-    parser.SetStrictParsing(false);
-    objects.SetAutoDelete(true);
-
     if (argc < 2) {
         help(argv[0], std::cerr);
         return 1;
@@ -262,7 +566,7 @@ int main(int argc, char* argv[])
     const char *subcommand_name = argv[0];
     for (const auto& subcommand : subcommands)
         if (strcmp(subcommand.name, subcommand_name) == 0)
-            return subcommand.command(parser, argv[0], argc, argv);
+            return subcommand.command(argv[0], argc, argv);
 
     help(argv[0], std::cerr);
     return 1;